@@ -30,11 +30,24 @@ consuming_entropy_coders = [
     AlgorithmConfig(name="SLECoder", header="coders/SLECoder.hpp"),
 ]
 
+# Entropy coders that code all literals given by the literal iterator in
+# advance, which must then be encoded in exactly that order
+preceding_entropy_coders = [
+    AlgorithmConfig(name="HuffmanStreamsCoder", header="coders/HuffmanCoder.hpp"),
+    AlgorithmConfig(name="TANSCoder", header="coders/TANSCoder.hpp"),
+]
+
+# Entropy coders that buffer all values and write them when destroyed, which
+# requires them to be the only coder writing to the output
+buffering_entropy_coders = [
+    AlgorithmConfig(name="RANSCoder", header="coders/RANSCoder.hpp"),
+]
+
 # All non-consuming coders
 non_consuming_coders = universal_coders + entropy_coders
 
 # All coders
-all_coders = universal_coders + entropy_coders + consuming_entropy_coders
+all_coders = universal_coders + entropy_coders + consuming_entropy_coders + preceding_entropy_coders + buffering_entropy_coders
 
 ##### Text data structures #####
 
@@ -43,6 +56,14 @@ sa = [
     AlgorithmConfig(name="SADivSufSort", header="ds/SADivSufSort.hpp"),
 ]
 
+# Alternative Suffix Arrays, which are not combined with the compressed LCP
+# Array and the sparse ISA, as these require the same Suffix Array as the TextDS
+sa_alternatives = [
+    AlgorithmConfig(name="SAPrefixDoubling", header="ds/SAPrefixDoubling.hpp"),
+    AlgorithmConfig(name="SAInducedSorting", header="ds/SAInducedSorting.hpp"),
+    AlgorithmConfig(name="SASemiExternal", header="ds/SASemiExternal.hpp"),
+]
+
 # Phi Array
 phi = [
     AlgorithmConfig(name="PhiFromSA", header="ds/PhiFromSA.hpp"),
@@ -63,15 +84,20 @@ lcp = lcp_uncompressed + [
     AlgorithmConfig(name="CompressedLCP", header="ds/CompressedLCP.hpp", sub=[sa]),
 ]
 
-# Inverse Suffix Array
-isa = [
+# Uncompressed Inverse Suffix Array
+isa_uncompressed = [
     AlgorithmConfig(name="ISAFromSA", header="ds/ISAFromSA.hpp"),
+]
+
+# All Inverse Suffix Arrays
+isa = isa_uncompressed + [
     AlgorithmConfig(name="SparseISA", header="ds/SparseISA.hpp", sub=[sa]),
 ]
 
 # TextDS
 textds = [
     AlgorithmConfig(name="TextDS", header="ds/TextDS.hpp", sub=[sa, phi, plcp, lcp, isa]),
+    AlgorithmConfig(name="TextDS", header="ds/TextDS.hpp", sub=[sa_alternatives, phi, plcp, lcp_uncompressed, isa_uncompressed]),
 ]
 
 ##### lz78 #####
@@ -139,6 +165,9 @@ lcpcomp_coders = [
     AlgorithmConfig(name="ASCIICoder", header="coders/ASCIICoder.hpp"),
     AlgorithmConfig(name="SLECoder", header="coders/SLECoder.hpp"),
     AlgorithmConfig(name="HuffmanCoder", header="coders/HuffmanCoder.hpp"),
+    AlgorithmConfig(name="HuffmanStreamsCoder", header="coders/HuffmanCoder.hpp"),
+    AlgorithmConfig(name="TANSCoder", header="coders/TANSCoder.hpp"),
+    AlgorithmConfig(name="RANSCoder", header="coders/RANSCoder.hpp"),
 ]
 
 # lcpcomp factorization strategies ("comp")
@@ -166,6 +195,7 @@ lcpcomp_dec = [
 # Allowed TextDS instances for lcpcomp (LCP array must be writable!)
 lcpcomp_textds = [
     AlgorithmConfig(name="TextDS", header="ds/TextDS.hpp", sub=[sa, phi, plcp, lcp_uncompressed, isa]),
+    AlgorithmConfig(name="TextDS", header="ds/TextDS.hpp", sub=[sa_alternatives, phi, plcp, lcp_uncompressed, isa_uncompressed]),
 ]
 
 ##### ESP grammar compressor WIP #####
@@ -232,12 +262,13 @@ tdc.compressors = [
     AlgorithmConfig(name="LZ78Compressor", header="compressors/LZ78Compressor.hpp", sub=[universal_coders, lz78_trie]),
     AlgorithmConfig(name="LZWCompressor", header="compressors/LZWCompressor.hpp", sub=[universal_coders, lz78_trie]),
     AlgorithmConfig(name="RePairCompressor", header="compressors/RePairCompressor.hpp", sub=[non_consuming_coders]),
-    AlgorithmConfig(name="LZSSLCPCompressor", header="compressors/LZSSLCPCompressor.hpp", sub=[non_consuming_coders, textds]),
+    AlgorithmConfig(name="LZSSLCPCompressor", header="compressors/LZSSLCPCompressor.hpp", sub=[non_consuming_coders + preceding_entropy_coders + buffering_entropy_coders, textds]),
     AlgorithmConfig(name="LZSSSlidingWindowCompressor", header="compressors/LZSSSlidingWindowCompressor.hpp", sub=[universal_coders]),
     AlgorithmConfig(name="MTFCompressor", header="compressors/MTFCompressor.hpp"),
     AlgorithmConfig(name="NoopCompressor", header="compressors/NoopCompressor.hpp"),
     AlgorithmConfig(name="BWTCompressor", header="compressors/BWTCompressor.hpp", sub=[textds]),
     AlgorithmConfig(name="ChainCompressor", header="../tudocomp_driver/ChainCompressor.hpp"),
+    AlgorithmConfig(name="BlockCompressor", header="../tudocomp_driver/BlockCompressor.hpp"),
     AlgorithmConfig(name="EspCompressor", header="compressors/EspCompressor.hpp", sub=[slp_coder, ipddyn]),
     AlgorithmConfig(name="lfs::LFSCompressor", header="compressors/lfs/LFSCompressor.hpp", sub=[lfs_strat, coding_strat]),
     AlgorithmConfig(name="lfs::LFS2Compressor", header="compressors/lfs/LFS2Compressor.hpp", sub=[lit_coder, len_coder]),
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <bitset>
+#include <memory>
 #include <numeric>
+#include <sstream>
+#include <vector>
 
 #include <tudocomp/Env.hpp>
 #include <tudocomp/Coder.hpp>
@@ -76,6 +79,65 @@ namespace huff {
         return map_from_effective;
     }
 
+    /**
+     * Computes optimal codeword lengths of at most max_length bits with the package-merge algorithm.
+     * Builds max_length lists of items, the first holding the characters sorted by their weights, and each
+     * following one the characters merged with the pairs (packages) of the items in the previous list.
+     * Each codeword length equals the number of times the character is contained in the 2n-2 lightest items of the last list.
+     * @param weights the weight of each character of the effective alphabet
+     * @param alphabet_size the size of the effective alphabet, at least two
+     * @param max_length the maximum codeword length, with 2^max_length >= alphabet_size
+     * @param codelengths the array to store the codeword lengths in
+     */
+    inline void limit_codelengths(const size_t*const weights, const size_t alphabet_size, const uint8_t max_length, uint8_t*const codelengths) {
+        DCHECK_GE(alphabet_size, 2);
+        DCHECK_LT(max_length, 64);
+        DCHECK_LE(alphabet_size, 1ULL << max_length);
+
+        std::vector<size_t> order(alphabet_size);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&] (const size_t a, const size_t b) { return weights[a] < weights[b]; });
+
+        // kind[l][k] is the rank of the character of item k in list l, or alphabet_size for a package
+        std::vector<std::vector<size_t>> kind(max_length);
+        std::vector<size_t> weight(order.size());
+        for(size_t i = 0; i < alphabet_size; ++i) {
+            kind[0].push_back(i);
+            weight[i] = weights[order[i]];
+        }
+
+        for(size_t l = 1; l < max_length; ++l) {
+            std::vector<size_t> merged;
+            size_t leaf = 0;
+            size_t package = 0;
+            while(leaf < alphabet_size || package + 1 < weight.size()) {
+                const bool take_leaf = package + 1 >= weight.size() ||
+                    (leaf < alphabet_size && weights[order[leaf]] <= weight[package] + weight[package + 1]);
+                if(take_leaf) {
+                    kind[l].push_back(leaf);
+                    merged.push_back(weights[order[leaf++]]);
+                } else {
+                    kind[l].push_back(alphabet_size);
+                    merged.push_back(weight[package] + weight[package + 1]);
+                    package += 2;
+                }
+            }
+            weight = std::move(merged);
+        }
+
+        std::memset(codelengths, 0, alphabet_size);
+        size_t count = 2 * alphabet_size - 2;
+        for(size_t l = max_length; l-- > 0;) {
+            DCHECK_LE(count, kind[l].size());
+            size_t packages = 0;
+            for(size_t k = 0; k < count; ++k) {
+                if(kind[l][k] == alphabet_size) ++packages;
+                else ++codelengths[order[kind[l][k]]];
+            }
+            count = 2 * packages;
+        }
+    }
+
     /**
      * Returns an array storing for each character of the effective alphabet the length of its codeword.
      * The array is sorted with respect to the rank of the alphabet character.
@@ -83,9 +145,10 @@ namespace huff {
      * @param C @see count_alphabet
      * @param map_from_effective maps from the effective alphabet to the full alphabet
      * @param alphabet_size the size of the effective alphabet
+     * @param max_length if non-zero, the codeword lengths are limited to this length (@see limit_codelengths)
      *
      **/
-    inline uint8_t* gen_codelengths(const len_compact_t*const C, const uliteral_t*const map_from_effective, const size_t alphabet_size) {
+    inline uint8_t* gen_codelengths(const len_compact_t*const C, const uliteral_t*const map_from_effective, const size_t alphabet_size, uint8_t max_length = 0) {
         size_t A[2*alphabet_size];
         for(size_t i=0; i < alphabet_size; i++) {
             DVLOG(2) << "Char " << map_from_effective[i] << " : " << size_t(C[map_from_effective[i]]);
@@ -140,6 +203,17 @@ namespace huff {
             DVLOG(2) << "Char " << map_from_effective[i] << " : " << codelengths[i];
         }
 
+        if(max_length > 0 && alphabet_size > 1) {
+            // the limit must leave room for all characters, and for the amount of codewords of a length to fit into a literal
+            max_length = std::max<uint8_t>(max_length, bits_for(alphabet_size));
+            if(*std::max_element(codelengths, codelengths+alphabet_size) > max_length) {
+                for(size_t i=0; i < alphabet_size; i++) {
+                    A[i] = C[map_from_effective[i]];
+                }
+                limit_codelengths(A, alphabet_size, max_length, codelengths);
+            }
+        }
+
         IF_PARANOID({
             // invariants
 
@@ -154,12 +228,12 @@ namespace huff {
                     }
                 }}
             { // check Kraft's equality
-                const size_t& max_el = *std::max_element(A+alphabet_size,A+2*alphabet_size);
+                const size_t max_el = *std::max_element(codelengths,codelengths+alphabet_size);
                 DCHECK_LT(max_el,63);
                 size_t sum = 0;
                 for (size_t i = 0; i < alphabet_size; ++i)
                 {
-                    sum += 2ULL<<(max_el - A[alphabet_size+i]);
+                    sum += 2ULL<<(max_el - codelengths[i]);
                 }
                 DCHECK_EQ(sum, 2ULL<<max_el);
             }
@@ -350,52 +424,125 @@ namespace huff {
 
 
     /**
-     * prefix_sum_lengths stores for each different codeword length the first entry of the codeword with this length in codewords
-     * Needed for decoding Huffman code
+     * Lookup tables for decoding canonical Huffman codes.
+     * The primary table is indexed by the next (at most) PRIMARY_BITS bits of the input. An entry either stores a character
+     * together with the length of its codeword, or links to a secondary table that is indexed by the bits following
+     * the ones of the primary table. Secondary tables link to further tables in the same way.
+     * Each entry is packed into 32 bits: the lowest bit tells whether it stores a character, the next five bits the amount
+     * of bits to consume or to index the linked table with, and the upper 24 bits the character or the offset of the linked table.
      */
-    inline std::unique_ptr<size_t[]> gen_prefix_sum_lengths(
-            const uint8_t*const ordered_codelengths,
-            const size_t alphabet_size,
-            const uint8_t longest) {
-            auto prefix_sum_lengths = std::make_unique<size_t[]>(longest);
-#ifndef NDDEBUG
-            std::fill(
-                prefix_sum_lengths.get(),
-                prefix_sum_lengths.get() + longest,
-                std::numeric_limits<size_t>::max()
-            );
-#endif
-            prefix_sum_lengths[ordered_codelengths[0]-1] = 0;
-            for(size_t i = 1; i < alphabet_size; ++i) {
-                if(ordered_codelengths[i-1] < ordered_codelengths[i])
-                    prefix_sum_lengths[ordered_codelengths[i]-1] = i;
+    class DecodeTable {
+        static constexpr size_t PRIMARY_BITS = 11;
+        static constexpr size_t SECONDARY_BITS = 8;
+
+        std::vector<uint32_t> m_entries;
+        size_t m_primary_bits;
+
+        inline static uint32_t leaf(uliteral_t c, size_t bits) {
+            return (uint32_t(c) << 8) | (uint32_t(bits) << 1) | 1;
+        }
+
+        inline static uint32_t link(size_t offset, size_t bits) {
+            DCHECK_LT(offset, 1ULL << 24);
+            return (uint32_t(offset) << 8) | (uint32_t(bits) << 1);
+        }
+
+        /// Fills the table of 2^bits entries at offset, for the given codewords, whose first depth bits have been consumed
+        inline void build(
+                const size_t offset, const size_t bits, const size_t depth,
+                const std::vector<size_t>& members,
+                const size_t*const codewords,
+                const uint8_t*const ordered_codelengths,
+                const uliteral_t*const ordered_map_from_effective) {
+            std::vector<std::vector<size_t>> groups;
+            for(const size_t i : members) {
+                const size_t l = ordered_codelengths[i] - depth;
+                const size_t rest = codewords[i] & ((1ULL << l) - 1);
+                if(l <= bits) {
+                    const size_t first = rest << (bits - l);
+                    std::fill(m_entries.begin() + offset + first,
+                              m_entries.begin() + offset + first + (1ULL << (bits - l)),
+                              leaf(ordered_map_from_effective[i], l));
+                } else {
+                    const size_t q = rest >> (l - bits);
+                    if(groups.empty()) groups.resize(1ULL << bits);
+                    groups[q].push_back(i);
+                }
             }
-            DVLOG(2) << "ordered_codelengths : " << arr_to_debug_string(ordered_codelengths, alphabet_size);
-            DVLOG(2) << "prefix_sum_lengths : " << arr_to_debug_string(prefix_sum_lengths.get(), longest);
-            return prefix_sum_lengths;
-    }
-    inline uliteral_t huffman_decode(
-            tdc::io::BitIStream& is,
-            const uliteral_t*const ordered_map_from_effective,
-            const size_t*const prefix_sum_lengths,
-            const size_t*const firstcodes
-            ) {
-        DCHECK(!is.eof());
-        size_t value = 0;
-        uint8_t length = 0;
-        do {
-            DCHECK(!is.eof());
-            value = (value<<1) + is.read_bit();
-            ++length;
-        } while(value < firstcodes[length-1]);
-        DVLOG(2) << " codeword " << value << " length " << length;
-        --length;
-//      DCHECK_LT(prefix_sum_lengths[length]+ (value - firstcodes[length]), alphabet_size);
-        return ordered_map_from_effective[prefix_sum_lengths[length]+ (value - firstcodes[length]) ];
 
+            for(size_t q = 0; q < groups.size(); ++q) {
+                if(groups[q].empty()) continue;
+                size_t longest = 0;
+                for(const size_t i : groups[q]) longest = std::max<size_t>(longest, ordered_codelengths[i]);
+
+                const size_t sub_bits = std::min(longest - depth - bits, size_t(SECONDARY_BITS));
+                const size_t sub_offset = m_entries.size();
+                m_entries.resize(sub_offset + (1ULL << sub_bits), leaf(0, 0));
+                m_entries[offset + q] = link(sub_offset, sub_bits);
+                build(sub_offset, sub_bits, depth + bits, groups[q],
+                      codewords, ordered_codelengths, ordered_map_from_effective);
+            }
+        }
 
-    }
+    public:
+        inline DecodeTable() : m_primary_bits(0) {
+        }
+
+        inline DecodeTable(
+                const uliteral_t*const ordered_map_from_effective,
+                const uint8_t*const ordered_codelengths,
+                const size_t alphabet_size,
+                const uliteral_t*const numl,
+                const uint8_t longest) {
+            const size_t*const codewords = gen_codewords(ordered_codelengths, alphabet_size, numl, longest);
+
+            m_primary_bits = std::min<size_t>(longest, size_t(PRIMARY_BITS));
+            m_entries.resize(1ULL << m_primary_bits, leaf(0, 0));
 
+            std::vector<size_t> members(alphabet_size);
+            std::iota(members.begin(), members.end(), 0);
+            build(0, m_primary_bits, 0, members, codewords, ordered_codelengths, ordered_map_from_effective);
+
+            delete [] codewords;
+        }
+
+        /** Decodes the character whose codeword is stored in the most significant bits of word, and sets length to the length of the codeword */
+        inline uliteral_t decode(uint64_t word, size_t& length) const {
+            const uint32_t* table = m_entries.data();
+            size_t bits = m_primary_bits;
+            length = 0;
+            while(true) {
+                const uint32_t entry = table[word >> (64 - bits)];
+                const size_t entry_bits = (entry >> 1) & 0x1F;
+                if(entry & 1) {
+                    length += entry_bits;
+                    return uliteral_t(entry >> 8);
+                }
+                length += bits;
+                word <<= bits;
+                table = m_entries.data() + (entry >> 8);
+                bits = entry_bits;
+            }
+        }
+
+        /** Decodes a single character */
+        inline uliteral_t decode(tdc::io::BitIStream& is) const {
+            DCHECK(!is.eof());
+            const uint32_t* table = m_entries.data();
+            size_t bits = m_primary_bits;
+            while(true) {
+                const uint32_t entry = table[is.peek(bits)];
+                const size_t entry_bits = (entry >> 1) & 0x1F;
+                if(entry & 1) {
+                    is.consume(entry_bits);
+                    return uliteral_t(entry >> 8);
+                }
+                is.consume(bits);
+                table = m_entries.data() + (entry >> 8);
+                bits = entry_bits;
+            }
+        }
+    };
 
     inline void huffman_decode(
             tdc::io::BitIStream& is,
@@ -406,19 +553,137 @@ namespace huff {
             const uliteral_t*const numl,
             const uint8_t longest) {
 
-            std::unique_ptr<size_t const[]> const prefix_sum_lengths { gen_prefix_sum_lengths(ordered_codelengths, alphabet_size, longest) };
+            const DecodeTable table(ordered_map_from_effective, ordered_codelengths, alphabet_size, numl, longest);
 
             const size_t text_length = is.read_compressed_int<size_t>();
             DCHECK_GT(text_length, 0);
-            const size_t*const firstcodes = gen_first_codes(numl, longest);
-            DVLOG(2) << "firstcodes : " << arr_to_debug_string(firstcodes, longest);
-            size_t num_chars_read = 0;
-            while(true) {
-                output << huffman_decode(is, ordered_map_from_effective, prefix_sum_lengths.get(), firstcodes);
-                ++num_chars_read;
-                if(num_chars_read == text_length) break;
+            for(size_t i = 0; i < text_length; ++i) {
+                output << table.decode(is);
+            }
+    }
+
+    /**
+     * Encodes a sequence of characters into interleaved bitstreams, the i-th character being encoded into stream i mod streams.
+     * The output starts with the number of characters and the byte length of each stream (the jump table), followed by the bytes of all streams.
+     * Each stream stores its codewords in MSB first order, padded with zeros to a full byte.
+     * @param input the characters, each of which must be in the effective alphabet of the table
+     */
+    template<class T>
+    inline void huffman_encode_streams(
+            const T& input,
+            tdc::io::BitOStream& os,
+            const extended_huffmantable& table,
+            const size_t streams) {
+        DCHECK_GT(streams, 0);
+        DCHECK_LE(table.longest, 56);
+        const uint8_t*const ordered_map_to_effective { gen_ordered_map_to_effective(table.ordered_map_from_effective, table.alphabet_size) };
+
+        std::vector<std::vector<uint8_t>> buffers(streams);
+        for(size_t s = 0; s < streams; ++s) {
+            uint64_t acc = 0;
+            size_t acc_bits = 0;
+            for(size_t i = s; i < input.size(); i += streams) {
+                const uint8_t effective_char = ordered_map_to_effective[static_cast<uliteral_t>(input[i])];
+                DCHECK_LT(effective_char, table.alphabet_size);
+                const size_t length = table.ordered_codelengths[effective_char];
+                acc = (acc << length) | table.codewords[effective_char];
+                acc_bits += length;
+                while(acc_bits >= 8) {
+                    acc_bits -= 8;
+                    buffers[s].push_back(uint8_t(acc >> acc_bits));
+                }
             }
-            delete [] firstcodes;
+            if(acc_bits > 0) buffers[s].push_back(uint8_t(acc << (8 - acc_bits)));
+        }
+        delete [] ordered_map_to_effective;
+
+        os.write_compressed_int<size_t>(input.size());
+        for(const auto& buffer : buffers) {
+            os.write_compressed_int<size_t>(buffer.size());
+        }
+        for(const auto& buffer : buffers) {
+            os.write_bytes(buffer.data(), buffer.size());
+        }
+    }
+
+    /**
+     * Reads the bits of a byte array in MSB first order, one stream of huffman_encode_streams.
+     * The next bits are held in a left-aligned 64-bit accumulator, which is refilled without branches,
+     * for which the array must be followed by PADDING readable bytes:
+     * after the last bits of the array were loaded, the read position may be up to seven bytes past its end,
+     * from where the next refill still loads a whole word.
+     */
+    class StreamReader {
+        const uint8_t* m_pos;
+        uint64_t m_acc;
+        size_t m_acc_bits;
+    public:
+        /** The amount of readable bytes required after the array */
+        static constexpr size_t PADDING = 16;
+
+        inline StreamReader(const uint8_t*const data) : m_pos(data), m_acc(0), m_acc_bits(0) {
+        }
+
+        /** Decodes a single character */
+        inline uliteral_t decode(const DecodeTable& table) {
+            // load as many whole bytes as fit, leaving at least 56 bits in the accumulator
+            uint64_t word;
+            std::memcpy(&word, m_pos, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            word = __builtin_bswap64(word);
+#endif
+            m_acc |= word >> m_acc_bits;
+            m_pos += (63 - m_acc_bits) >> 3;
+            m_acc_bits |= 56;
+
+            size_t length;
+            const uliteral_t c = table.decode(m_acc, length);
+            m_acc <<= length;
+            m_acc_bits -= length;
+            return c;
+        }
+    };
+
+    /**
+     * Decodes the characters written by huffman_encode_streams.
+     * The streams are decoded in lockstep, such that the decoding of a character does not depend on the one decoded before.
+     */
+    inline std::vector<uliteral_t> huffman_decode_streams(
+            tdc::io::BitIStream& is,
+            const DecodeTable& table,
+            const size_t streams) {
+        DCHECK_GT(streams, 0);
+        const size_t length = is.read_compressed_int<size_t>();
+
+        std::vector<size_t> sizes(streams);
+        size_t total = 0;
+        for(auto& size : sizes) {
+            size = is.read_compressed_int<size_t>();
+            total += size;
+        }
+
+        // all streams in one array, followed by padding for the readers
+        std::vector<uint8_t> data(total + StreamReader::PADDING, 0);
+        std::vector<StreamReader> readers;
+        readers.reserve(streams);
+        size_t offset = 0;
+        for(const size_t size : sizes) {
+            readers.emplace_back(data.data() + offset);
+            is.read_bytes(data.data() + offset, size);
+            offset += size;
+        }
+
+        std::vector<uliteral_t> output(length);
+        size_t i = 0;
+        for(; i + streams <= length; i += streams) {
+            for(size_t s = 0; s < streams; ++s) {
+                output[i + s] = readers[s].decode(table);
+            }
+        }
+        for(size_t s = 0; i < length; ++i, ++s) {
+            output[i] = readers[s].decode(table);
+        }
+        return output;
     }
 
     /** Computes the lengths of all codewords of the Huffman code. Needed to decode a Huffman-encoded text.
@@ -438,15 +703,16 @@ namespace huff {
      * @param C @see count_alphabet
      * @attention Deletes the input array C!
      * @attention C must contain at least two non-zero values
+     * @param max_length if non-zero, the maximum codeword length (@see gen_codelengths)
      */
-    inline extended_huffmantable gen_huffmantable(const len_compact_t*const C) {
+    inline extended_huffmantable gen_huffmantable(const len_compact_t*const C, const uint8_t max_length = 0) {
         const size_t alphabet_size = effective_alphabet_size(C);
         DCHECK_GT(alphabet_size,0);
 
         // mapFromEffective : rank of an effective alphabet character -> input alphabet (char-range)
         const uliteral_t*const mapFromEffective = gen_effective_alphabet(C, alphabet_size);
 
-        const uint8_t*const codelengths = gen_codelengths(C, mapFromEffective, alphabet_size);
+        const uint8_t*const codelengths = gen_codelengths(C, mapFromEffective, alphabet_size, max_length);
         delete [] C;
 
         // codeword_order is a permutation (like suffix array) sorting (code_length, mapFromEffective) by code_length ascendingly (instead of mapFromEffective values)
@@ -473,9 +739,9 @@ namespace huff {
         return { ordered_map_from_effective, codewords, ordered_codelengths, alphabet_size, numl, longest };
     }
 
-    inline extended_huffmantable gen_huffmantable(const std::string& text) {
+    inline extended_huffmantable gen_huffmantable(const std::string& text, const uint8_t max_length = 0) {
         const len_compact_t*const C { count_alphabet(text) };
-        return gen_huffmantable(C);
+        return gen_huffmantable(C, max_length);
     }
 
     inline void encode(tdc::io::Input& input, tdc::io::Output& output) {
@@ -506,112 +772,154 @@ namespace huff {
         delete [] ordered_codelengths;
     }
 
-}//ns
-/// \endcond
-
-class HuffmanCoder : public Algorithm {
-public:
-    inline static Meta meta() {
-        Meta m("coder", "huff", "Canonical Huffman Coder");
-        return m;
-    }
-
-    HuffmanCoder() = delete;
-
-    class Encoder : public tdc::Encoder {
-    const huff::extended_huffmantable m_table;
-    const uint8_t*const ordered_map_to_effective;
+    /**
+     * The canonical Huffman coder, see HuffmanCoder and HuffmanStreamsCoder.
+     * @tparam m_interleaved whether the literals are coded in advance into interleaved streams
+     */
+    template<bool m_interleaved>
+    class Coder : public Algorithm {
     public:
-        template<typename literals_t>
-        inline Encoder(Env&& env, std::shared_ptr<BitOStream> out, literals_t&& literals)
-            : tdc::Encoder(std::move(env), out, literals),
-            m_table{ [&] () {
-                if(tdc_likely(!literals.has_next())) return huff::extended_huffmantable { nullptr, nullptr, nullptr, 0, nullptr, 0 };
-                const len_compact_t*const C = huff::count_alphabet_literals(std::move(literals));
-                const len_t alphabet_size = huff::effective_alphabet_size(C);
-                if(tdc_unlikely(alphabet_size == 1)) {
-                    delete [] C;
-                    return huff::extended_huffmantable { nullptr, nullptr, nullptr, 1, nullptr, 0 };
-                }
-                return huff::gen_huffmantable(C);
-            }() }
-            , ordered_map_to_effective { m_table.codewords == nullptr ? nullptr : huff::gen_ordered_map_to_effective(m_table.ordered_map_from_effective, m_table.alphabet_size) }
-        {
-            if(tdc_unlikely(m_table.alphabet_size <= 1)) {
-                m_out->write_bit(0);
-            }
-            else {
-                m_out->write_bit(1);
-                huff::huffmantable_encode(*m_out, m_table);
+        inline static Meta meta() {
+            Meta m("coder", m_interleaved ? "huff_streams" : "huff", m_interleaved
+                ? "Canonical Huffman Coder with literals coded in advance into interleaved streams"
+                : "Canonical Huffman Coder");
+            m.option("max_length").dynamic(0); // 0 for unlimited
+            if(m_interleaved) {
+                m.option("streams").dynamic(4);
             }
+            return m;
         }
 
-        ~Encoder() {
-            if(tdc_likely(ordered_map_to_effective != nullptr)) {
-                delete [] ordered_map_to_effective;
+        Coder() = delete;
+
+        class Encoder : public tdc::Encoder {
+        const size_t m_streams;
+        std::vector<uliteral_t> m_literals; // the literals coded in advance if m_streams > 1
+        size_t m_next_literal;
+        const huff::extended_huffmantable m_table;
+        const uint8_t*const ordered_map_to_effective;
+        public:
+            template<typename literals_t>
+            inline Encoder(Env&& env, std::shared_ptr<BitOStream> out, literals_t&& literals)
+                : tdc::Encoder(std::move(env), out, literals),
+                m_streams(m_interleaved ? std::max<size_t>(this->env().option("streams").as_integer(), 1) : 1),
+                m_next_literal(0),
+                m_table{ [&] () {
+                    if(tdc_likely(!literals.has_next())) return huff::extended_huffmantable { nullptr, nullptr, nullptr, 0, nullptr, 0 };
+                    const len_compact_t*const C = [&] () {
+                        if(m_streams == 1) return huff::count_alphabet_literals(std::move(literals));
+                        while(literals.has_next()) m_literals.push_back(literals.next().c);
+                        return huff::count_alphabet(m_literals);
+                    }();
+                    const len_t alphabet_size = huff::effective_alphabet_size(C);
+                    if(tdc_unlikely(alphabet_size == 1)) {
+                        delete [] C;
+                        return huff::extended_huffmantable { nullptr, nullptr, nullptr, 1, nullptr, 0 };
+                    }
+                    return huff::gen_huffmantable(C, this->env().option("max_length").as_integer());
+                }() }
+                , ordered_map_to_effective { m_table.codewords == nullptr ? nullptr : huff::gen_ordered_map_to_effective(m_table.ordered_map_from_effective, m_table.alphabet_size) }
+            {
+                if(tdc_unlikely(m_table.alphabet_size <= 1)) {
+                    m_out->write_bit(0);
+                }
+                else {
+                    m_out->write_bit(1);
+                    huff::huffmantable_encode(*m_out, m_table);
+                    if(m_streams > 1) {
+                        huff::huffman_encode_streams(m_literals, *m_out, m_table, m_streams);
+                    }
+                }
             }
-        }
-
-        template<typename literals_t>
-        inline Encoder(Env&& env, Output& out, literals_t&& literals)
-            : Encoder(std::move(env), std::make_shared<BitOStream>(out), literals) {
-        }
-
-        using tdc::Encoder::encode; // default encoding as fallback
 
-        template<typename value_t>
-        inline void encode(value_t v, const LiteralRange&) {
-            DCHECK_NE(m_table.alphabet_size,0);
-            if(tdc_unlikely(m_table.alphabet_size == 1))
-                m_out->write_int(static_cast<uliteral_t>(v),8*sizeof(uliteral_t));
-            else
-                huff::huffman_encode(v, *m_out, m_table.ordered_codelengths, ordered_map_to_effective, m_table.alphabet_size, m_table.codewords);
-        }
-    };
+            ~Encoder() {
+                if(tdc_likely(ordered_map_to_effective != nullptr)) {
+                    delete [] ordered_map_to_effective;
+                }
+            }
 
-    class Decoder : public tdc::Decoder {
-        const uliteral_t* ordered_map_from_effective;
-        std::unique_ptr<size_t const[]> prefix_sum_lengths;
-        const size_t* firstcodes;
-    public:
-        ~Decoder() {
-            if(tdc_likely(ordered_map_from_effective != nullptr)) {
-                delete [] ordered_map_from_effective;
-                delete [] firstcodes;
+            template<typename literals_t>
+            inline Encoder(Env&& env, Output& out, literals_t&& literals)
+                : Encoder(std::move(env), std::make_shared<BitOStream>(out), literals) {
             }
-        }
 
-        inline Decoder(Env&& env, std::shared_ptr<BitIStream> in)
-            : tdc::Decoder(std::move(env), in) {
+            using tdc::Encoder::encode; // default encoding as fallback
+
+            template<typename value_t>
+            inline void encode(value_t v, const LiteralRange&) {
+                DCHECK_NE(m_table.alphabet_size,0);
+                if(tdc_unlikely(m_table.alphabet_size == 1))
+                    m_out->write_int(static_cast<uliteral_t>(v),8*sizeof(uliteral_t));
+                else if(m_streams > 1) {
+                    // already coded, only verify that the literals arrive in the order of the literal iterator
+                    CHECK(m_next_literal < m_literals.size() && m_literals[m_next_literal] == uliteral_t(v))
+                        << "huff_streams requires the literals to be encoded in the order given by the literal iterator";
+                    ++m_next_literal;
+                }
+                else
+                    huff::huffman_encode(v, *m_out, m_table.ordered_codelengths, ordered_map_to_effective, m_table.alphabet_size, m_table.codewords);
+            }
+        };
+
+        class Decoder : public tdc::Decoder {
+            bool m_single_literal;
+            huff::DecodeTable m_table;
+            std::vector<uliteral_t> m_literals; // the literals decoded in advance if streams > 1
+            size_t m_next_literal;
+            bool m_decoded;
+        public:
+            inline Decoder(Env&& env, std::shared_ptr<BitIStream> in)
+                : tdc::Decoder(std::move(env), in), m_next_literal(0), m_decoded(false) {
+
+                m_single_literal = !m_in->read_bit();
+                if(tdc_unlikely(m_single_literal)) return;
+
+                const huff::huffmantable table(huff::huffmantable_decode(*m_in) );
+                const uint8_t*const ordered_codelengths { huff::gen_ordered_codelength(table.alphabet_size, table.numl, table.longest) };
+                m_table = huff::DecodeTable(table.ordered_map_from_effective, ordered_codelengths, table.alphabet_size, table.numl, table.longest);
+                delete [] ordered_codelengths;
+
+                const size_t streams = m_interleaved ? this->env().option("streams").as_integer() : 1;
+                if(streams > 1) {
+                    m_literals = huff::huffman_decode_streams(*m_in, m_table, streams);
+                    m_decoded = true;
+                }
+            }
 
-            if(tdc_unlikely(!m_in->read_bit())) {
-                ordered_map_from_effective = nullptr;
-                return;
+            inline Decoder(Env&& env, Input& in)
+                : Decoder(std::move(env), std::make_shared<BitIStream>(in)) {
             }
-            huff::huffmantable table(huff::huffmantable_decode(*m_in) );
-            ordered_map_from_effective = table.ordered_map_from_effective;
-            table.ordered_map_from_effective = nullptr;
-            const uint8_t*const ordered_codelengths { huff::gen_ordered_codelength(table.alphabet_size, table.numl, table.longest) };
-            prefix_sum_lengths = huff::gen_prefix_sum_lengths(ordered_codelengths, table.alphabet_size, table.longest);
-            delete [] ordered_codelengths;
-            firstcodes = huff::gen_first_codes(table.numl, table.longest);
-        }
 
-        inline Decoder(Env&& env, Input& in)
-            : Decoder(std::move(env), std::make_shared<BitIStream>(in)) {
-        }
+            /// Tells whether all values have been decoded, including the literals decoded in advance.
+            inline bool eof() const {
+                return m_in->eof() && m_next_literal == m_literals.size();
+            }
 
-        using tdc::Decoder::decode; // default decoding as fallback
+            using tdc::Decoder::decode; // default decoding as fallback
 
-        template<typename value_t>
-        inline value_t decode(const LiteralRange&) {
-            if(tdc_unlikely(ordered_map_from_effective == nullptr))
-                return m_in->read_int<uliteral_t>();
-            return huff::huffman_decode(*m_in, ordered_map_from_effective, prefix_sum_lengths.get(), firstcodes);
-        }
+            template<typename value_t>
+            inline value_t decode(const LiteralRange&) {
+                if(tdc_unlikely(m_single_literal))
+                    return m_in->read_int<uliteral_t>();
+                if(m_decoded) {
+                    DCHECK_LT(m_next_literal, m_literals.size());
+                    return m_literals[m_next_literal++];
+                }
+                return m_table.decode(*m_in);
+            }
+        };
     };
-};
+}//ns
+/// \endcond
+
+/// Canonical Huffman coder.
+using HuffmanCoder = huff::Coder<false>;
 
+/// Canonical Huffman coder, which codes all literals given by the literal
+/// iterator in advance into interleaved streams, which are decoded in
+/// lockstep. The literals must then be encoded in exactly that order, hence
+/// only compressors that preserve it may use this coder.
+using HuffmanStreamsCoder = huff::Coder<true>;
 
 }//ns
 
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <tudocomp/util.hpp>
+#include <tudocomp/util/Frequencies.hpp>
+#include <tudocomp/Coder.hpp>
+
+namespace tdc {
+
+/// \brief Defines data encoding to and decoding from a stream using range
+///        asymmetric numeral systems (rANS) with semi-static models.
+///
+/// Each distinct range that values are encoded with gets its own model, so
+/// that e.g. the factor sources, lengths and literal runs of a
+/// factorization are modelled separately. Values of small ranges (like
+/// literals and bits) are modelled directly. Values of larger ranges are
+/// modelled by their amount of bits, and the bits following the highest
+/// set bit are coded uniformly.
+///
+/// As ANS codes in reverse order, the encoder buffers all values and codes
+/// them when it is destroyed, writing the models followed by the code. The
+/// code is produced by several interleaved coder states that renormalize
+/// byte-wise. Therefore, the coder must not share its output with other
+/// coders.
+class RANSCoder : public Algorithm {
+public:
+    /// \brief Yields the coder's meta information.
+    /// \sa Meta
+    inline static Meta meta() {
+        Meta m("coder", "rans", "Interleaved range asymmetric numeral systems");
+        m.option("states").dynamic(4);
+        return m;
+    }
+
+    /// \cond DELETED
+    RANSCoder() = delete;
+    /// \endcond
+
+private:
+    /// The lower bound of the coder states, which lie in [L, 256 * L).
+    static constexpr uint64_t L = uint64_t(1) << 23;
+
+    /// The binary logarithm of the sum of frequencies of a model.
+    static constexpr size_t PROB_BITS = 12;
+
+    /// The maximum amount of bits coded uniformly at once.
+    static constexpr size_t RAW_BITS = 16;
+
+    /// Ranges with at most this many values are modelled directly.
+    static constexpr size_t DIRECT_LIMIT = 256;
+
+    static constexpr size_t MAX_STATES = 16;
+
+    /// The model of a range.
+    struct Context {
+        size_t min;
+        size_t max;
+        bool direct; // whether values are modelled directly or by bit length
+        std::vector<uint32_t> start; // the cumulative frequency of each symbol
+        std::vector<uint32_t> freq;
+
+        inline Context(size_t _min, size_t _max)
+            : min(_min), max(_max), direct(_max - _min < DIRECT_LIMIT) {
+        }
+
+        inline size_t alphabet_size() const {
+            return direct ? (max - min + 1) : (bits_for(max - min) + 1);
+        }
+
+        /// Sets the frequencies of the symbols, which must sum up to
+        /// 2^PROB_BITS.
+        inline void set_frequencies(std::vector<size_t> freqs) {
+            freq.assign(freqs.begin(), freqs.end());
+            start.resize(freq.size());
+            uint32_t sum = 0;
+            for(size_t s = 0; s < freq.size(); ++s) {
+                start[s] = sum;
+                sum += freq[s];
+            }
+            DCHECK_EQ(sum, 1U << PROB_BITS);
+        }
+    };
+
+    /// The symbol of value \c x (relative to the range's minimum) and the
+    /// amount of bits to code uniformly.
+    static inline size_t symbol(const Context& ctx, const uint64_t x, size_t& raw_bits) {
+        if(ctx.direct) {
+            raw_bits = 0;
+            return x;
+        } else {
+            const size_t s = (x == 0) ? 0 : bits_for(x);
+            raw_bits = (s >= 2) ? s - 1 : 0;
+            return s;
+        }
+    }
+
+    /// Finds the context of a range, creating it if it does not exist.
+    ///
+    /// Values are usually encoded with only a handful of ranges, hence the
+    /// linear search.
+    static inline size_t context_of(std::vector<Context>& contexts, const Range& r) {
+        for(size_t i = 0; i < contexts.size(); ++i) {
+            if(contexts[i].min == r.min() && contexts[i].max == r.max()) return i;
+        }
+        contexts.emplace_back(r.min(), r.max());
+        return contexts.size() - 1;
+    }
+
+public:
+    /// \brief Encodes data using rANS.
+    class Encoder : public tdc::Encoder {
+        std::vector<Context> m_contexts;
+        std::vector<std::pair<uint32_t, uint64_t>> m_values; // context, value - min
+        size_t m_states;
+
+        /// An operation of a coder state.
+        struct Op {
+            uint32_t start;
+            uint32_t freq;
+            uint32_t scale_bits;
+        };
+
+        /// The operations for coding a value, in decoding order.
+        inline size_t ops(const Context& ctx, const uint64_t x, Op* op) const {
+            size_t raw_bits;
+            const size_t s = symbol(ctx, x, raw_bits);
+            size_t n = 0;
+            op[n++] = Op { ctx.start[s], ctx.freq[s], PROB_BITS };
+            while(raw_bits > 0) {
+                const size_t k = std::min(raw_bits, size_t(RAW_BITS));
+                raw_bits -= k;
+                op[n++] = Op { uint32_t((x >> raw_bits) & ((1U << k) - 1)), 1, uint32_t(k) };
+            }
+            return n;
+        }
+
+    public:
+        template<typename literals_t>
+        inline Encoder(Env&& env, std::shared_ptr<BitOStream> out, literals_t&& literals)
+            : tdc::Encoder(std::move(env), out, literals) {
+            m_states = std::min<size_t>(size_t(MAX_STATES),
+                std::max<size_t>(1, this->env().option("states").as_integer()));
+        }
+
+        template<typename literals_t>
+        inline Encoder(Env&& env, Output& out, literals_t&& literals)
+            : Encoder(std::move(env), std::make_shared<BitOStream>(out), literals) {
+        }
+
+        ~Encoder() {
+            // build the models
+            std::vector<std::vector<size_t>> counts(m_contexts.size());
+            for(size_t i = 0; i < m_contexts.size(); ++i) {
+                counts[i].assign(m_contexts[i].alphabet_size(), 0);
+            }
+            for(const auto& v : m_values) {
+                size_t raw_bits;
+                ++counts[v.first][symbol(m_contexts[v.first], v.second, raw_bits)];
+            }
+
+            m_out->write_compressed_int(m_contexts.size());
+            for(size_t i = 0; i < m_contexts.size(); ++i) {
+                const std::vector<size_t> freqs = normalize_frequencies(counts[i], PROB_BITS);
+                m_out->write_compressed_int(freqs.size());
+                for(const size_t f : freqs) m_out->write_compressed_int(f);
+                m_contexts[i].set_frequencies(freqs);
+            }
+
+            // code the values backwards, operation j using state j mod m_states
+            size_t num_ops = 0;
+            Op op[1 + 64 / RAW_BITS];
+            for(const auto& v : m_values) {
+                num_ops += ops(m_contexts[v.first], v.second, op);
+            }
+
+            std::vector<uint8_t> bytes; // in reverse order
+            std::vector<uint64_t> x(m_states, uint64_t(L));
+            size_t j = num_ops;
+            for(size_t i = m_values.size(); i-- > 0;) {
+                const auto& v = m_values[i];
+                for(size_t k = ops(m_contexts[v.first], v.second, op); k-- > 0;) {
+                    uint64_t& state = x[--j % m_states];
+                    const uint64_t x_max = ((L >> op[k].scale_bits) << 8) * op[k].freq;
+                    while(state >= x_max) {
+                        bytes.push_back(uint8_t(state));
+                        state >>= 8;
+                    }
+                    state = ((state / op[k].freq) << op[k].scale_bits) +
+                            (state % op[k].freq) + op[k].start;
+                }
+            }
+            DCHECK_EQ(j, 0U);
+
+            // flush the states such that the decoder reads them in order
+            for(size_t s = m_states; s-- > 0;) {
+                for(size_t b = 4; b-- > 0;) bytes.push_back(uint8_t(x[s] >> (8 * b)));
+            }
+            std::reverse(bytes.begin(), bytes.end());
+
+            m_out->write_compressed_int(m_values.size());
+            m_out->write_compressed_int(m_states);
+            m_out->write_compressed_int(bytes.size());
+            m_out->write_bytes(bytes.data(), bytes.size());
+        }
+
+        template<typename value_t>
+        inline void encode(value_t v, const Range& r) {
+            const size_t ctx = context_of(m_contexts, r);
+            // truncate like the binary coding of values
+            const uint64_t x = uint64_t(v - r.min()) &
+                (~uint64_t(0) >> (64 - bits_for(r.max() - r.min())));
+            DCHECK_LE(x, r.max() - r.min());
+            m_values.emplace_back(uint32_t(ctx), x);
+        }
+    };
+
+    /// \brief Decodes data using rANS.
+    class Decoder : public tdc::Decoder {
+        /// A decoding table entry: the symbol of a slot and how to compute
+        /// the following state.
+        struct Slot {
+            uint16_t freq;
+            uint16_t offset; // the slot minus the symbol's cumulative frequency
+            uint8_t symbol;
+        };
+
+        std::vector<Context> m_contexts; // in order of their first use
+        std::vector<std::vector<Slot>> m_slots; // of each context
+        std::vector<std::vector<size_t>> m_freqs; // of each model
+        size_t m_last_context; // ranges are often used repeatedly
+
+        std::vector<uint8_t> m_bytes;
+        const uint8_t* m_pos;
+        std::vector<uint64_t> m_x;
+        size_t m_next_state;
+
+        size_t m_remaining;
+
+        inline uint64_t& next_state() {
+            uint64_t& state = m_x[m_next_state];
+            if(++m_next_state == m_x.size()) m_next_state = 0;
+            return state;
+        }
+
+        /// Reads bytes into a state until it is at least L. A state is at
+        /// least 2^7 after decoding, so two bytes always suffice, which
+        /// allows for reading them without branches.
+        inline void renormalize(uint64_t& state) {
+            for(size_t i = 0; i < 2; ++i) {
+                const bool read = state < L;
+                const uint64_t shifted = (state << 8) | *m_pos;
+                state = read ? shifted : state;
+                m_pos += read;
+            }
+            DCHECK_GE(state, uint64_t(L));
+        }
+
+        inline uint64_t decode_raw(const size_t k) {
+            uint64_t& state = next_state();
+            const uint64_t u = state & ((uint64_t(1) << k) - 1);
+            state >>= k;
+            renormalize(state);
+            return u;
+        }
+
+        inline size_t decode_symbol(const std::vector<Slot>& slots) {
+            uint64_t& state = next_state();
+            const Slot& slot = slots[state & ((1U << PROB_BITS) - 1)];
+            state = slot.freq * (state >> PROB_BITS) + slot.offset;
+            renormalize(state);
+            return slot.symbol;
+        }
+
+        inline size_t context_of(const Range& r) {
+            const Context& last = m_contexts[m_last_context];
+            if(tdc_likely(last.min == r.min() && last.max == r.max())) {
+                return m_last_context;
+            }
+
+            m_last_context = RANSCoder::context_of(m_contexts, r);
+            if(m_last_context == m_slots.size()) {
+                // first use of the range, take the next model
+                const size_t model = m_last_context - 1; // skip the sentinel
+                CHECK_LT(model, m_freqs.size()) << "more ranges than encoded";
+                Context& ctx = m_contexts[m_last_context];
+                ctx.set_frequencies(m_freqs[model]);
+
+                std::vector<Slot> slots(1U << PROB_BITS);
+                for(size_t s = 0; s < ctx.freq.size(); ++s) {
+                    for(size_t i = ctx.start[s]; i < ctx.start[s] + ctx.freq[s]; ++i) {
+                        slots[i] = Slot { uint16_t(ctx.freq[s]), uint16_t(i - ctx.start[s]), uint8_t(s) };
+                    }
+                }
+                m_slots.push_back(std::move(slots));
+            }
+            return m_last_context;
+        }
+
+    public:
+        inline Decoder(Env&& env, std::shared_ptr<BitIStream> in)
+            : tdc::Decoder(std::move(env), in), m_last_context(0), m_next_state(0) {
+
+            m_freqs.resize(m_in->read_compressed_int<size_t>());
+            for(auto& freqs : m_freqs) {
+                freqs.resize(m_in->read_compressed_int<size_t>());
+                for(auto& f : freqs) f = m_in->read_compressed_int<size_t>();
+            }
+
+            m_remaining = m_in->read_compressed_int<size_t>();
+            m_x.resize(m_in->read_compressed_int<size_t>());
+
+            // the code, followed by padding for reading beyond its end
+            // in case of corrupted input
+            const size_t size = m_in->read_compressed_int<size_t>();
+            m_bytes.assign(size + 4 * MAX_STATES, 0);
+            m_in->read_bytes(m_bytes.data(), size);
+
+            m_pos = m_bytes.data();
+            for(auto& state : m_x) {
+                state = 0;
+                for(size_t b = 0; b < 4; ++b) state |= uint64_t(*m_pos++) << (8 * b);
+            }
+
+            // a sentinel, such that there always is a last context
+            m_contexts.emplace_back(1, 0);
+            m_slots.emplace_back();
+        }
+
+        inline Decoder(Env&& env, Input& in)
+            : Decoder(std::move(env), std::make_shared<BitIStream>(in)) {
+        }
+
+        /// Tells whether all values have been decoded.
+        inline bool eof() const {
+            return m_remaining == 0;
+        }
+
+        template<typename value_t>
+        inline value_t decode(const Range& r) {
+            DCHECK_GT(m_remaining, 0U);
+            --m_remaining;
+
+            const size_t i = context_of(r);
+            const size_t s = decode_symbol(m_slots[i]);
+            if(m_contexts[i].direct || s <= 1) {
+                return value_t(r.min() + s);
+            }
+
+            uint64_t x = 1;
+            for(size_t raw_bits = s - 1; raw_bits > 0;) {
+                const size_t k = std::min(raw_bits, size_t(RAW_BITS));
+                raw_bits -= k;
+                x = (x << k) | decode_raw(k);
+            }
+            return value_t(r.min() + x);
+        }
+    };
+};
+
+}
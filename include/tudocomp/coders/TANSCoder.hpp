@@ -0,0 +1,300 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <tudocomp/util.hpp>
+#include <tudocomp/util/Frequencies.hpp>
+#include <tudocomp/Coder.hpp>
+
+namespace tdc {
+
+/// \brief Defines data encoding to and decoding from a stream using
+///        table-based asymmetric numeral systems (tANS), also known as
+///        finite state entropy (FSE).
+///
+/// The frequencies of the literals are normalized to a total of
+/// \c 2^table_log, which is the amount of coder states. All literals yielded
+/// by the literal iterator are coded when the encoder is constructed: they
+/// are coded in reverse order, such that the decoder can decode them in
+/// forward order, and the resulting bits are written right after the
+/// frequency table. The decoder then decodes all of them at once.
+///
+/// Therefore, literals must be encoded in exactly the order in which the
+/// literal iterator yields them. Other values are encoded in binary.
+class TANSCoder : public Algorithm {
+public:
+    /// \brief Yields the coder's meta information.
+    /// \sa Meta
+    inline static Meta meta() {
+        Meta m("coder", "tans", "Table-based asymmetric numeral systems (tANS / FSE)");
+        m.option("table_log").dynamic(11);
+        return m;
+    }
+
+    /// \cond DELETED
+    TANSCoder() = delete;
+    /// \endcond
+
+private:
+    /// The minimum binary logarithm of the table size, which ensures that
+    /// the spreading step is odd.
+    static constexpr size_t MIN_TABLE_LOG = 5;
+
+    /// The maximum binary logarithm of the table size.
+    static constexpr size_t MAX_TABLE_LOG = 16;
+
+    /// Assigns the states to the characters, spreading the states of each
+    /// character over the table like FSE does.
+    static inline std::vector<uliteral_t> spread(
+        const std::vector<size_t>& freqs, const size_t table_log) {
+
+        const size_t table_size = size_t(1) << table_log;
+        const size_t mask = table_size - 1;
+        const size_t step = (table_size >> 1) + (table_size >> 3) + 3;
+
+        std::vector<uliteral_t> symbols(table_size);
+        size_t pos = 0;
+        for(size_t c = 0; c < freqs.size(); ++c) {
+            for(size_t k = 0; k < freqs[c]; ++k) {
+                symbols[pos] = uliteral_t(c);
+                pos = (pos + step) & mask;
+            }
+        }
+        DCHECK_EQ(pos, 0U);
+        return symbols;
+    }
+
+    /// The binary logarithm of x, rounded down.
+    static inline size_t floor_log2(const size_t x) {
+        DCHECK_GT(x, 0U);
+        return bits_for(x) - 1;
+    }
+
+public:
+    /// \brief Encodes data using tANS.
+    class Encoder : public tdc::Encoder {
+        std::vector<uliteral_t> m_literals; // the literals, coded in advance
+        size_t m_next_literal;
+        bool m_coded; // false if there are less than two distinct literals
+
+    public:
+        template<typename literals_t>
+        inline Encoder(Env&& env, std::shared_ptr<BitOStream> out, literals_t&& literals)
+            : tdc::Encoder(std::move(env), out, literals), m_next_literal(0) {
+
+            while(literals.has_next()) m_literals.push_back(literals.next().c);
+
+            std::vector<size_t> counts(ULITERAL_MAX + 1, 0);
+            for(const uliteral_t c : m_literals) ++counts[c];
+            const size_t sigma = std::count_if(counts.begin(), counts.end(),
+                [](const size_t count) { return count > 0; });
+
+            m_coded = sigma > 1;
+            m_out->write_bit(m_coded);
+            if(!m_coded) return;
+
+            const size_t table_log = std::min(size_t(MAX_TABLE_LOG), std::max<size_t>(
+                {MIN_TABLE_LOG, bits_for(sigma - 1),
+                 size_t(this->env().option("table_log").as_integer())}));
+            const size_t table_size = size_t(1) << table_log;
+
+            // write the frequency table
+            const std::vector<size_t> freqs = normalize_frequencies(counts, table_log);
+            m_out->write_compressed_int(table_log);
+            m_out->write_compressed_int(sigma);
+            for(size_t c = 0; c < freqs.size(); ++c) {
+                if(freqs[c] == 0) continue;
+                m_out->write_int(uliteral_t(c));
+                m_out->write_int(freqs[c] - 1, table_log);
+            }
+
+            // the states of each character, in ascending order, start at
+            // the cumulative frequency of the character
+            const std::vector<uliteral_t> symbols = spread(freqs, table_log);
+            std::vector<size_t> start(freqs.size());
+            for(size_t c = 1; c < freqs.size(); ++c) {
+                start[c] = start[c - 1] + freqs[c - 1];
+            }
+            std::vector<uint32_t> next_state(table_size);
+            {
+                std::vector<size_t> fill = start;
+                for(size_t p = 0; p < table_size; ++p) {
+                    next_state[fill[symbols[p]]++] = uint32_t(table_size + p);
+                }
+            }
+
+            // code the literals backwards, storing the bits written for each
+            // literal as (bits << 5) | amount
+            const size_t n = m_literals.size();
+            std::vector<uint32_t> chunks(n);
+            size_t x = table_size;
+            for(size_t i = n; i-- > 0;) {
+                const uliteral_t c = m_literals[i];
+                const size_t f = freqs[c];
+                size_t k = table_log - floor_log2(f);
+                if((x >> k) < f) --k;
+                chunks[i] = uint32_t(((x & ((size_t(1) << k) - 1)) << 5) | k);
+                x = next_state[start[c] + (x >> k) - f];
+            }
+
+            // write the bits in forward order
+            std::vector<uint8_t> bytes;
+            bytes.reserve(n * table_log / 8 + 1);
+            {
+                uint64_t acc = 0;
+                size_t acc_bits = 0;
+                for(const uint32_t chunk : chunks) {
+                    const size_t k = chunk & 0x1F;
+                    acc = (acc << k) | (chunk >> 5);
+                    acc_bits += k;
+                    while(acc_bits >= 8) {
+                        acc_bits -= 8;
+                        bytes.push_back(uint8_t(acc >> acc_bits));
+                    }
+                }
+                if(acc_bits > 0) bytes.push_back(uint8_t(acc << (8 - acc_bits)));
+            }
+
+            m_out->write_compressed_int(n);
+            m_out->write_int(x - table_size, table_log);
+            m_out->write_compressed_int(bytes.size());
+            m_out->write_bytes(bytes.data(), bytes.size());
+        }
+
+        template<typename literals_t>
+        inline Encoder(Env&& env, Output& out, literals_t&& literals)
+            : Encoder(std::move(env), std::make_shared<BitOStream>(out), literals) {
+        }
+
+        using tdc::Encoder::encode; // default encoding as fallback
+
+        template<typename value_t>
+        inline void encode(value_t v, const LiteralRange&) {
+            if(tdc_unlikely(!m_coded)) {
+                m_out->write_int(static_cast<uliteral_t>(v), 8 * sizeof(uliteral_t));
+                return;
+            }
+            // already coded, only verify that the literals arrive in the order of the literal iterator
+            CHECK(m_next_literal < m_literals.size() && m_literals[m_next_literal] == uliteral_t(v))
+                << "tans requires the literals to be encoded in the order given by the literal iterator";
+            ++m_next_literal;
+        }
+    };
+
+    /// \brief Decodes data using tANS.
+    class Decoder : public tdc::Decoder {
+        /// A decoding table entry: the character of a state and how to
+        /// compute the following state.
+        struct Entry {
+            uint16_t base;
+            uint8_t bits;
+            uliteral_t c;
+        };
+
+        std::vector<uliteral_t> m_literals; // the literals, decoded in advance
+        size_t m_next_literal;
+        bool m_coded;
+
+    public:
+        inline Decoder(Env&& env, std::shared_ptr<BitIStream> in)
+            : tdc::Decoder(std::move(env), in), m_next_literal(0) {
+
+            m_coded = m_in->read_bit();
+            if(!m_coded) return;
+
+            // read the frequency table
+            const size_t table_log = m_in->read_compressed_int<size_t>();
+            const size_t table_size = size_t(1) << table_log;
+            const size_t sigma = m_in->read_compressed_int<size_t>();
+            std::vector<size_t> freqs(ULITERAL_MAX + 1, 0);
+            for(size_t i = 0; i < sigma; ++i) {
+                const uliteral_t c = m_in->read_int<uliteral_t>();
+                freqs[c] = m_in->read_int<size_t>(table_log) + 1;
+            }
+
+            // build the decoding table
+            const std::vector<uliteral_t> symbols = spread(freqs, table_log);
+            std::vector<Entry> table(table_size);
+            {
+                std::vector<size_t> next = freqs;
+                for(size_t p = 0; p < table_size; ++p) {
+                    const uliteral_t c = symbols[p];
+                    const size_t x = next[c]++;
+                    const size_t bits = table_log - floor_log2(x);
+                    table[p] = Entry { uint16_t((x << bits) - table_size), uint8_t(bits), c };
+                }
+            }
+
+            const size_t n = m_in->read_compressed_int<size_t>();
+            size_t state = m_in->read_int<size_t>(table_log);
+
+            // the bits, followed by padding for the word-wise refill: once
+            // the last bits were loaded, pos may be up to seven bytes past
+            // them, from where a refill still copies a whole word
+            const size_t padding = 16;
+            std::vector<uint8_t> bytes(m_in->read_compressed_int<size_t>() + padding, 0);
+            m_in->read_bytes(bytes.data(), bytes.size() - padding);
+
+            // decode with a left-aligned accumulator, which is refilled with
+            // whole bytes to at least 56 bits, enough for three characters
+            m_literals.resize(n);
+            const uint8_t* pos = bytes.data();
+            uint64_t acc = 0;
+            size_t acc_bits = 0;
+
+            auto refill = [&]() {
+                uint64_t word;
+                std::memcpy(&word, pos, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                word = __builtin_bswap64(word);
+#endif
+                acc |= word >> acc_bits;
+                pos += (63 - acc_bits) >> 3;
+                acc_bits |= 56;
+            };
+            auto next = [&]() {
+                const Entry& e = table[state];
+                // a shift by 64 is undefined, hence the two steps
+                state = e.base + ((acc >> 1) >> (63 - e.bits));
+                acc <<= e.bits;
+                acc_bits -= e.bits;
+                return e.c;
+            };
+
+            size_t i = 0;
+            for(; i + 3 <= n; i += 3) {
+                refill();
+                m_literals[i] = next();
+                m_literals[i + 1] = next();
+                m_literals[i + 2] = next();
+            }
+            for(; i < n; ++i) {
+                refill();
+                m_literals[i] = next();
+            }
+        }
+
+        inline Decoder(Env&& env, Input& in)
+            : Decoder(std::move(env), std::make_shared<BitIStream>(in)) {
+        }
+
+        /// Tells whether all values have been decoded, including the
+        /// literals decoded in advance.
+        inline bool eof() const {
+            return m_in->eof() && m_next_literal == m_literals.size();
+        }
+
+        using tdc::Decoder::decode; // default decoding as fallback
+
+        template<typename value_t>
+        inline value_t decode(const LiteralRange&) {
+            if(tdc_unlikely(!m_coded)) return m_in->read_int<uliteral_t>();
+            DCHECK_LT(m_next_literal, m_literals.size());
+            return m_literals[m_next_literal++];
+        }
+    };
+};
+
+}
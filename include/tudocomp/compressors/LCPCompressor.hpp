@@ -6,6 +6,7 @@
 #include <tudocomp/compressors/lzss/LZSSCoding.hpp>
 #include <tudocomp/compressors/lzss/LZSSFactors.hpp>
 #include <tudocomp/compressors/lzss/LZSSLiterals.hpp>
+#include <tudocomp/util/Parallel.hpp>
 
 #include <tudocomp/ds/TextDS.hpp>
 
@@ -79,6 +80,11 @@ inline void decode_text_internal(Env&& env, coder_t& decoder, std::ostream& outs
 
 /// Factorizes the input by finding redundant phrases in a re-ordered version
 /// of the LCP table.
+///
+/// Factors may refer to text positions that are themselves covered by
+/// factors, forming chains of references. With a positive \c max_depth,
+/// factors are split such that no chain is longer, so a \ref lcpcomp::ScanDec
+/// with at least as many scans decodes every position in its scans.
 template<typename coder_t, typename strategy_t, typename dec_t, typename text_t = TextDS<>>
 class LCPCompressor : public Compressor {
 public:
@@ -90,6 +96,10 @@ public:
         m.option("textds").templated<text_t, TextDS<>>("textds");
         m.option("threshold").dynamic(5);
         m.option("flatten").dynamic(1); // 0 or 1
+        m.option("compact_factors").dynamic(0); // 0 or 1
+        m.option("sort_threads").dynamic(1); // 0 for all hardware threads
+        m.option("flatten_threads").dynamic(1); // 0 for all hardware threads
+        m.option("max_depth").dynamic(0); // 0 for unbounded
         m.uses_textds<text_t>(strategy_t::textds_flags());
         return m;
     }
@@ -107,7 +117,8 @@ public:
 
         // read options
         const len_t threshold = env().option("threshold").as_integer(); //factor threshold
-        lzss::FactorBuffer factors;
+        lzss::FactorBuffer factors(text.size(),
+            env().option("compact_factors").as_integer());
 
         StatPhase::wrap("Factorize", [&]{
             // Factorize
@@ -116,14 +127,33 @@ public:
 
             StatPhase::log("threshold", threshold);
             StatPhase::log("factors", factors.size());
+            factors.shrink_to_fit();
         });
 
         // sort factors
-        StatPhase::wrap("Sort Factors", [&]{ factors.sort(); });
+        StatPhase::wrap("Sort Factors", [&]{
+            factors.sort(resolve_thread_count(
+                env().option("sort_threads").as_integer()));
+        });
+
+        const size_t flatten_threads = resolve_thread_count(
+            env().option("flatten_threads").as_integer());
+        const len_t max_depth = env().option("max_depth").as_integer();
 
         if(env().option("flatten").as_integer()) {
             // flatten factors
-            StatPhase::wrap("Flatten Factors", [&]{ factors.flatten(); });
+            StatPhase::wrap("Flatten Factors", [&]{
+                factors.flatten(flatten_threads);
+            });
+        }
+
+        if(max_depth > 0) {
+            // bound reference chains
+            StatPhase::wrap("Bound Depth", [&]{
+                factors.bound_depth(max_depth, threshold);
+                StatPhase::log("factors", factors.size());
+                StatPhase::log("max_depth", factors.depth(flatten_threads));
+            });
         }
 
         // encode
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <string>
 #include <vector>
 
 #include <tudocomp/Compressor.hpp>
@@ -11,6 +12,9 @@
 #include <tudocomp/compressors/lzss/LZSSFactors.hpp>
 #include <tudocomp/compressors/lzss/LZSSLiterals.hpp>
 #include <tudocomp/compressors/lzss/LZSSCoding.hpp>
+#include <tudocomp/compressors/lzss/LZSSLPF.hpp>
+#include <tudocomp/compressors/lzss/LZSSCostModel.hpp>
+#include <tudocomp/compressors/lzss/LZSSParse.hpp>
 
 #include <tudocomp/ds/TextDS.hpp>
 
@@ -20,6 +24,20 @@ namespace tdc {
 
 /// Computes the LZ77 factorization of the input using its suffix array and
 /// LCP table.
+///
+/// With \c factorize set to \c scan, the previous and next smaller values of
+/// each factor's suffix are found by scanning the LCP table around its
+/// position in the suffix array, which requires the inverse suffix array and
+/// can take quadratic time on repetitive texts. With \c lpf, the longest
+/// previous factor array is computed in a single linear time pass over the
+/// suffix array instead (see \ref lzss::LPF), and the text is factorized
+/// sequentially without using the inverse suffix array.
+///
+/// The choice of factors is controlled by \c parse. Besides the \c greedy
+/// factorization, which always takes the longest previous factor, there is
+/// \c lazy matching (see \ref lzss::parse_lazy) and an \c optimal parse that
+/// minimizes the estimated encoding size for the chosen coder (see
+/// \ref lzss::parse_optimal). Both always use the LPF array.
 template<typename coder_t, typename text_t = TextDS<>>
 class LZSSLCPCompressor : public Compressor {
 public:
@@ -28,6 +46,8 @@ public:
         m.option("coder").templated<coder_t>("coder");
         m.option("textds").templated<text_t, TextDS<>>("textds");
         m.option("threshold").dynamic(3);
+        m.option("factorize").dynamic("scan");
+        m.option("parse").dynamic("greedy");
         m.uses_textds<text_t>(text_t::SA | text_t::ISA | text_t::LCP);
         return m;
     }
@@ -39,75 +59,125 @@ public:
     inline LZSSLCPCompressor(Env&& env) : Compressor(std::move(env)) {
     }
 
+private:
+    inline void factorize_scan(text_t& text, lzss::FactorBuffer& factors,
+                               const len_t threshold) {
+        auto& sa = text.require_sa();
+        auto& isa = text.require_isa();
+        auto& lcp = text.require_lcp();
+
+        const len_t text_length = text.size();
+
+        for(len_t i = 0; i+1 < text_length;) { // we omit T[text_length-1] since we assume that it is the \0 byte!
+            //get SA position for suffix i
+            const size_t& cur_pos = isa[i];
+            DCHECK_NE(cur_pos,0); // isa[i] == 0 <=> T[i] = 0
+
+            //compute naively PSV
+            //search "upwards" in LCP array
+            //include current, exclude last
+            size_t psv_lcp = lcp[cur_pos];
+            ssize_t psv_pos = cur_pos - 1;
+            if (psv_lcp > 0) {
+                while (psv_pos >= 0 && sa[psv_pos] > sa[cur_pos]) {
+                    psv_lcp = std::min<size_t>(psv_lcp, lcp[psv_pos--]);
+                }
+            }
+
+            //compute naively NSV (see factorize_lpf for a linear time variant)
+            //search "downwards" in LCP array
+            //exclude current, include last
+            size_t nsv_lcp = 0;
+            size_t nsv_pos = cur_pos + 1;
+            if (nsv_pos < text_length) {
+                nsv_lcp = SSIZE_MAX;
+                do {
+                    nsv_lcp = std::min<size_t>(nsv_lcp, lcp[nsv_pos]);
+                    if (sa[nsv_pos] < sa[cur_pos]) {
+                        break;
+                    }
+                } while (++nsv_pos < text_length);
+
+                if (nsv_pos >= text_length) {
+                    nsv_lcp = 0;
+                }
+            }
+
+            //select maximum
+            const size_t& max_lcp = std::max(psv_lcp, nsv_lcp);
+            if(max_lcp >= threshold) {
+                const ssize_t& max_pos = max_lcp == psv_lcp ? psv_pos : nsv_pos;
+                DCHECK_LT(max_pos, text_length);
+                DCHECK_GE(max_pos, 0);
+                // new factor
+                factors.emplace_back(i, sa[max_pos], max_lcp);
+
+                i += max_lcp; //advance
+            } else {
+                ++i; //advance
+            }
+        }
+    }
+
+    inline void factorize_lpf(text_t& text, lzss::FactorBuffer& factors,
+                              const len_t threshold, const std::string& parse) {
+        const len_t text_length = text.size();
+
+        lzss::LPF lpf = StatPhase::wrap("Compute LPF", [&]{
+            // the factorization only needs the LPF array, so SA and LCP
+            // are released once it is built
+            auto sa = text.release_sa();
+            auto lcp = text.release_lcp();
+            return lzss::LPF(sa, lcp, text_length);
+        });
+
+        if(parse == "lazy") {
+            lzss::parse_lazy(lpf, factors, threshold);
+        } else if(parse == "optimal") {
+            StatPhase::wrap("Optimal Parse", [&]{
+                lzss::CostModel<coder_t> model(text);
+                lzss::parse_optimal(text, lpf, model, factors, threshold);
+            });
+        } else {
+            lzss::parse_greedy(lpf, factors, threshold);
+        }
+    }
+
+public:
     inline virtual void compress(Input& input, Output& output) override {
         auto view = input.as_view();
         DCHECK(view.ends_with(uint8_t(0)));
 
+        auto& factorize = env().option("factorize").as_string();
+        if(factorize != "lpf" && factorize != "scan") {
+            env().error("factorize must be either \"scan\" or \"lpf\"");
+        }
+
+        auto& parse = env().option("parse").as_string();
+        if(parse != "greedy" && parse != "lazy" && parse != "optimal") {
+            env().error("parse must be one of \"greedy\", \"lazy\" or \"optimal\"");
+        }
+
+        // only greedy parsing is supported by scanning
+        const bool use_lpf = (factorize == "lpf" || parse != "greedy");
+
         // Construct text data structures
         text_t text = StatPhase::wrap("Construct Text DS", [&]{
             return text_t(env().env_for_option("textds"), view,
-                    text_t::SA | text_t::ISA | text_t::LCP);
+                    use_lpf ? (text_t::SA | text_t::LCP)
+                            : (text_t::SA | text_t::ISA | text_t::LCP));
         });
 
-        auto& sa = text.require_sa();
-        auto& isa = text.require_isa();
-        auto& lcp = text.require_lcp();
-
         // Factorize
-        const len_t text_length = text.size();
         lzss::FactorBuffer factors;
 
         StatPhase::wrap("Factorize", [&]{
             const len_t threshold = env().option("threshold").as_integer(); //factor threshold
 
-            for(len_t i = 0; i+1 < text_length;) { // we omit T[text_length-1] since we assume that it is the \0 byte!
-                //get SA position for suffix i
-                const size_t& cur_pos = isa[i];
-			    DCHECK_NE(cur_pos,0); // isa[i] == 0 <=> T[i] = 0
-
-			    //compute naively PSV
-                //search "upwards" in LCP array
-                //include current, exclude last
-                size_t psv_lcp = lcp[cur_pos];
-                ssize_t psv_pos = cur_pos - 1;
-                if (psv_lcp > 0) {
-                    while (psv_pos >= 0 && sa[psv_pos] > sa[cur_pos]) {
-                        psv_lcp = std::min<size_t>(psv_lcp, lcp[psv_pos--]);
-                    }
-                }
-
-			    //compute naively NSV, TODO: use NSV data structure
-                //search "downwards" in LCP array
-                //exclude current, include last
-                size_t nsv_lcp = 0;
-                size_t nsv_pos = cur_pos + 1;
-                if (nsv_pos < text_length) {
-                    nsv_lcp = SSIZE_MAX;
-                    do {
-                        nsv_lcp = std::min<size_t>(nsv_lcp, lcp[nsv_pos]);
-                        if (sa[nsv_pos] < sa[cur_pos]) {
-                            break;
-                        }
-                    } while (++nsv_pos < text_length);
-
-                    if (nsv_pos >= text_length) {
-                        nsv_lcp = 0;
-                    }
-                }
-
-                //select maximum
-                const size_t& max_lcp = std::max(psv_lcp, nsv_lcp);
-                if(max_lcp >= threshold) {
-				    const ssize_t& max_pos = max_lcp == psv_lcp ? psv_pos : nsv_pos;
-				    DCHECK_LT(max_pos, text_length);
-				    DCHECK_GE(max_pos, 0);
-                    // new factor
-                    factors.emplace_back(i, sa[max_pos], max_lcp);
-
-                    i += max_lcp; //advance
-                } else {
-                    ++i; //advance
-                }
+            if(use_lpf) {
+                factorize_lpf(text, factors, threshold, parse);
+            } else {
+                factorize_scan(text, factors, threshold);
             }
 
             StatPhase::log("threshold", threshold);
@@ -1,28 +1,97 @@
 #pragma once
 
+#include <algorithm>
+#include <istream>
+#include <string>
+
 #include <tudocomp/Compressor.hpp>
 #include <tudocomp/Literal.hpp>
 #include <tudocomp/Range.hpp>
 #include <tudocomp/util.hpp>
 
+#include <tudocomp/compressors/lzss/LZSSMatchFinder.hpp>
+#include <tudocomp/compressors/lzss/LZSSWindowBuffer.hpp>
+
 #include <tudocomp_stat/StatPhase.hpp>
 
 namespace tdc {
 
 /// Computes the LZ77 factorization of the input by moving a sliding window
 /// over it in which redundant phrases will be looked for.
+///
+/// The input is streamed through a circular buffer (see
+/// \ref lzss::WindowBuffer), so it never has to be held in memory as a
+/// whole. Factors refer back at most \c window positions and are at most
+/// \c lookahead long (zero selects the window size). Matches are searched
+/// by the match finder selected with \c finder:
+///
+/// - \c naive compares against every position in the window,
+/// - \c hash follows hash chains (see \ref lzss::HashChainMatchFinder),
+/// - \c bt walks binary trees (see \ref lzss::BinaryTreeMatchFinder).
+///
+/// The latter two visit at most \c max_chain candidates per position.
 template<typename coder_t>
 class LZSSSlidingWindowCompressor : public Compressor {
 
 private:
     size_t m_window;
+    size_t m_lookahead;
+
+    template<typename finder_t>
+    inline void factorize(std::istream& ins,
+                          typename coder_t::Encoder& coder,
+                          StatPhase& phase) {
+
+        const len_t threshold = env().option("threshold").as_integer(); //factor threshold
+        const size_t min_len = std::max<size_t>(threshold, 1);
+        phase.log_stat("threshold", threshold);
+
+        lzss::WindowBuffer buf(ins, m_window, m_lookahead);
+        finder_t finder(buf, m_window,
+            env().option("max_chain").as_integer(), min_len);
+
+        size_t num_factors = 0;
+        size_t pos = 0;
+        while(true) {
+            buf.fill(pos);
+            if(pos >= buf.end()) break;
+
+            const auto m = finder.find(
+                pos, std::min(m_lookahead, buf.end() - pos));
+
+            if(m.len >= min_len) {
+                // encode factor
+                coder.encode(true, bit_r);
+                coder.encode(pos - m.src, Range(pos)); //delta
+                coder.encode(m.len, Range(m_lookahead));
+                ++num_factors;
+
+                // insert the positions covered by the factor
+                for(size_t i = pos + 1; i < pos + m.len; ++i) {
+                    buf.fill(i);
+                    finder.insert(i, std::min(m_lookahead, buf.end() - i));
+                }
+                pos += m.len;
+            } else {
+                // encode literal
+                coder.encode(false, bit_r);
+                coder.encode(uliteral_t(buf[pos]), literal_r);
+                ++pos;
+            }
+        }
+
+        phase.log_stat("factors", num_factors);
+    }
 
 public:
     inline static Meta meta() {
         Meta m("compressor", "lzss", "Lempel-Ziv-Storer-Szymanski (Sliding Window)");
         m.option("coder").templated<coder_t>("coder");
         m.option("window").dynamic(16);
+        m.option("lookahead").dynamic(0);
         m.option("threshold").dynamic(3);
+        m.option("finder").dynamic("hash");
+        m.option("max_chain").dynamic(64);
         return m;
     }
 
@@ -33,6 +102,12 @@ public:
     inline LZSSSlidingWindowCompressor(Env&& e) : Compressor(std::move(e))
     {
         m_window = this->env().option("window").as_integer();
+        m_lookahead = this->env().option("lookahead").as_integer();
+        if(m_lookahead == 0) m_lookahead = m_window;
+
+        if(m_window == 0 || m_window > (1ULL << 31)) {
+            this->env().error("window must be between 1 and 2^31");
+        }
     }
 
     /// \copydoc Compressor::compress
@@ -41,79 +116,18 @@ public:
 
         typename coder_t::Encoder coder(env().env_for_option("coder"), output, NoLiterals());
 
-        std::vector<uint8_t> buf;
-
-        size_t ahead = 0; //marks the index in the buffer at which the back buffer ends and the ahead buffer begins
-        char c;
-
         StatPhase phase("Factorize");
 
-        //initially fill the buffer
-        size_t buf_off = 0;
-        while(buf.size() < 2 * m_window && ins.get(c)) {
-            buf.push_back(uint8_t(c));
-        }
-
-        //factorize
-        const len_t threshold = env().option("threshold").as_integer(); //factor threshold
-        phase.log_stat("threshold", threshold);
-
-        size_t pos = 0;
-        bool eof = false;
-        while(ahead < buf.size()) {
-            size_t fpos = 0, fsrc = 0, fnum = 0;
-
-            //walk back buffer
-            for(size_t k = (ahead > m_window ? ahead - m_window : 0); k < ahead; k++) {
-                //compare string
-                size_t j = 0;
-                while(ahead + j < buf.size() && buf[k + j] == buf[ahead + j]) {
-                    ++j;
-                }
-
-                //factorize if longer than one already found
-                if(j >= threshold && j > fnum) {
-                    fpos = buf_off + ahead;
-                    fsrc = buf_off + k;
-                    fnum = j;
-                }
-            }
-
-            //output longest factor or symbol
-            size_t advance;
-
-            if(fnum > 0) {
-                // encode factor
-                coder.encode(true, bit_r);
-                coder.encode(fpos - fsrc, Range(fpos)); //delta
-                coder.encode(fnum, Range(m_window));
-
-                advance = fnum;
-            } else {
-                // encode literal
-                coder.encode(false, bit_r);
-                coder.encode(uliteral_t(buf[ahead]), literal_r);
-
-                advance = 1;
-            }
-
-            //advance buffer
-            pos += advance;
-            while(advance--) {
-                if(ahead < m_window) {
-                    //case 1: still reading the first w symbols from the stream
-                    ++ahead;
-                } else if(!eof && ins.get(c)) {
-                    //case 2: read a new symbol
-                    buf.erase(buf.begin()); //TODO ouch
-                    buf.push_back(uint8_t(c));
-                    ++buf_off;
-                } else {
-                    //case 3: EOF, read rest of buffer
-                    eof = true;
-                    ++ahead;
-                }
-            }
+        const std::string finder = env().option("finder").as_string();
+        if(finder == "naive") {
+            factorize<lzss::NaiveMatchFinder>(ins, coder, phase);
+        } else if(finder == "hash") {
+            factorize<lzss::HashChainMatchFinder>(ins, coder, phase);
+        } else if(finder == "bt") {
+            factorize<lzss::BinaryTreeMatchFinder>(ins, coder, phase);
+        } else {
+            env().error("unknown finder '" + finder +
+                "', expected naive, hash or bt");
         }
     }
 
@@ -127,7 +141,7 @@ public:
                 size_t fsrc = text.size() - decoder.template decode<size_t>(Range(text.size()));
 
                 //TODO are the compressor options saved into tudocomp's magic?
-                size_t fnum = decoder.template decode<size_t>(Range(m_window));
+                size_t fnum = decoder.template decode<size_t>(Range(m_lookahead));
 
                 for(size_t i = 0; i < fnum; i++) {
                     text.push_back(text[fsrc+i]);
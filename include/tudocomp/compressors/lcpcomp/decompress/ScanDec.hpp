@@ -1,10 +1,9 @@
 #pragma once
 
 #include <vector>
-#include <sdsl/int_vector.hpp>
-#include <sdsl/rank_support.hpp>
 #include <tudocomp/def.hpp>
 #include <tudocomp/ds/IntVector.hpp>
+#include <tudocomp/ds/Rank.hpp>
 #include <tudocomp/Algorithm.hpp>
 #include <algorithm>
 
@@ -21,12 +20,13 @@ namespace lcpcomp {
 	 * to get decompressed.
 	 * The not-yet decoded positions are marked in a bit vector with rank-support
 	 * such that we can map from text position to positions in the array.
+	 * The bits are only kept in the rank data structure, which answers both
+	 * the bit and the rank of a position with a single cache line access.
 	 */
 	class EagerScanDec {
 		Env& m_env;
 		IntVector<uliteral_t>& m_buffer;
-		const sdsl::bit_vector m_bv;
-		const sdsl::bit_vector::rank_1_type m_rank;
+		const Rank m_rank;
 		const len_t m_empty_entries;
 		len_compact_t**const m_fwd = nullptr;
 
@@ -37,15 +37,14 @@ namespace lcpcomp {
 		EagerScanDec(Env& env, IntVector<uliteral_t>& buffer)
 			: m_env(env)
 			, m_buffer { buffer }
-			, m_bv ( [&buffer] () -> sdsl::bit_vector {
-				sdsl::bit_vector bv { buffer.size(),0 };
+			, m_rank ( [&buffer] () -> Rank {
+				BitVector bv(buffer.size(), 0);
 				for(len_t i = 0; i < buffer.size(); ++i) {
 					if(buffer[i]) continue;
 					bv[i] = 1;
 				}
-				return bv;
+				return Rank(bv);
 			}() )
-			, m_rank { &m_bv }
 			//, m_empty_entries { static_cast<len_t>( buffer.size()) }
 			, m_empty_entries { static_cast<len_t>(std::count_if(buffer.cbegin(), buffer.cend(), [] (const uliteral_t& i) { return i == 0; })) }
 			, m_fwd { new len_compact_t*[m_empty_entries+1] }
@@ -54,8 +53,8 @@ namespace lcpcomp {
 		}
 
 		len_t rank(len_t i) const {
-			DCHECK(m_bv[i]);
-			return m_rank.rank(i+1);
+			DCHECK(m_rank.bit(i));
+			return m_rank.rank1(i);
 		}
 
 		void decode(const std::vector<len_compact_t>& m_target_pos, const std::vector<len_compact_t>& m_source_pos, const std::vector<len_compact_t>& m_length) {
@@ -71,7 +70,7 @@ namespace lcpcomp {
 					if(m_buffer[source_position+i]) {
 						decode_literal_at(target_position+i, m_buffer[source_position+i]);
 					} else {
-						DCHECK_EQ(m_bv[source_position+i],1);
+						DCHECK(m_rank.bit(source_position+i));
 						len_compact_t*& bucket = m_fwd[rank(source_position+i)];
 						if(bucket == nullptr) {
 							bucket = new len_compact_t[2];
@@ -105,7 +104,7 @@ namespace lcpcomp {
         m_buffer[pos] = c;
 		DCHECK(c != 0 || pos == m_buffer.size()-1); // we assume that the text to restore does not contain a NULL-byte but at its very end
 
-		if(m_bv[pos] == 1) {
+		if(m_rank.bit(pos)) {
 			const len_t rankpos = rank(pos);
 			DCHECK_LE(rankpos, m_empty_entries);
 			if(m_fwd[rankpos] != nullptr) {
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+#include <tudocomp/Range.hpp>
+
+#include <tudocomp/coders/EliasGammaCoder.hpp>
+#include <tudocomp/coders/HuffmanCoder.hpp>
+
+namespace tdc {
+namespace lzss {
+
+/// Cost model of the default binary encoding of \ref tdc::Encoder (as used
+/// by \ref BitCoder), where the cost of a value only depends on its range.
+class BinaryCostModel {
+public:
+    template<typename text_t>
+    inline BinaryCostModel(const text_t&) {
+    }
+
+    /// Returns the cost of a literal.
+    inline size_t literal(uliteral_t) const {
+        return bits_for(literal_r.max());
+    }
+
+    /// Returns the cost of value \c v in range \c r.
+    inline size_t value(size_t, const Range& r) const {
+        return bits_for(r.max() - r.min());
+    }
+
+    /// Returns the largest value in range \c r that costs as much as \c v.
+    inline size_t class_end(size_t, const Range& r) const {
+        return r.max();
+    }
+};
+
+/// Estimates the amount of bits a coder spends on the values written by
+/// \ref encode_text.
+///
+/// Coders without a specialization are assumed to encode values in binary
+/// (see \ref BinaryCostModel).
+template<typename coder_t>
+class CostModel : public BinaryCostModel {
+public:
+    using BinaryCostModel::BinaryCostModel;
+};
+
+/// Cost model of \ref EliasGammaCoder, which writes every value as an
+/// Elias-gamma code regardless of its range.
+template<>
+class CostModel<EliasGammaCoder> {
+public:
+    template<typename text_t>
+    inline CostModel(const text_t&) {
+    }
+
+    inline size_t literal(uliteral_t c) const {
+        return 2 * bits_for(c) + 1;
+    }
+
+    inline size_t value(size_t v, const Range&) const {
+        return 2 * bits_for(v) + 1;
+    }
+
+    inline size_t class_end(size_t v, const Range& r) const {
+        return std::min<size_t>(r.max(), (size_t(1) << bits_for(v)) - 1);
+    }
+};
+
+/// Cost model of \ref HuffmanCoder, which writes literals as Huffman codes
+/// and all other values in binary.
+///
+/// The code lengths of literals are estimated from the symbol frequencies
+/// of the whole text, as the literals remaining after factorization are not
+/// known in advance.
+template<>
+class CostModel<HuffmanCoder> : public BinaryCostModel {
+private:
+    std::array<uint8_t, ULITERAL_MAX + 1> m_literal;
+
+public:
+    template<typename text_t>
+    inline CostModel(const text_t& text) : BinaryCostModel(text) {
+        m_literal.fill(bits_for(literal_r.max()));
+
+        len_compact_t C[ULITERAL_MAX + 1];
+        std::memset(C, 0, sizeof(C));
+        for(size_t i = 0; i < text.size(); ++i) {
+            ++C[uliteral_t(text[i])];
+        }
+
+        const len_t alphabet_size = huff::effective_alphabet_size(C);
+        if(alphabet_size > 1) {
+            const uliteral_t* map = huff::gen_effective_alphabet(C, alphabet_size);
+            const uint8_t* lengths = huff::gen_codelengths(C, map, alphabet_size);
+            for(size_t i = 0; i < alphabet_size; ++i) {
+                m_literal[map[i]] = lengths[i];
+            }
+            delete[] lengths;
+            delete[] map;
+        }
+    }
+
+    inline size_t literal(uliteral_t c) const {
+        return m_literal[c];
+    }
+};
+
+/// Cost model of \ref HuffmanStreamsCoder, which codes literals like
+/// \ref HuffmanCoder.
+template<>
+class CostModel<HuffmanStreamsCoder> : public CostModel<HuffmanCoder> {
+public:
+    using CostModel<HuffmanCoder>::CostModel;
+};
+
+}} //ns
+
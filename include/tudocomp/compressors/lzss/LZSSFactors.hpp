@@ -1,10 +1,15 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
 #include <vector>
 #include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
 
 #include <tudocomp/ds/IntVector.hpp>
+#include <tudocomp/util/Parallel.hpp>
 #include <tudocomp_stat/StatPhase.hpp>
 
 namespace tdc {
@@ -20,115 +25,667 @@ public:
 }  __attribute__((__packed__));
 
 
+/// \cond INTERNAL
+/// Factors stored as a plain array, with each field stored as an \c int_t.
+template<typename int_t = len_compact_t>
+class FactorArray {
+private:
+    struct Entry {
+        int_t pos, src, len;
+    } __attribute__((__packed__));
+
+    std::vector<Entry> m_factors;
+
+    inline static Entry entry(const Factor& f) {
+        return Entry { int_t(len_t(f.pos)), int_t(len_t(f.src)), int_t(len_t(f.len)) };
+    }
+
+public:
+    /// Whether distinct factors may be written concurrently.
+    static constexpr bool concurrent_writes = true;
+
+    inline size_t size() const { return m_factors.size(); }
+
+    inline Factor get(size_t i) const {
+        const Entry& e = m_factors[i];
+        return Factor(e.pos, e.src, e.len);
+    }
+
+    inline void set(size_t i, const Factor& f) { m_factors[i] = entry(f); }
+    inline len_t pos(size_t i) const { return m_factors[i].pos; }
+    inline void set_src(size_t i, len_t src) { m_factors[i].src = src; }
+
+    inline void push_back(const Factor& f) { m_factors.push_back(entry(f)); }
+
+    /// Returns an empty array for \c n factors of the same format.
+    inline FactorArray with_size(size_t n) const {
+        FactorArray a;
+        a.m_factors.resize(n, entry(Factor(0, 0, 0)));
+        return a;
+    }
+
+    inline void shrink_to_fit(len_t /*longest*/) {
+        m_factors.shrink_to_fit();
+    }
+};
+
+/// Factors stored bit-packed, with separate arrays for the positions,
+/// sources and lengths.
+class PackedFactorArray {
+private:
+    DynamicIntVector m_pos;
+    DynamicIntVector m_src;
+    DynamicIntVector m_len;
+
+public:
+    /// Bit-packed entries share machine words, so distinct factors must not
+    /// be written concurrently.
+    static constexpr bool concurrent_writes = false;
+
+    inline PackedFactorArray() {
+    }
+
+    inline PackedFactorArray(uint8_t pos_width, uint8_t len_width)
+        : m_pos(0, 0, pos_width),
+          m_src(0, 0, pos_width),
+          m_len(0, 0, len_width) {
+    }
+
+    inline size_t size() const { return m_pos.size(); }
+
+    inline Factor get(size_t i) const {
+        return Factor(m_pos[i], m_src[i], m_len[i]);
+    }
+
+    inline void set(size_t i, const Factor& f) {
+        m_pos[i] = len_t(f.pos);
+        m_src[i] = len_t(f.src);
+        m_len[i] = len_t(f.len);
+    }
+
+    inline len_t pos(size_t i) const { return m_pos[i]; }
+    inline void set_src(size_t i, len_t src) { m_src[i] = src; }
+
+    inline void push_back(const Factor& f) {
+        m_pos.push_back(len_t(f.pos));
+        m_src.push_back(len_t(f.src));
+        m_len.push_back(len_t(f.len));
+    }
+
+    inline PackedFactorArray with_size(size_t n) const {
+        PackedFactorArray a;
+        a.m_pos = DynamicIntVector(n, 0, m_pos.width());
+        a.m_src = DynamicIntVector(n, 0, m_src.width());
+        a.m_len = DynamicIntVector(n, 0, m_len.width());
+        return a;
+    }
+
+    inline void shrink_to_fit(len_t longest) {
+        m_len.width(bits_for(longest));
+        m_pos.shrink_to_fit();
+        m_src.shrink_to_fit();
+        m_len.shrink_to_fit();
+    }
+
+    inline uint8_t pos_width() const { return m_pos.width(); }
+    inline uint8_t len_width() const { return m_len.width(); }
+};
+
+/// Stable LSD radix sort of factors by their positions.
+///
+/// Each pass distributes the factors by one digit of their positions into a
+/// second array of the same size. The histogram of each pass is computed by
+/// \c threads threads on contiguous chunks, as is the distribution if the
+/// array allows concurrent writes.
+template<typename array_t>
+inline void radix_sort_factors(array_t& a, const len_t max_pos, size_t threads) {
+    static constexpr size_t DIGIT_BITS = 11;
+    static constexpr size_t RADIX = size_t(1) << DIGIT_BITS;
+
+    const size_t n = a.size();
+    threads = std::max<size_t>(1, std::min(threads, n / RADIX));
+
+    std::vector<size_t> bounds(threads + 1);
+    for(size_t t = 0; t <= threads; ++t) bounds[t] = n * t / threads;
+
+    array_t b = a.with_size(n);
+    std::vector<size_t> offsets(threads * RADIX);
+
+    for(size_t shift = 0; shift < bits_for(max_pos); shift += DIGIT_BITS) {
+        auto digit = [&](len_t pos) {
+            return (size_t(pos) >> shift) & (RADIX - 1);
+        };
+
+        // count digits per chunk
+        std::fill(offsets.begin(), offsets.end(), 0);
+        parallel_run(threads, [&](size_t t) {
+            size_t* hist = offsets.data() + t * RADIX;
+            for(size_t i = bounds[t]; i < bounds[t + 1]; ++i) {
+                ++hist[digit(a.pos(i))];
+            }
+        });
+
+        // skip passes over a digit that is equal for all factors
+        bool trivial = false;
+        for(size_t d = 0; d < RADIX && !trivial; ++d) {
+            size_t count = 0;
+            for(size_t t = 0; t < threads; ++t) count += offsets[t * RADIX + d];
+            trivial = (count == n);
+        }
+        if(trivial) continue;
+
+        // turn counts into target offsets, chunk by chunk within each digit
+        size_t sum = 0;
+        for(size_t d = 0; d < RADIX; ++d) {
+            for(size_t t = 0; t < threads; ++t) {
+                const size_t count = offsets[t * RADIX + d];
+                offsets[t * RADIX + d] = sum;
+                sum += count;
+            }
+        }
+
+        // distribute
+        auto distribute = [&](size_t t) {
+            size_t* offset = offsets.data() + t * RADIX;
+            for(size_t i = bounds[t]; i < bounds[t + 1]; ++i) {
+                b.set(offset[digit(a.pos(i))]++, a.get(i));
+            }
+        };
+        if(array_t::concurrent_writes) {
+            parallel_run(threads, distribute);
+        } else {
+            for(size_t t = 0; t < threads; ++t) distribute(t);
+        }
+        std::swap(a, b);
+    }
+}
+/// \endcond
+
+/// Buffers the factors of a text's factorization.
+///
+/// By default, factors are stored as an array of \ref Factor. If the length
+/// of the text is known, the fields are stored as 32- or 40-bit integers
+/// instead if these suffice and are narrower than \ref len_compact_t. For
+/// large amounts of factors, the buffer can be constructed in compact mode,
+/// in which positions and sources are bit-packed to the width required by
+/// the text length, and lengths to the width required by the longest factor
+/// once \ref shrink_to_fit is called.
 class FactorBuffer {
 private:
-    std::vector<Factor> m_factors;
+    /// The array storing the factors.
+    enum class Storage : uint8_t { plain, plain32, plain40, packed };
+
+    FactorArray<> m_factors;
+    FactorArray<uint32_t> m_factors32;
+    FactorArray<uint_t<40>> m_factors40;
+    PackedFactorArray m_packed;
+    Storage m_storage;
+
     bool m_sorted; //! factors need to be sorted before they are output
 
     len_t m_shortest_factor;
     len_t m_longest_factor;
 
+    /// Calls \c f with the array storing the factors of \c buffer, which
+    /// may be const.
+    template<typename buffer_t, typename f_t>
+    inline static auto with_array(buffer_t& buffer, f_t f)
+        -> decltype(f(buffer.m_factors)) {
+
+        switch(buffer.m_storage) {
+            case Storage::plain32: return f(buffer.m_factors32);
+            case Storage::plain40: return f(buffer.m_factors40);
+            case Storage::packed:  return f(buffer.m_packed);
+            default:               return f(buffer.m_factors);
+        }
+    }
+
+    inline len_t pos(size_t i) const {
+        return with_array(*this, [&](const auto& a) { return a.pos(i); });
+    }
+
+    inline void set_src(size_t i, len_t src) {
+        with_array(*this, [&](auto& a) { a.set_src(i, src); });
+    }
+
 public:
-    using const_iterator = std::vector<Factor>::const_iterator;
+    /// Iterates over the factors of a buffer by value.
+    class const_iterator {
+    private:
+        const FactorBuffer* m_buffer;
+        size_t m_index;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Factor;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Factor*;
+        using reference = Factor;
+
+        /// Proxy that allows accessing fields via \c ->.
+        class arrow_proxy {
+            Factor m_factor;
+        public:
+            inline arrow_proxy(const Factor& f) : m_factor(f) {}
+            inline const Factor* operator->() const { return &m_factor; }
+        };
+
+        inline const_iterator(const FactorBuffer& buffer, size_t index)
+            : m_buffer(&buffer), m_index(index) {
+        }
 
+        inline Factor operator*() const { return (*m_buffer)[m_index]; }
+        inline arrow_proxy operator->() const { return arrow_proxy(**this); }
+
+        inline const_iterator& operator++() { ++m_index; return *this; }
+        inline const_iterator& operator--() { --m_index; return *this; }
+        inline const_iterator operator++(int) { auto r = *this; ++m_index; return r; }
+        inline const_iterator operator--(int) { auto r = *this; --m_index; return r; }
+
+        inline const_iterator operator+(difference_type d) const {
+            return const_iterator(*m_buffer, m_index + d);
+        }
+        inline const_iterator operator-(difference_type d) const {
+            return const_iterator(*m_buffer, m_index - d);
+        }
+        inline difference_type operator-(const const_iterator& other) const {
+            return difference_type(m_index) - difference_type(other.m_index);
+        }
+
+        inline bool operator==(const const_iterator& other) const {
+            return m_index == other.m_index;
+        }
+        inline bool operator!=(const const_iterator& other) const {
+            return m_index != other.m_index;
+        }
+        inline bool operator<(const const_iterator& other) const {
+            return m_index < other.m_index;
+        }
+    };
+
+    /// Constructs an empty buffer storing factors as plain array.
     inline FactorBuffer()
-        : m_sorted(true)
+        : m_storage(Storage::plain)
+        , m_sorted(true)
         , m_shortest_factor(INDEX_MAX)
         , m_longest_factor(0)
     {
     }
 
+    /// Constructs an empty buffer for the factors of a text.
+    ///
+    /// \param text_length the length of the text.
+    /// \param compact whether to store factors bit-packed.
+    inline FactorBuffer(size_t text_length, bool compact) : FactorBuffer() {
+        const size_t w = index_width(text_length);
+        if(compact) {
+            m_storage = Storage::packed;
+            m_packed = PackedFactorArray(bits_for(text_length), bits_for(text_length));
+        } else if(w == 32 && INDEX_BITS > 32) {
+            m_storage = Storage::plain32;
+        } else if(w == 40 && INDEX_BITS > 40) {
+            m_storage = Storage::plain40;
+        }
+    }
+
     inline void emplace_back(len_t fpos, len_t fsrc, len_t flen) {
-        m_sorted = m_sorted && (m_factors.empty() || fpos >= m_factors.back().pos);
-        m_factors.emplace_back(fpos, fsrc, flen);
+        m_sorted = m_sorted && (empty() || fpos >= pos(size() - 1));
+
+        const Factor f(fpos, fsrc, flen);
+        with_array(*this, [&](auto& a) { a.push_back(f); });
 
         m_shortest_factor = std::min(m_shortest_factor, flen);
         m_longest_factor = std::max(m_longest_factor, flen);
     }
 
+    inline Factor operator[](size_t i) const {
+        return with_array(*this, [&](const auto& a) { return a.get(i); });
+    }
+
     inline const_iterator begin() const {
-        return m_factors.cbegin();
+        return const_iterator(*this, 0);
     }
 
     inline const_iterator end() const {
-        return m_factors.cend();
+        return const_iterator(*this, size());
     }
 
     inline bool empty() const {
-        return m_factors.empty();
+        return size() == 0;
     }
 
     inline size_t size() const {
-        return m_factors.size();
+        return with_array(*this, [](const auto& a) { return a.size(); });
+    }
+
+    inline bool is_compact() const {
+        return m_storage == Storage::packed;
+    }
+
+    /// Returns the amount of bits used to store a factor, or zero in
+    /// compact mode, in which the widths are not fixed.
+    inline size_t factor_bits() const {
+        switch(m_storage) {
+            case Storage::plain32: return 3 * 32;
+            case Storage::plain40: return 3 * 40;
+            case Storage::packed:  return 0;
+            default:               return 3 * INDEX_BITS;
+        }
     }
 
     inline bool is_sorted() const {
         return m_sorted;
     }
 
-    inline void sort() { //TODO: use radix sort
+    /// Releases unused memory once all factors have been added. In compact
+    /// mode, this also narrows the lengths to the width required by the
+    /// longest factor.
+    inline void shrink_to_fit() {
+        with_array(*this, [&](auto& a) { a.shrink_to_fit(m_longest_factor); });
+    }
+
+    /// Sorts the factors by their text positions, using a radix sort.
+    ///
+    /// \param threads the amount of threads to use.
+    inline void sort(size_t threads = 1) {
         if(!m_sorted) {
-            std::sort(m_factors.begin(), m_factors.end(),
-                [](const Factor& a, const Factor& b) -> bool { return a.pos < b.pos; });
+            len_t max_pos = 0;
+            for(size_t i = 0; i < size(); ++i) {
+                max_pos = std::max(max_pos, pos(i));
+            }
+
+            with_array(*this, [&](auto& a) { radix_sort_factors(a, max_pos, threads); });
 
             m_sorted = true;
         }
     }
 
+private:
+    /// Returns the index of the factor covering text position \c x plus one,
+    /// or zero if \c x is a literal.
+    inline size_t covering(len_t x) const {
+        // find the first factor starting after x
+        size_t lo = 0;
+        size_t hi = size();
+        while(lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if(pos(mid) <= x) lo = mid + 1;
+            else              hi = mid;
+        }
+
+        if(lo == 0) return 0;
+        const Factor f = (*this)[lo - 1];
+        return (x < f.pos + f.len) ? lo : 0;
+    }
+
+    /// Returns the reference depth of text position \c x.
+    ///
+    /// Follows the references from \c x until a literal or a position of
+    /// known depth is reached, and memoizes the depths of all positions on
+    /// the way (plus one, zero meaning unknown) in \c memo, which covers the
+    /// positions before \c end. Each depth is passed through \c limit before
+    /// it is assigned, which may lower it.
+    template<typename limit_t>
+    inline len_t resolve_depth(len_t x, std::atomic<len_t>* memo,
+                               len_t end, std::vector<len_t>& stack,
+                               limit_t limit) const {
+        stack.clear();
+
+        len_t depth;
+        while(true) {
+            if(x >= end) {
+                depth = 0;
+                break;
+            }
+
+            const len_t m = memo[x].load(std::memory_order_relaxed);
+            if(m) {
+                depth = m - 1;
+                break;
+            }
+
+            const size_t k = covering(x);
+            if(k == 0) {
+                memo[x].store(1, std::memory_order_relaxed);
+                depth = 0;
+                break;
+            }
+
+            DCHECK_LT(stack.size(), end) << "cyclic factor references";
+            stack.push_back(x);
+
+            const Factor f = (*this)[k - 1];
+            x = f.src + (x - f.pos);
+        }
+
+        while(!stack.empty()) {
+            x = stack.back();
+            stack.pop_back();
+
+            depth = limit(x, depth + 1);
+            memo[x].store(depth + 1, std::memory_order_relaxed);
+        }
+        return depth;
+    }
+
+    /// Returns the end of the text range covered by factors.
+    inline len_t covered_end() const {
+        if(empty()) return 0;
+        const Factor last = (*this)[size() - 1];
+        return last.pos + last.len;
+    }
+
+    /// Replaces the factors by the parts between the given positions, which
+    /// become literals. Parts shorter than \c min_len become literals as well.
+    template<typename array_t>
+    inline void split_factors(array_t& a, const std::vector<len_t>& holes,
+                              const len_t min_len) {
+        array_t b = a.with_size(0);
+        m_shortest_factor = INDEX_MAX;
+        m_longest_factor = 0;
+
+        auto keep = [&](const Factor& f) {
+            b.push_back(f);
+            m_shortest_factor = std::min(m_shortest_factor, len_t(f.len));
+            m_longest_factor = std::max(m_longest_factor, len_t(f.len));
+        };
+
+        size_t h = 0;
+        for(size_t i = 0; i < a.size(); ++i) {
+            const Factor f = a.get(i);
+            const len_t end = f.pos + f.len;
+            if(h == holes.size() || holes[h] >= end) {
+                keep(f);
+                continue;
+            }
+
+            len_t p = f.pos;
+            auto keep_part = [&](len_t part_end) {
+                if(part_end - p >= std::max<len_t>(min_len, 1)) {
+                    keep(Factor(p, f.src + (p - f.pos), part_end - p));
+                }
+            };
+
+            for(; h < holes.size() && holes[h] < end; ++h) {
+                DCHECK_GE(holes[h], p);
+                keep_part(holes[h]);
+                p = holes[h] + 1;
+            }
+            keep_part(end);
+        }
+
+        a = std::move(b);
+    }
+
 public:
-    inline void flatten() {
-        if(m_factors.empty()) return; //nothing to do
+    /// Redirects the source of each factor to the end of its reference
+    /// chain.
+    ///
+    /// As long as the source range of a factor lies within another factor,
+    /// it is replaced by the corresponding range of that factor's source.
+    /// The factors are split into \c threads contiguous ranges that are
+    /// processed concurrently. Chains are shortened by using the new sources
+    /// of factors of the same range that are already flattened. As the end
+    /// of a chain does not depend on which of its links are skipped, the
+    /// result does not depend on the amount of threads.
+    ///
+    /// \param threads the amount of threads to use.
+    inline void flatten(size_t threads = 1) {
+        if(empty()) return; //nothing to do
 
         CHECK(m_sorted)
             << "factors need to be sorted before they can be flattened";
 
-        // create pos -> factor map
-        auto& last = m_factors.back();
-        DynamicIntVector fmap(
-            last.pos + last.len,
-            0,
-            bits_for(m_factors.size() + 1));
-
-        for(size_t i = 0; i < m_factors.size(); i++) {
-            auto& f = m_factors[i];
-            for(size_t j = 0; j < f.len; j++) {
-                fmap[f.pos + j] = i + 1;
+        const size_t z = size();
+        threads = std::max<size_t>(1, std::min(threads, z));
+
+        std::vector<size_t> bounds(threads + 1);
+        for(size_t t = 0; t <= threads; ++t) bounds[t] = z * t / threads;
+
+        len_t src_end = 0;
+        for(size_t i = 0; i < z; ++i) {
+            const Factor f = (*this)[i];
+            src_end = std::max(src_end, len_t(f.src + f.len));
+        }
+
+        // flattened sources of each range, written back afterwards so that
+        // all threads read the original factors
+        std::vector<DynamicIntVector> flat(threads);
+        std::vector<size_t> num_flattened(threads, 0);
+
+        parallel_run(threads, [&](size_t t) {
+            const size_t begin = bounds[t];
+            DynamicIntVector out(bounds[t + 1] - begin, 0, bits_for(src_end));
+            size_t count = 0;
+
+            for(size_t i = begin; i < bounds[t + 1]; ++i) {
+                const Factor f = (*this)[i];
+
+                len_t src = f.src;
+                for(size_t k; (k = covering(src)) > 0;) {
+                    const size_t j = k - 1;
+                    const Factor s = (*this)[j];
+
+                    const len_t d = src - s.pos;
+                    if(d + f.len > s.len) break;
+
+                    const len_t s_src = (j >= begin && j < i)
+                        ? len_t(out[j - begin]) : len_t(s.src);
+                    src = s_src + d;
+                }
+
+                out[i - begin] = src;
+                if(src != f.src) ++count;
             }
+
+            flat[t] = std::move(out);
+            num_flattened[t] = count;
+        });
+
+        size_t total = 0;
+        for(size_t t = 0; t < threads; ++t) {
+            for(size_t i = bounds[t]; i < bounds[t + 1]; ++i) {
+                set_src(i, flat[t][i - bounds[t]]);
+            }
+            flat[t] = DynamicIntVector();
+            total += num_flattened[t];
         }
 
-        // process factors
-        size_t num_flattened = 0;
-        size_t max_depth = 0;
-        for(auto& f : m_factors) {
-            size_t depth = 0;
+        StatPhase::log("num_flattened", total);
+    }
 
-            size_t src = f.src;
-            while(src < fmap.size() && fmap[src]) {
-                auto& s = m_factors[fmap[src] - 1];
+    /// Computes the reference depth of the factorization.
+    ///
+    /// The depth of a literal is zero, and the depth of a position covered
+    /// by a factor is one more than the depth of its source position. A
+    /// decoder that copies all factors in a scan over the text needs as many
+    /// scans as the maximum depth. The factors are split into \c threads
+    /// contiguous ranges whose positions are resolved concurrently, sharing
+    /// memoized depths.
+    ///
+    /// \param threads the amount of threads to use.
+    /// \return the maximum depth of all text positions.
+    inline len_t depth(size_t threads = 1) const {
+        if(empty()) return 0;
 
-                size_t d = src - s.pos;
-                if((s.src + d + f.len) <= (s.src + s.len)) {
-                    src = s.src + d;
+        CHECK(m_sorted)
+            << "factors need to be sorted to determine their depth";
+
+        const size_t z = size();
+        threads = std::max<size_t>(1, std::min(threads, z));
+
+        const len_t end = covered_end();
+        std::unique_ptr<std::atomic<len_t>[]> memo(
+            new std::atomic<len_t>[end]);
+        for(len_t x = 0; x < end; ++x) {
+            memo[x].store(0, std::memory_order_relaxed);
+        }
 
-                    //FIXME: actually, one would have to add the flatten
-                    //       depth of the referred factors recursively,
-                    //       so the depth here is only a lower bound
-                    ++depth;
-                } else {
-                    break;
+        std::vector<len_t> max_depth(threads, 0);
+        parallel_run(threads, [&](size_t t) {
+            std::vector<len_t> stack;
+            len_t max = 0;
+            for(size_t i = z * t / threads; i < z * (t + 1) / threads; ++i) {
+                const Factor f = (*this)[i];
+                for(len_t x = f.pos; x < f.pos + f.len; ++x) {
+                    max = std::max(max, resolve_depth(x, memo.get(), end, stack,
+                        [](len_t, len_t d) { return d; }));
                 }
             }
-            
-            if(depth) {
-                f.src = src;
+            max_depth[t] = max;
+        });
 
-                ++num_flattened;
-                max_depth = std::max(max_depth, depth);
+        return *std::max_element(max_depth.begin(), max_depth.end());
+    }
+
+    /// Bounds the reference depth (see \ref depth) of all text positions.
+    ///
+    /// Text positions are resolved in text order. Whenever the depth of a
+    /// position would exceed \c max_depth, the position is turned into a
+    /// literal, splitting the factor covering it. Parts of split factors that
+    /// are shorter than \c min_len are turned into literals as well. Since
+    /// turning positions into literals never increases the depth of others,
+    /// the bound holds for all positions afterwards.
+    ///
+    /// \param max_depth the maximum depth, at least one.
+    /// \param min_len the minimum length of factor parts.
+    /// \return the amount of positions that exceeded the maximum depth.
+    inline size_t bound_depth(const len_t max_depth, const len_t min_len) {
+        if(empty()) return 0;
+
+        CHECK(m_sorted)
+            << "factors need to be sorted to bound their depth";
+        CHECK_GE(max_depth, 1U) << "the maximum depth must be positive";
+
+        const len_t end = covered_end();
+        std::unique_ptr<std::atomic<len_t>[]> memo(
+            new std::atomic<len_t>[end]);
+        for(len_t x = 0; x < end; ++x) {
+            memo[x].store(0, std::memory_order_relaxed);
+        }
+
+        std::vector<len_t> holes;
+        std::vector<len_t> stack;
+        for(size_t i = 0; i < size(); ++i) {
+            const Factor f = (*this)[i];
+            for(len_t x = f.pos; x < f.pos + f.len; ++x) {
+                resolve_depth(x, memo.get(), end, stack, [&](len_t y, len_t d) {
+                    if(d <= max_depth) return d;
+                    holes.push_back(y);
+                    return len_t(0);
+                });
             }
         }
+        memo.reset();
+
+        if(!holes.empty()) {
+            std::sort(holes.begin(), holes.end());
+            with_array(*this, [&](auto& a) { split_factors(a, holes, min_len); });
+            shrink_to_fit();
+        }
 
-        StatPhase::log("num_flattened", num_flattened);
-        StatPhase::log("max_depth_lb", max_depth);
+        StatPhase::log("num_cut", holes.size());
+        return holes.size();
     }
 
     inline size_t shortest_factor() const {
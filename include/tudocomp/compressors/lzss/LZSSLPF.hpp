@@ -0,0 +1,90 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+
+#include <tudocomp/ds/IntVector.hpp>
+
+namespace tdc {
+namespace lzss {
+
+/// Longest previous factor (LPF) array of a text, storing for each text
+/// position \c i the length of the longest prefix of suffix \c i that also
+/// occurs at an earlier position, together with such a source position.
+///
+/// The array is computed from the suffix and LCP arrays in linear time: the
+/// candidates for the source of suffix \c i are the previous and next smaller
+/// values (PSV and NSV) of \c i in the suffix array, which a single stack
+/// based pass over the suffix array in lexicographic order yields. Neither
+/// the inverse suffix array nor any scanning of the LCP array is needed.
+class LPF {
+private:
+    DynamicIntVector m_len;
+    DynamicIntVector m_src;
+
+public:
+    /// Computes the LPF array.
+    ///
+    /// \param sa the suffix array of the text.
+    /// \param lcp the LCP array of the text, with \c lcp[0] being zero.
+    /// \param n the text length.
+    template<typename sa_t, typename lcp_t>
+    inline LPF(const sa_t& sa, const lcp_t& lcp, const len_t n)
+        : m_len(n, 0, bits_for(n))
+        , m_src(n, 0, bits_for(n))
+    {
+        // stack of (SA position, minimum LCP between that position and the
+        // one beneath it on the stack); text positions along the stack
+        // are increasing
+        std::vector<std::pair<len_t, len_t>> stack;
+
+        for(len_t r = 0; r < n; ++r) {
+            const len_t cur = sa[r];
+
+            // minimum LCP between the stack top and r
+            len_t h = lcp[r];
+
+            // r is the NSV of all suffixes on the stack with larger text
+            // positions
+            while(!stack.empty() && len_t(sa[stack.back().first]) > cur) {
+                const len_t e = stack.back().first;
+                const len_t e_pos = sa[e];
+                if(h > m_len[e_pos]) {
+                    m_len[e_pos] = h;
+                    m_src[e_pos] = cur;
+                }
+                h = std::min(h, stack.back().second);
+                stack.pop_back();
+            }
+
+            // the stack top, if any, is the PSV of r
+            if(!stack.empty()) {
+                m_len[cur] = h;
+                m_src[cur] = sa[stack.back().first];
+            } else {
+                h = 0;
+            }
+            stack.emplace_back(r, h);
+        }
+    }
+
+    /// Returns the length of the longest previous factor at position \c i.
+    inline len_t len(len_t i) const {
+        return m_len[i];
+    }
+
+    /// Returns the source position of the longest previous factor at
+    /// position \c i. Only meaningful if \ref len(i) is non-zero.
+    inline len_t src(len_t i) const {
+        return m_src[i];
+    }
+
+    inline len_t size() const {
+        return m_len.size();
+    }
+};
+
+}} //ns
+
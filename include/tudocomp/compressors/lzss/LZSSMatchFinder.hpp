@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+
+#include <tudocomp/compressors/lzss/LZSSWindowBuffer.hpp>
+
+namespace tdc {
+namespace lzss {
+
+/// A match found in a sliding window.
+struct WindowMatch {
+    /// The source position of the match.
+    size_t src;
+
+    /// The length of the match, zero if none was found.
+    size_t len;
+};
+
+/// Finds matches by comparing the current position against every position
+/// in the window.
+///
+/// Takes time linear in the window size per position. Among the longest
+/// matches, the one farthest away is reported.
+class NaiveMatchFinder {
+private:
+    const WindowBuffer* m_buf;
+    size_t m_window;
+
+public:
+    inline NaiveMatchFinder(const WindowBuffer& buf, size_t window,
+                            size_t /*max_chain*/, size_t /*min_len*/)
+        : m_buf(&buf), m_window(window) {
+    }
+
+    /// Finds the longest match for position \c p, with length at most
+    /// \c max_len.
+    inline WindowMatch find(size_t p, size_t max_len) {
+        WindowMatch best { 0, 0 };
+        for(size_t q = (p > m_window) ? p - m_window : 0; q < p; ++q) {
+            const size_t len = m_buf->match_length(q, p, max_len);
+            if(len > best.len) best = WindowMatch { q, len };
+        }
+        return best;
+    }
+
+    /// Notifies the finder of a position that is skipped by a factor.
+    inline void insert(size_t, size_t) {
+    }
+};
+
+/// \cond INTERNAL
+/// Common state of the hash based match finders.
+///
+/// Per position data is kept in a cyclic array of window size plus one
+/// slots. Positions are stored as their 32 least significant bits (plus
+/// one), and are reconstructed relative to the current position. Since only
+/// positions within the window are ever followed, this is exact for windows
+/// below 4 GiB, regardless of the input size.
+class HashedMatchFinderBase {
+protected:
+    const WindowBuffer* m_buf;
+
+    size_t m_max_dist;
+    size_t m_max_chain;
+    size_t m_hash_len;
+
+    size_t m_win_size;
+    uint8_t m_hash_shift;
+    std::vector<uint32_t> m_head;
+
+    inline HashedMatchFinderBase(const WindowBuffer& buf, size_t window,
+                                 size_t max_chain, size_t min_len)
+        : m_buf(&buf),
+          m_max_chain(std::max<size_t>(max_chain, 1)),
+          m_hash_len(std::min<size_t>(std::max<size_t>(min_len, 1), 4)) {
+
+        // the slot of a position is reused by the position win_size later
+        m_win_size = window + 1;
+        m_max_dist = window;
+
+        const uint8_t hash_bits = std::min<size_t>(
+            std::min<size_t>(std::max<size_t>(bits_for(window) + 1, 8), 22),
+            8 * m_hash_len);
+        m_hash_shift = 32 - hash_bits;
+        m_head.resize(1ULL << hash_bits, 0);
+    }
+
+    inline size_t win_size() const {
+        return m_win_size;
+    }
+
+    /// Returns the window slot of the position at distance \c d from the
+    /// position in slot \c slot.
+    inline size_t slot_before(size_t slot, size_t d) const {
+        return (slot >= d) ? slot - d : slot + m_win_size - d;
+    }
+
+    inline static uint32_t encode(size_t q) {
+        return uint32_t(q + 1);
+    }
+
+    /// Returns the distance of the stored position \c e from \c p, or zero
+    /// if it is not a valid position within the window.
+    inline size_t distance(size_t p, uint32_t e) const {
+        const size_t d = uint32_t(uint32_t(p + 1) - e);
+        return (d <= p && d <= m_max_dist) ? d : 0;
+    }
+
+    inline size_t hash(size_t p) const {
+        uint32_t h = 0;
+        for(size_t i = 0; i < m_hash_len; ++i) {
+            h = (h << 8) | (*m_buf)[p + i];
+        }
+        return uint32_t(h * 0x9E3779B1U) >> m_hash_shift;
+    }
+};
+/// \endcond
+
+/// Finds matches by following chains of previous positions sharing the hash
+/// of their first few bytes.
+///
+/// At most \c max_chain candidates are compared per position, and the
+/// search stops as soon as a match of maximum length is found. Among the
+/// longest matches found, the closest one is reported. Matches shorter
+/// than the hashed prefix (the minimum factor length, at most four) are not
+/// found.
+class HashChainMatchFinder : public HashedMatchFinderBase {
+private:
+    std::vector<uint32_t> m_prev;
+
+    inline uint32_t link(size_t p, size_t slot) {
+        const size_t h = hash(p);
+        const uint32_t next = m_head[h];
+        m_head[h] = encode(p);
+        m_prev[slot] = next;
+        return next;
+    }
+
+public:
+    inline HashChainMatchFinder(const WindowBuffer& buf, size_t window,
+                                size_t max_chain, size_t min_len)
+        : HashedMatchFinderBase(buf, window, max_chain, min_len),
+          m_prev(win_size(), 0) {
+    }
+
+    /// Finds the longest match for position \c p, with length at most
+    /// \c max_len, and inserts \c p.
+    inline WindowMatch find(size_t p, size_t max_len) {
+        WindowMatch best { 0, 0 };
+        if(max_len < m_hash_len) return best;
+
+        const size_t slot = p % m_win_size;
+        uint32_t next = link(p, slot);
+        for(size_t chain = m_max_chain; chain > 0; --chain) {
+            const size_t d = distance(p, next);
+            if(d == 0) break;
+
+            const size_t q = p - d;
+
+            // a candidate can only be longer if it matches at the end of the
+            // best match so far
+            if((*m_buf)[q + best.len] == (*m_buf)[p + best.len]) {
+                const size_t len = m_buf->match_length(q, p, max_len);
+                if(len > best.len) {
+                    best = WindowMatch { q, len };
+                    if(len == max_len) break;
+                }
+            }
+            next = m_prev[slot_before(slot, d)];
+        }
+        return best;
+    }
+
+    /// Inserts position \c p, which is skipped by a factor.
+    inline void insert(size_t p, size_t max_len) {
+        if(max_len >= m_hash_len) link(p, p % m_win_size);
+    }
+};
+
+/// Finds matches using binary search trees of the window positions, one per
+/// hash of their first few bytes.
+///
+/// Each tree orders its positions lexicographically by their suffixes, and
+/// is rooted at the most recently inserted position. Inserting a position
+/// walks down the tree, which visits the positions with the longest common
+/// prefixes. At most \c max_chain nodes are visited. Among the longest
+/// matches found, the closest one is reported.
+///
+/// Each node comparison may compare up to \c max_len bytes, so this finder
+/// works best with a bounded lookahead.
+class BinaryTreeMatchFinder : public HashedMatchFinderBase {
+private:
+    // left and right child of each position in the window
+    std::vector<uint32_t> m_children;
+
+    inline WindowMatch insert_and_find(size_t p, size_t max_len) {
+        WindowMatch best { 0, 0 };
+
+        const size_t h = hash(p);
+        uint32_t next = m_head[h];
+        m_head[h] = encode(p);
+
+        // the child slots of the new node that remain to be filled: the
+        // left subtree collects positions with smaller suffixes, the right
+        // one those with larger suffixes
+        const size_t slot = p % m_win_size;
+        uint32_t* left = &m_children[2 * slot];
+        uint32_t* right = left + 1;
+
+        // common prefix lengths with the nodes bounding the left and right
+        // subtree, which any node between them shares as well
+        size_t left_len = 0;
+        size_t right_len = 0;
+
+        for(size_t depth = m_max_chain; depth > 0; --depth) {
+            const size_t d = distance(p, next);
+            if(d == 0) break;
+
+            const size_t q = p - d;
+            uint32_t* pair = &m_children[2 * slot_before(slot, d)];
+
+            size_t len = std::min(left_len, right_len);
+            len += m_buf->match_length(q + len, p + len, max_len - len);
+
+            if(len > best.len) best = WindowMatch { q, len };
+            if(len == max_len) {
+                // q is equal to p up to the compared length, p replaces it
+                *left = pair[0];
+                *right = pair[1];
+                return best;
+            }
+
+            if((*m_buf)[q + len] < (*m_buf)[p + len]) {
+                *left = encode(q);
+                left = pair + 1;
+                next = *left;
+                left_len = len;
+            } else {
+                *right = encode(q);
+                right = pair;
+                next = *right;
+                right_len = len;
+            }
+        }
+
+        *left = 0;
+        *right = 0;
+        return best;
+    }
+
+public:
+    inline BinaryTreeMatchFinder(const WindowBuffer& buf, size_t window,
+                                 size_t max_chain, size_t min_len)
+        : HashedMatchFinderBase(buf, window, max_chain, min_len),
+          m_children(2 * win_size(), 0) {
+    }
+
+    /// Finds the longest match for position \c p, with length at most
+    /// \c max_len, and inserts \c p.
+    inline WindowMatch find(size_t p, size_t max_len) {
+        if(max_len < m_hash_len) return WindowMatch { 0, 0 };
+        return insert_and_find(p, max_len);
+    }
+
+    /// Inserts position \c p, which is skipped by a factor.
+    inline void insert(size_t p, size_t max_len) {
+        if(max_len >= m_hash_len) insert_and_find(p, max_len);
+    }
+};
+
+}} //ns
+
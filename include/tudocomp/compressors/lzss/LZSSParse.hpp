@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+#include <tudocomp/Range.hpp>
+
+#include <tudocomp/ds/IntVector.hpp>
+
+#include <tudocomp/compressors/lzss/LZSSFactors.hpp>
+#include <tudocomp/compressors/lzss/LZSSLPF.hpp>
+
+#include <tudocomp_stat/StatPhase.hpp>
+
+namespace tdc {
+namespace lzss {
+
+// The parsers below factorize text positions [0, n-1), as the last
+// character of the text is the terminating zero byte, which is always
+// encoded as a literal.
+
+/// Greedily factorizes the text, always choosing the longest previous
+/// factor.
+inline void parse_greedy(const LPF& lpf, FactorBuffer& factors,
+                         const len_t threshold) {
+    const len_t n = lpf.size();
+    for(len_t i = 0; i + 1 < n;) {
+        const len_t len = lpf.len(i);
+        if(len >= threshold) {
+            DCHECK_LT(lpf.src(i), i);
+            factors.emplace_back(i, lpf.src(i), len);
+            i += len;
+        } else {
+            ++i;
+        }
+    }
+}
+
+/// Factorizes the text with lazy matching: a factor is deferred in favour
+/// of a literal if a longer one starts at the next position.
+inline void parse_lazy(const LPF& lpf, FactorBuffer& factors,
+                       const len_t threshold) {
+    const len_t n = lpf.size();
+    for(len_t i = 0; i + 1 < n;) {
+        const len_t len = lpf.len(i);
+        if(len >= threshold && lpf.len(i + 1) <= len) {
+            factors.emplace_back(i, lpf.src(i), len);
+            i += len;
+        } else {
+            ++i;
+        }
+    }
+}
+
+/// \cond INTERNAL
+/// Shortest path search over all factorizations of a text, weighted by the
+/// estimated cost of their encoding with \ref encode_text.
+template<typename text_t, typename model_t>
+class OptimalParser {
+private:
+    const text_t* m_text;
+    const LPF* m_lpf;
+    const model_t* m_model;
+    len_t m_threshold;
+
+    Range m_text_r;
+    Range m_flen_r;
+    Range m_fdist_r;
+
+    // costs of starting a literal run and of the flag preceding a factor
+    // that directly follows another one
+    size_t m_run_cost;
+    size_t m_flag_cost;
+
+    // cost of encoding text position i and all that follow, if the
+    // preceding phrase was a factor (A) or literal (B)
+    DynamicIntVector m_cost_a;
+    DynamicIntVector m_cost_b;
+
+    /// Calls \c f for each factor length considered at a position where
+    /// factors up to \c max_len are possible.
+    ///
+    /// Out of the lengths that are encoded with the same amount of bits, only
+    /// the longest one is considered, since parsing a shorter suffix of the
+    /// text usually costs less. Factors shorter than twice the threshold are
+    /// an exception, as shortening them may turn them into literals, so these
+    /// are all considered.
+    template<typename f_t>
+    inline void for_each_length(len_t max_len, f_t f) const {
+        len_t len = m_threshold;
+        const len_t short_end = std::min<len_t>(max_len, 2 * m_threshold - 1);
+        for(; len <= short_end; ++len) f(len);
+
+        while(len <= max_len) {
+            // lengths beyond the estimated range are all treated alike
+            const len_t end = m_model->class_end(len, m_flen_r);
+            len = (end >= len) ? std::min(max_len, end) : max_len;
+            f(len);
+            ++len;
+        }
+    }
+
+    /// Determines the best phrase at position \c i, returning its length
+    /// (zero for a literal) and setting \c cost to the cost of parsing the
+    /// text from position \c i.
+    inline len_t best_phrase(len_t i, bool after_factor, size_t& cost) const {
+        cost = m_model->literal((*m_text)[i]) + m_cost_b[i + 1] +
+               (after_factor ? m_run_cost : 0);
+        len_t best = 0;
+
+        const len_t max_len = m_lpf->len(i);
+        if(max_len >= m_threshold) {
+            const size_t src_cost = m_model->value(m_lpf->src(i), m_text_r) +
+                                    (after_factor ? m_flag_cost : 0);
+            for_each_length(max_len, [&](len_t len) {
+                const size_t c = src_cost +
+                    m_model->value(len, m_flen_r) + m_cost_a[i + len];
+                if(c <= cost) {
+                    cost = c;
+                    best = len;
+                }
+            });
+        }
+        return best;
+    }
+
+public:
+    inline OptimalParser(const text_t& text, const LPF& lpf,
+                         const model_t& model, const len_t threshold)
+        : m_text(&text), m_lpf(&lpf), m_model(&model),
+          m_threshold(std::max<len_t>(threshold, 1)),
+          m_text_r(lpf.size()), m_flen_r(0), m_fdist_r(0) {
+
+        const len_t n = lpf.size();
+
+        // estimate the ranges used by encode_text from the greedy
+        // factorization
+        len_t flen_max = m_threshold;
+        len_t fdist_max = 0;
+        {
+            len_t p = 0;
+            for(len_t i = 0; i + 1 < n;) {
+                const len_t len = lpf.len(i);
+                if(len >= m_threshold) {
+                    fdist_max = std::max(fdist_max, i - p);
+                    flen_max = std::max(flen_max, len);
+                    i += len;
+                    p = i;
+                } else {
+                    ++i;
+                }
+            }
+            fdist_max = std::max(fdist_max, n - p);
+        }
+        m_flen_r = MinDistributedRange(m_threshold, flen_max);
+        m_fdist_r = Range(fdist_max);
+
+        m_flag_cost = 1;
+        m_run_cost = 1 + model.value(1, m_fdist_r);
+
+        // the cost of parsing everything as literals bounds all costs
+        size_t max_cost = m_run_cost;
+        for(len_t i = 0; i < n; ++i) max_cost += model.literal(text[i]);
+
+        m_cost_a = DynamicIntVector(n + 1, 0, bits_for(max_cost));
+        m_cost_b = DynamicIntVector(n + 1, 0, bits_for(max_cost));
+
+        // the terminating zero byte is always a literal
+        if(n > 0) {
+            const size_t c = model.literal(text[n - 1]);
+            m_cost_a[n - 1] = m_run_cost + c;
+            m_cost_b[n - 1] = c;
+        }
+
+        for(len_t i = n - 1; i-- > 0;) {
+            size_t cost;
+            best_phrase(i, true, cost);
+            m_cost_a[i] = cost;
+            best_phrase(i, false, cost);
+            m_cost_b[i] = cost;
+        }
+    }
+
+    /// Returns the estimated cost of the optimal factorization in bits.
+    inline size_t cost() const {
+        return m_cost_a[0];
+    }
+
+    /// Appends the factors of the optimal factorization to \c factors.
+    inline void factorize(FactorBuffer& factors) const {
+        const len_t n = m_lpf->size();
+
+        bool after_factor = true;
+        for(len_t i = 0; i + 1 < n;) {
+            size_t cost;
+            const len_t len = best_phrase(i, after_factor, cost);
+            if(len > 0) {
+                factors.emplace_back(i, m_lpf->src(i), len);
+                i += len;
+                after_factor = true;
+            } else {
+                ++i;
+                after_factor = false;
+            }
+        }
+    }
+};
+/// \endcond
+
+/// Computes a factorization of the text with the least estimated encoding
+/// cost.
+///
+/// The factorization is found as a shortest path through the text
+/// positions, in which each factor refers to the source given by the
+/// \ref LPF array. The costs of all values written by \ref encode_text are
+/// estimated with \c model (see \ref CostModel), where the ranges that
+/// depend on the factorization are estimated from the greedy one.
+///
+/// \param text the input text, terminated by a zero byte.
+/// \param lpf the LPF array of the text.
+/// \param model the cost model.
+/// \param factors the factor buffer to append to.
+/// \param threshold the minimum factor length.
+template<typename text_t, typename model_t>
+inline void parse_optimal(const text_t& text, const LPF& lpf,
+                          const model_t& model, FactorBuffer& factors,
+                          const len_t threshold) {
+    OptimalParser<text_t, model_t> parser(text, lpf, model, threshold);
+    StatPhase::log("estimated_bits", parser.cost());
+    parser.factorize(factors);
+}
+
+}} //ns
+
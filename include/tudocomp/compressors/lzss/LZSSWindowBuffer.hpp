@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <istream>
+#include <vector>
+
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+#include <tudocomp/util/View.hpp>
+
+namespace tdc {
+namespace lzss {
+
+/// Circular buffer holding the part of an input stream that a sliding
+/// window factorization currently works on.
+///
+/// Bytes are addressed by their absolute position in the input. For a
+/// current position \c p, the buffer keeps the \c history bytes preceding
+/// \c p as well as up to \c lookahead bytes starting at \c p. The input is
+/// read in large chunks, so no byte is ever moved after it has been read.
+class WindowBuffer {
+private:
+    /// Minimum amount of bytes read from the input at once.
+    static constexpr size_t CHUNK_SIZE = 1ULL << 16;
+
+    std::istream* m_input;
+    std::vector<uliteral_t> m_buffer;
+    size_t m_mask;
+
+    size_t m_history;
+    size_t m_lookahead;
+
+    size_t m_end = 0;
+    bool m_eof = false;
+
+    inline static size_t capacity_for(size_t n) {
+        size_t c = 1;
+        while(c < n) c <<= 1;
+        return c;
+    }
+
+public:
+    /// Constructs the buffer.
+    ///
+    /// \param input the input stream.
+    /// \param history the amount of bytes to keep before the current position.
+    /// \param lookahead the amount of bytes to provide from the current
+    ///                  position on.
+    inline WindowBuffer(std::istream& input, size_t history, size_t lookahead)
+        : m_input(&input),
+          m_buffer(capacity_for(history + lookahead + CHUNK_SIZE)),
+          m_mask(m_buffer.size() - 1),
+          m_history(history),
+          m_lookahead(lookahead) {
+    }
+
+    /// Reads from the input until the lookahead of position \c p is
+    /// available or the input is exhausted.
+    ///
+    /// Bytes before <tt>p - history</tt> may be overwritten. Positions passed
+    /// to subsequent calls must not decrease.
+    inline void fill(size_t p) {
+        while(!m_eof && m_end < p + m_lookahead) {
+            const size_t lo = (p > m_history) ? p - m_history : 0;
+            const size_t space = m_buffer.size() - (m_end - lo);
+            const size_t i = m_end & m_mask;
+            const size_t k = std::min(space, m_buffer.size() - i);
+
+            m_input->read((char*) m_buffer.data() + i, k);
+            const size_t got = m_input->gcount();
+            m_end += got;
+            if(got < k) m_eof = true;
+        }
+    }
+
+    /// Returns the amount of bytes read from the input so far.
+    inline size_t end() const {
+        return m_end;
+    }
+
+    /// Returns the byte at absolute position \c p.
+    inline uliteral_t operator[](size_t p) const {
+        return m_buffer[p & m_mask];
+    }
+
+    /// Returns the length of the longest common prefix of the suffixes at
+    /// positions \c q and \c p, but at most \c max_len.
+    inline size_t match_length(size_t q, size_t p, size_t max_len) const {
+        // compare the contiguous segments between wrap-arounds of the buffer
+        size_t len = 0;
+        while(len < max_len) {
+            const size_t qi = (q + len) & m_mask;
+            const size_t pi = (p + len) & m_mask;
+            const size_t k = std::min(max_len - len,
+                m_buffer.size() - std::max(qi, pi));
+            const size_t l = lce(m_buffer.data() + qi, m_buffer.data() + pi, k);
+            len += l;
+            if(l < k) break;
+        }
+        return len;
+    }
+};
+
+}} //ns
+
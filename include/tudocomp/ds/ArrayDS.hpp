@@ -29,6 +29,9 @@ protected:
     }
 public:
     inline ArrayDS() {}
+    inline ArrayDS(iv_t&& data) {
+        set_array(std::move(data));
+    }
     inline ArrayDS(const ArrayDS& other) = delete;
     inline ArrayDS(ArrayDS&& other): DynamicIntVector(std::move(other)){
         IF_DEBUG(m_is_initialized = other.m_is_initialized;)
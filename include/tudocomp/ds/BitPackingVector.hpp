@@ -101,7 +101,7 @@ namespace int_vector {
         inline explicit BitPackingVector(size_type n): BitPackingVector() {
             this->m_real_size = n;
             size_t converted_size = bits2backing(elem2bits(this->m_real_size));
-            this->m_vec = std::vector<internal_data_type>(converted_size);
+            this->m_vec = BitPackingBackingVector<internal_data_type>(converted_size);
             DCHECK_EQ(converted_size, this->m_vec.capacity());
         }
         inline BitPackingVector(size_type n, const value_type& val): BitPackingVector(n) {
@@ -24,7 +24,6 @@ private:
     len_t     m_size;
     len_t     m_max;
 
-    BitVector m_lcp;
     Select1   m_select;
 
 public:
@@ -39,12 +38,12 @@ public:
     }
 
 private:
-    inline void encode_unary(len_t x) {
+    inline static void encode_unary(BitVector& bv, len_t x) {
         while(x) {
             --x;
-            m_lcp.emplace_back(0);
+            bv.emplace_back(0);
         }
-        m_lcp.emplace_back(1);
+        bv.emplace_back(1);
     }
 
 public:
@@ -63,14 +62,15 @@ public:
         m_size = plcp.size();
         m_max  = plcp.max_lcp();
 
-        // Construct
+        // Construct, keeping only the copy of the bits made by Select1
         StatPhase::wrap("Construct compressed LCP Array", [&]{
-            encode_unary(plcp[0] + 1);
+            BitVector lcp;
+            encode_unary(lcp, plcp[0] + 1);
             for(size_t i = 1; i < m_size; i++) {
-                encode_unary(plcp[i] - plcp[i-1] + 1);
+                encode_unary(lcp, plcp[i] - plcp[i-1] + 1);
             }
 
-            m_select = Select1(m_lcp);
+            m_select = Select1(lcp);
         });
     }
 
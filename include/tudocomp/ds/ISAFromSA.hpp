@@ -3,16 +3,21 @@
 #include <tudocomp/ds/TextDSFlags.hpp>
 #include <tudocomp/ds/CompressMode.hpp>
 #include <tudocomp/ds/ArrayDS.hpp>
+#include <tudocomp/util/Parallel.hpp>
 
 #include <tudocomp_stat/StatPhase.hpp>
 
 namespace tdc {
 
 /// Constructs the inverse suffix array using the suffix array.
+///
+/// The random writes into the inverse suffix array are distributed over
+/// \c threads threads (0 for all hardware threads) by destination blocks.
 class ISAFromSA: public Algorithm, public ArrayDS {
 public:
     inline static Meta meta() {
         Meta m("isa", "from_sa");
+        m.option("threads").dynamic(1); // 0 for all hardware threads
         return m;
     }
 
@@ -20,6 +25,11 @@ public:
         return ds::InputRestrictions {};
     }
 
+    /// Restores the array from data constructed earlier.
+    inline ISAFromSA(Env&& env, iv_t&& data)
+        : Algorithm(std::move(env)), ArrayDS(std::move(data)) {
+    }
+
     template<typename textds_t>
     inline ISAFromSA(Env&& env, textds_t& t, CompressMode cm)
             : Algorithm(std::move(env)) {
@@ -31,12 +41,17 @@ public:
             // Allocate
             const size_t n = t.size();
             const size_t w = bits_for(n);
-            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ? w : INDEX_FAST_BITS));
+            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ? w : index_width(n)));
 
             // Construct
-            for(len_t i = 0; i < n; i++) {
-                (*this)[sa[i]] = i;
-            }
+            const size_t threads = resolve_thread_count(
+                this->env().option("threads").as_integer());
+            StatPhase::log("threads", threads);
+
+            parallel_scatter((iv_t&) *this, n, n,
+                [&](size_t i) -> size_t { return sa[i]; },
+                [](size_t i) { return i; },
+                threads);
 
             StatPhase::log("bit_width", size_t(width()));
             StatPhase::log("size", bit_size() / 8);
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <type_traits>
+#include <vector>
 
 #include <sdsl/bits.hpp>
 
 #include <tudocomp/ds/uint_t.hpp>
 #include <tudocomp/ds/dynamic_t.hpp>
+#include <tudocomp/ds/MappedStorage.hpp>
 
 namespace tdc {namespace int_vector {
     enum class ElementStorageMode {
@@ -16,6 +18,10 @@ namespace tdc {namespace int_vector {
     /// \cond INTERNAL
     using DynamicIntValueType = uint64_t;
 
+    /// The backing data of bit-packed vectors, which may be file-backed.
+    template<typename T>
+    using BitPackingBackingVector = std::vector<T, StorageAllocator<T>>;
+
     struct DynamicWidthMemRw {
         inline static void write_int(uint64_t* word, uint64_t x, uint8_t offset, const uint8_t len) {
             sdsl::bits::write_int(word, x, offset, len);
@@ -99,7 +105,7 @@ namespace tdc {namespace int_vector {
     struct FixedBitPackingVectorRepr {
         using internal_data_type = DynamicIntValueType;
 
-        std::vector<internal_data_type> m_vec;
+        BitPackingBackingVector<internal_data_type> m_vec;
         uint64_t m_real_size;
 
         inline FixedBitPackingVectorRepr():
@@ -115,7 +121,7 @@ namespace tdc {namespace int_vector {
     struct DynamicBitPackingVectorRepr {
         using internal_data_type = DynamicIntValueType;
 
-        std::vector<internal_data_type> m_vec;
+        BitPackingBackingVector<internal_data_type> m_vec;
         uint64_t m_real_size;
         uint8_t m_width;
 
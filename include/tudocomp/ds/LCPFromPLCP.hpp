@@ -23,6 +23,15 @@ public:
         return ds::InputRestrictions {};
     }
 
+    /// Restores the array from data constructed earlier.
+    inline LCPFromPLCP(Env&& env, iv_t&& data)
+        : Algorithm(std::move(env)), ArrayDS(std::move(data)), m_max(0) {
+
+        for(size_t i = 0; i < size(); ++i) {
+            m_max = std::max<len_t>(m_max, (*this)[i]);
+        }
+    }
+
     template<typename textds_t>
     inline LCPFromPLCP(Env&& env, textds_t& t, CompressMode cm)
             : Algorithm(std::move(env)) {
@@ -38,7 +47,7 @@ public:
             m_max = plcp.max_lcp();
             const size_t w = bits_for(m_max);
 
-            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ? w : INDEX_FAST_BITS));
+            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ? w : index_width(n)));
 
             (*this)[0] = 0;
             for(len_t i = 1; i < n; i++) {
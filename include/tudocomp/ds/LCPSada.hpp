@@ -3,7 +3,8 @@
 #include <tudocomp/util.hpp>
 #include <tudocomp/Env.hpp>
 #include <tudocomp/ds/IntVector.hpp>
-#include <sdsl/select_support_mcl.hpp> // for the select data structure
+#include <tudocomp/ds/Select.hpp>
+#include <tudocomp/util/View.hpp>
 
 #include <tudocomp_stat/StatPhase.hpp>
 
@@ -36,20 +37,21 @@ inline phi_t construct_phi_array(const sa_t& sa) {
  * @param text the input text
  * @author Kärkkäinen et. al, "Permuted Longest-Common-Prefix Array", CPM'09
  */
-template<typename phi_t, typename text_t>
-inline void phi_algorithm(phi_t& phi, const text_t& text) {
+template<typename phi_t>
+inline void phi_algorithm(phi_t& phi, View text) {
 	const size_t n = phi.size();
+	DCHECK_EQ(text.size(), n);
 	DCHECK_EQ(text[n-1],0);
 	for(len_t i = 0, l = 0; i < n - 1; ++i) {
 		const len_t phii = phi[i];
 		DCHECK_LT(i+l, n);
 		DCHECK_LT(phii+l, n);
 		DCHECK_NE(i, phii);
-		while(text[i+l] == text[phii+l]) {
-			l++;
-			DCHECK_LT(i+l, n);
-			DCHECK_LT(phii+l, n);
+		if(text[i+l] == text[phii+l]) {
+			l += lce(text, i+l, phii+l);
 		}
+		DCHECK_LT(i+l, n);
+		DCHECK_LT(phii+l, n);
 		phi[i] = l;
 		if(l) {
 			--l;
@@ -62,16 +64,14 @@ inline void phi_algorithm(phi_t& phi, const text_t& text) {
 
 template<
 typename sa_t,
-typename select_t = sdsl::select_support_mcl<1,1>>
+typename select_t = Select1>
 class LCPSada {
 	const sa_t& m_sa;
-	const sdsl::bit_vector m_bv;
-	const select_t m_select;
+	const select_t m_select; // keeps a copy of the bit vector
 	public:
-	LCPSada(const sa_t& sa, const sdsl::bit_vector&& bv)
+	LCPSada(const sa_t& sa, BitVector&& bv)
 		: m_sa(sa)
-		, m_bv(bv)
-		, m_select(&m_bv)
+		, m_select(bv)
 	{
 	}
 	len_t operator[](len_t i) const {
@@ -97,12 +97,12 @@ class LCPSada {
 	// 	len_t rank = 0;
 	// 	const uint64_t*const data = m_bv.data();
 	// 	for(pos = 0; pos < chunk_size; ++pos) {
-	// 		const uint_fast8_t ones = sdsl::bits::cnt(data[pos]);
+	// 		const uint_fast8_t ones = tdc::rank1(data[pos]);
 	// 		if(rank+ones >= idx) break;
 	// 		rank += ones;
 	// 	}
 	// 	if(pos == chunk_size) return m_bv.size();
-	// 	return 64*pos + sdsl::bits::sel(data[pos], idx-rank);
+	// 	return 64*pos + tdc::select1(data[pos], idx-rank);
 	// }
     //
 	// len_t naive_plcp(len_t idx) const {
@@ -113,14 +113,14 @@ class LCPSada {
 };
 
 class LCPForwardIterator {
-	sdsl::bit_vector m_bv;
+	BitVector m_bv;
 
 	len_t m_idx = 0; // current select parameter
 	len_t m_block = 0; // block index
 	len_t m_blockrank = 0; //number of ones up to previous block
 
 	public:
-	LCPForwardIterator(sdsl::bit_vector&& bv) : m_bv(bv) {}
+	LCPForwardIterator(BitVector&& bv) : m_bv(std::move(bv)) {}
 
 	len_t index() const { return m_idx; }
 
@@ -131,13 +131,13 @@ class LCPForwardIterator {
 		const len_t chunk_size = 1 + ((m_bv.size()-1)/64); //TODO: in constructor
 		const uint64_t*const data = m_bv.data();
 		while(m_block < chunk_size) {
-			const uint_fast8_t ones = sdsl::bits::cnt(data[m_block]); // TODO: make member variable to speed up
+			const uint_fast8_t ones = tdc::rank1(data[m_block]); // TODO: make member variable to speed up
 			if(m_blockrank+ones >= m_idx+1) break;
 			m_blockrank += ones;
 			++m_block;
 		}
 		if(m_block == chunk_size) return m_bv.size();
-		return 64*m_block + sdsl::bits::sel(data[m_block], m_idx+1-m_blockrank);
+		return 64*m_block + tdc::select1(data[m_block], uint8_t(m_idx+1-m_blockrank));
 
 	}
 	len_t operator()() {
@@ -150,14 +150,14 @@ class LCPForwardIterator {
 };
 
 template<class plcp_t>
-inline static sdsl::bit_vector construct_plcp_bitvector(const plcp_t& plcp) {
+inline static BitVector construct_plcp_bitvector(const plcp_t& plcp) {
 	const len_t n = plcp.size();
 	len_t len = plcp[0];
 	for(len_t i = 0; i+1 < n; i++) {
 		DCHECK_GE(plcp[i+1]+1, plcp[i]);
 		len += plcp[i+1]-plcp[i]+1;
 	}
-	sdsl::bit_vector bv(len+n,0);
+	BitVector bv(len+n,0);
 	bv[plcp[0]]=1;
 	len=plcp[0];
 	for(len_t i = 0; i+1 < n; i++) {
@@ -166,12 +166,12 @@ inline static sdsl::bit_vector construct_plcp_bitvector(const plcp_t& plcp) {
 		bv[len] = 1;
 	}
 	DCHECK_EQ(len, bv.size()-1);
-	DCHECK_EQ(plcp.size(), std::accumulate(bv.begin(), bv.end(), 0));
+	DCHECK_EQ(plcp.size(), size_t(std::count(bv.begin(), bv.end(), true)));
 	return bv;
 }
 
-template<class sa_t, class text_t, class select_t = sdsl::select_support_mcl<1,1>>
-sdsl::bit_vector construct_plcp_bitvector(Env&, const sa_t& sa, const text_t& text) {
+template<class sa_t, class text_t, class select_t = Select1>
+BitVector construct_plcp_bitvector(Env&, const sa_t& sa, const text_t& text) {
 	typedef DynamicIntVector phi_t;
 
     phi_t phi = StatPhase::wrap("Construct Phi Array", [&]{
@@ -179,20 +179,20 @@ sdsl::bit_vector construct_plcp_bitvector(Env&, const sa_t& sa, const text_t& te
     });
 
     StatPhase::wrap("Phi-Algorithm", [&]{
-        phi_algorithm(phi, text);
+        phi_algorithm(phi, View(text.text(), text.size()));
     });
 
     return StatPhase::wrap("Build Sada Bit Vector", [&]{
         auto ret = construct_plcp_bitvector(phi);
-        StatPhase::log("bit vector length", ret.bit_size());
+        StatPhase::log("bit vector length", ret.size());
         return ret;
     });
 }
 
-template<class sa_t, class text_t, class select_t = sdsl::select_support_mcl<1,1>>
+template<class sa_t, class text_t, class select_t = Select1>
 LCPSada<sa_t,select_t> construct_lcp_sada(Env& env, const sa_t& sa, const text_t& text) {
     return StatPhase::wrap("Build Select on Bit Vector", [&]{
-        sdsl::bit_vector bv = construct_plcp_bitvector(env, sa, text);
+        BitVector bv = construct_plcp_bitvector(env, sa, text);
         return LCPSada<sa_t,select_t> { sa, std::move(bv) };
     });
 }
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <tudocomp/io/MMapHandle.hpp>
+
+namespace tdc {
+
+/// \brief Provides memory from dedicated memory maps instead of the heap.
+///
+/// A storage is either external or backed by huge pages:
+///
+/// - An external storage maps each allocation to a temporary file of its
+///   own in a directory (see \ref io::MMap::temporary_file). The kernel
+///   writes pages back to the file as memory gets scarce, so data structures
+///   can exceed the amount of main memory at the cost of disk accesses. The
+///   mappings are advised for sequential access, which is how the text data
+///   structures are scanned by most compressors.
+/// - A huge page storage maps each allocation of at least one huge page to
+///   anonymous memory backed by huge pages (see \ref io::MMap::huge_pages),
+///   which reduces TLB misses of random accesses into large arrays. Smaller
+///   allocations are served from the heap.
+///
+/// Bit-packed integer vectors allocate their memory from the storage that
+/// is current at the time they are constructed (see \ref Scope), and keep
+/// it for their whole lifetime, including copies. If no storage is current,
+/// the huge page storage is used if the environment variable
+/// \c TDC_HUGE_PAGES is set to a value other than \c 0.
+class MappedStorage {
+private:
+    std::string m_dir;
+    bool m_huge_pages;
+
+    std::mutex m_mutex;
+    std::unordered_map<const void*, io::MMap> m_maps;
+    size_t m_size = 0;
+
+    inline static std::shared_ptr<MappedStorage>& current_ref() {
+        static thread_local std::shared_ptr<MappedStorage> current;
+        return current;
+    }
+
+    inline static const std::shared_ptr<MappedStorage>& environment() {
+        static const std::shared_ptr<MappedStorage> storage = []{
+            const char* env = std::getenv("TDC_HUGE_PAGES");
+            return (env && *env && std::strcmp(env, "0") != 0)
+                ? huge_pages() : std::shared_ptr<MappedStorage>();
+        }();
+        return storage;
+    }
+
+    inline MappedStorage(const std::string& dir, bool huge_pages)
+        : m_dir(dir), m_huge_pages(huge_pages) {
+    }
+
+public:
+    /// \brief Constructs an external storage creating its files in the given
+    ///        directory.
+    ///
+    /// \param dir the directory, which must exist.
+    inline static std::shared_ptr<MappedStorage> external(const std::string& dir) {
+        return std::shared_ptr<MappedStorage>(new MappedStorage(dir, false));
+    }
+
+    /// Constructs a storage backed by huge pages.
+    inline static std::shared_ptr<MappedStorage> huge_pages() {
+        return std::shared_ptr<MappedStorage>(new MappedStorage("", true));
+    }
+
+    MappedStorage(const MappedStorage&) = delete;
+    MappedStorage& operator=(const MappedStorage&) = delete;
+
+    /// Returns the directory files are created in, or an empty string if
+    /// the storage is backed by huge pages.
+    inline const std::string& dir() const {
+        return m_dir;
+    }
+
+    /// Returns whether the storage is backed by huge pages.
+    inline bool is_huge_pages() const {
+        return m_huge_pages;
+    }
+
+    /// Returns whether an allocation of the given size is mapped, as
+    /// opposed to being served from the heap.
+    inline bool maps(size_t bytes) const {
+        return !m_huge_pages || bytes >= io::MMap::huge_pagesize();
+    }
+
+    /// \brief Allocates a mapped memory region.
+    ///
+    /// \param bytes the size of the region.
+    /// \return the beginning of the region, aligned to a page.
+    inline void* allocate(size_t bytes) {
+        io::MMap map;
+        if(m_huge_pages) {
+            map = io::MMap::huge_pages(bytes);
+        } else {
+            map = io::MMap::temporary_file(m_dir, bytes);
+            map.advise(MADV_SEQUENTIAL);
+        }
+        void* ptr = map.view().data();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_size += map.view().size();
+        m_maps.emplace(ptr, std::move(map));
+        return ptr;
+    }
+
+    /// \brief Releases a region returned by \ref allocate and removes its
+    ///        file, if any.
+    ///
+    /// \param ptr the beginning of the region.
+    inline void deallocate(void* ptr) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_maps.find(ptr);
+        DCHECK(it != m_maps.end()) << "region was not allocated by this storage";
+        m_size -= it->second.view().size();
+        m_maps.erase(it);
+    }
+
+    /// Returns the total size of all allocated regions in bytes.
+    inline size_t size() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_size;
+    }
+
+    /// Returns the amount of bytes of all allocated regions that are
+    /// currently backed by huge pages.
+    inline size_t huge_page_bytes() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t bytes = 0;
+        if(m_huge_pages) {
+            for(auto& e : m_maps) bytes += e.second.huge_page_bytes();
+        }
+        return bytes;
+    }
+
+    /// Returns the storage for allocations of the calling thread, or
+    /// \c nullptr if memory is allocated on the heap.
+    inline static std::shared_ptr<MappedStorage> current() {
+        auto& current = current_ref();
+        return current ? current : environment();
+    }
+
+    /// \brief Makes a storage current for the calling thread as long as the
+    ///        scope exists.
+    ///
+    /// Scopes can be nested, the previous storage becomes current again when
+    /// a scope is destroyed. A scope of \c nullptr restores the default
+    /// allocation on the heap.
+    class Scope {
+    private:
+        std::shared_ptr<MappedStorage> m_prev;
+
+    public:
+        inline Scope(std::shared_ptr<MappedStorage> storage)
+            : m_prev(std::move(current_ref())) {
+            current_ref() = std::move(storage);
+        }
+
+        inline ~Scope() {
+            current_ref() = std::move(m_prev);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
+
+/// \brief Allocator for the backing data of bit-packed integer vectors.
+///
+/// Allocates memory from the \ref MappedStorage that was current when the
+/// allocator was constructed, or from the heap if there was none.
+template<typename T>
+class StorageAllocator {
+private:
+    template<typename U>
+    friend class StorageAllocator;
+
+    std::shared_ptr<MappedStorage> m_storage;
+
+public:
+    using value_type = T;
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    inline StorageAllocator() : m_storage(MappedStorage::current()) {
+    }
+
+    template<typename U>
+    inline StorageAllocator(const StorageAllocator<U>& other)
+        : m_storage(other.m_storage) {
+    }
+
+    inline T* allocate(size_t n) {
+        if(m_storage && m_storage->maps(n * sizeof(T))) {
+            return (T*) m_storage->allocate(n * sizeof(T));
+        } else {
+            return std::allocator<T>().allocate(n);
+        }
+    }
+
+    inline void deallocate(T* ptr, size_t n) {
+        if(m_storage && m_storage->maps(n * sizeof(T))) {
+            m_storage->deallocate(ptr);
+        } else {
+            std::allocator<T>().deallocate(ptr, n);
+        }
+    }
+
+    /// Returns whether memory is allocated from a file-backed storage.
+    inline bool is_external() const {
+        return m_storage && !m_storage->is_huge_pages();
+    }
+
+    /// Returns whether large allocations are backed by huge pages.
+    inline bool is_huge_pages() const {
+        return m_storage && m_storage->is_huge_pages();
+    }
+
+    template<typename U>
+    inline bool operator==(const StorageAllocator<U>& other) const {
+        return m_storage == other.m_storage;
+    }
+
+    template<typename U>
+    inline bool operator!=(const StorageAllocator<U>& other) const {
+        return m_storage != other.m_storage;
+    }
+};
+
+} //ns
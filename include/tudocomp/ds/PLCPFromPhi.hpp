@@ -3,12 +3,18 @@
 #include <tudocomp/ds/TextDSFlags.hpp>
 #include <tudocomp/ds/CompressMode.hpp>
 #include <tudocomp/ds/ArrayDS.hpp>
+#include <tudocomp/util/Parallel.hpp>
+#include <tudocomp/util/View.hpp>
 
 #include <tudocomp_stat/StatPhase.hpp>
 
 namespace tdc {
 
 /// Constructs the PLCP array using the phi array.
+///
+/// The text is split into one chunk per thread (0 for all hardware
+/// threads). As the Phi algorithm only requires a lower bound of the
+/// current PLCP value, each chunk starts with a lower bound of zero.
 class PLCPFromPhi: public Algorithm, public ArrayDS {
 private:
     len_t m_max;
@@ -16,6 +22,7 @@ private:
 public:
     inline static Meta meta() {
         Meta m("plcp", "from_phi");
+        m.option("threads").dynamic(1); // 0 for all hardware threads
         return m;
     }
 
@@ -23,6 +30,15 @@ public:
         return ds::InputRestrictions {};
     }
 
+    /// Restores the array from data constructed earlier.
+    inline PLCPFromPhi(Env&& env, iv_t&& data)
+        : Algorithm(std::move(env)), ArrayDS(std::move(data)), m_max(0) {
+
+        for(size_t i = 0; i < size(); ++i) {
+            m_max = std::max<len_t>(m_max, (*this)[i]);
+        }
+    }
+
     template<typename textds_t>
     inline PLCPFromPhi(Env&& env, textds_t& t, CompressMode cm)
             : Algorithm(std::move(env)) {
@@ -33,15 +49,35 @@ public:
         set_array(t.inplace_phi(cm));
 
         StatPhase::wrap("Construct PLCP Array", [&]{
-            // Use Phi algorithm to compute PLCP array
-            m_max = 0;
-            for(len_t i = 0, l = 0; i < n - 1; ++i) {
-                const len_t phii = (*this)[i];
-                while(t[i+l] == t[phii+l]) ++l;
-                m_max = std::max(m_max, l);
-                (*this)[i] = l;
-                if(l) --l;
-            }
+            // Use Phi algorithm to compute PLCP array, in chunks of whole
+            // words of the bit-packed array
+            const size_t words = idiv_ceil(n - 1, 64);
+            const size_t threads = std::max<size_t>(1, std::min(words >> 10,
+                resolve_thread_count(this->env().option("threads").as_integer())));
+            StatPhase::log("threads", threads);
+
+            const View text(t.text(), n);
+
+            std::vector<len_t> max(threads, 0);
+            parallel_run(threads, [&](size_t c) {
+                const len_t from = std::min(n - 1, 64 * (words * c / threads));
+                const len_t to = std::min(n - 1, 64 * (words * (c + 1) / threads));
+                len_t chunk_max = 0;
+                for(len_t i = from, l = 0; i < to; ++i) {
+                    const len_t phii = (*this)[i];
+                    if(text[i + l] == text[phii + l]) {
+                        l += lce(text, i + l, phii + l);
+                    }
+                    chunk_max = std::max(chunk_max, l);
+                    (*this)[i] = l;
+                    if(l) --l;
+                }
+                max[c] = chunk_max;
+            });
+            m_max = *std::max_element(max.begin(), max.end());
+
+            // the sentinel suffix shares no prefix with any other suffix
+            (*this)[n - 1] = 0;
 
             StatPhase::log("bit_width", size_t(width()));
             StatPhase::log("size", bit_size() / 8);
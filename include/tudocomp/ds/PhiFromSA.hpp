@@ -3,16 +3,21 @@
 #include <tudocomp/ds/TextDSFlags.hpp>
 #include <tudocomp/ds/CompressMode.hpp>
 #include <tudocomp/ds/ArrayDS.hpp>
+#include <tudocomp/util/Parallel.hpp>
 
 #include <tudocomp_stat/StatPhase.hpp>
 
 namespace tdc {
 
 /// Constructs the Phi array using the suffix array.
+///
+/// The random writes into the Phi array are distributed over \c threads
+/// threads (0 for all hardware threads) by destination blocks.
 class PhiFromSA: public Algorithm, public ArrayDS {
 public:
     inline static Meta meta() {
         Meta m("phi", "from_sa");
+        m.option("threads").dynamic(1); // 0 for all hardware threads
         return m;
     }
 
@@ -20,6 +25,11 @@ public:
         return ds::InputRestrictions {};
     }
 
+    /// Restores the array from data constructed earlier.
+    inline PhiFromSA(Env&& env, iv_t&& data)
+        : Algorithm(std::move(env)), ArrayDS(std::move(data)) {
+    }
+
     template<typename textds_t>
     inline PhiFromSA(Env&& env, textds_t& t, CompressMode cm)
             : Algorithm(std::move(env)) {
@@ -32,13 +42,16 @@ public:
 
         StatPhase::wrap("Construct Phi Array", [&]{
             // Construct Phi Array
-            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ? w : INDEX_FAST_BITS));
+            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ? w : index_width(n)));
+
+            const size_t threads = resolve_thread_count(
+                this->env().option("threads").as_integer());
+            StatPhase::log("threads", threads);
 
-            for(len_t i = 1, prev = sa[0]; i < n; i++) {
-                (*this)[sa[i]] = prev;
-                prev = sa[i];
-            }
-            (*this)[sa[0]] = sa[n-1];
+            parallel_scatter((iv_t&) *this, n, n,
+                [&](size_t i) -> size_t { return sa[i]; },
+                [&](size_t i) -> size_t { return sa[(i > 0) ? i - 1 : n - 1]; },
+                threads);
 
             StatPhase::log("bit_width", size_t(width()));
             StatPhase::log("size", bit_size() / 8);
@@ -1,16 +1,24 @@
 #pragma once
 
+#include <cstring>
+#include <vector>
+
 #include <tudocomp/util.hpp>
 #include <tudocomp/ds/rank_64bit.hpp>
 #include <tudocomp/ds/IntVector.hpp>
 
 namespace tdc {
 
+template<bool m_bit>
+class Select;
+
 /// \brief Implements a rank data structure for a \ref BitVector.
 ///
-/// The data structure follows a block / superblock principle. Blocks are
-/// always of fixed size (e.g. 64 bits), the size of a superblock is
-/// the squared block size.
+/// The data structure interleaves the rank information with a copy of the
+/// bits, so that a query touches a single cache line. Each line of 64 bytes
+/// stores the amount of 1-bits preceding the line in its first word,
+/// followed by 448 bits of the bit vector. A query adds the popcounts of
+/// at most seven words of the line to the stored value.
 ///
 /// The structure supports both rank1 and rank0 queries.
 class Rank {
@@ -19,104 +27,120 @@ public:
     static constexpr size_t block_size =
         8 * sizeof(BitVector::internal_data_type);
 
-    static_assert(block_size <= 64, "block_size cannot be larger than 64 bits");
+    static_assert(block_size == 64, "bit vectors must be backed by 64-bit words");
+
+    /// The amount of words in a cache line.
+    static constexpr size_t line_words = 8;
+
+    /// The amount of bits of the bit vector stored in a cache line.
+    static constexpr size_t line_bits = (line_words - 1) * block_size;
 
 private:
-    const BitVector* m_bv;
+    template<bool m_bit>
+    friend class Select;
 
-    size_t m_supblock_size;
-    DynamicIntVector m_blocks;
-    DynamicIntVector m_supblocks;
+    size_t m_size;
+
+    // the lines, preceded by up to seven words of padding that align them
+    // to the cache lines
+    std::vector<uint64_t> m_data;
+    size_t m_offset;
+
+    inline void allocate(size_t num_lines) {
+        m_data = std::vector<uint64_t>(num_lines * line_words + line_words - 1);
+        const size_t misalign = (uintptr_t(m_data.data()) / sizeof(uint64_t)) % line_words;
+        m_offset = misalign ? line_words - misalign : 0;
+    }
+
+    inline const uint64_t* lines() const {
+        return m_data.data() + m_offset;
+    }
+
+    inline size_t num_lines() const {
+        return idiv_ceil(m_size, line_bits);
+    }
+
+    inline void copy_from(const Rank& other) {
+        m_size = other.m_size;
+        allocate(num_lines());
+        std::memcpy(m_data.data() + m_offset, other.lines(),
+                    num_lines() * line_words * sizeof(uint64_t));
+    }
+
+    // counts the 1-bits in the words 1 to w of a line
+    inline static size_t count_words(const uint64_t* line, size_t w) {
+        size_t r = 0;
+        for(size_t k = 1; k <= w; ++k) r += tdc::rank1(line[k]);
+        return r;
+    }
 
 public:
     /// \brief Default constructor.
-    inline Rank()
-        : m_bv(nullptr),
-          m_supblock_size(0) {
+    inline Rank() : m_size(0), m_offset(0) {
     }
 
     /// \brief Copy constructor.
-    inline Rank(const Rank& other)
-        : m_bv(other.m_bv),
-          m_supblock_size(other.m_supblock_size),
-          m_blocks(other.m_blocks),
-          m_supblocks(other.m_supblocks) {
+    inline Rank(const Rank& other) {
+        copy_from(other);
     }
 
     /// \brief Move constructor.
     inline Rank(Rank&& other)
-        : m_bv(other.m_bv),
-          m_supblock_size(other.m_supblock_size),
-          m_blocks(std::move(other.m_blocks)),
-          m_supblocks(std::move(other.m_supblocks)) {
+        : m_size(other.m_size),
+          m_data(std::move(other.m_data)),
+          m_offset(other.m_offset) {
     }
 
     /// \brief Copy assignment.
     inline Rank& operator=(const Rank& other) {
-        m_bv = other.m_bv;
-        m_supblock_size = other.m_supblock_size;
-        m_blocks = other.m_blocks;
-        m_supblocks = other.m_supblocks;
+        copy_from(other);
         return *this;
     }
 
     /// \brief Move assignment.
     inline Rank& operator=(Rank&& other) {
-        m_bv = other.m_bv;
-        m_supblock_size = other.m_supblock_size;
-        m_blocks = std::move(other.m_blocks);
-        m_supblocks = std::move(other.m_supblocks);
+        m_size = other.m_size;
+        m_data = std::move(other.m_data);
+        m_offset = other.m_offset;
         return *this;
     }
 
     /// \brief Constructs the rank data structure for the given bit vector.
     ///
-    /// Note that changes to the bit vector after construction of this data
-    /// structure will cause the rank operations to not work correctly
-    /// anymore. In other words, this data structure is static.
+    /// The bits are copied into the data structure, so changes to the bit
+    /// vector after construction are not reflected by the rank operations.
+    /// In other words, this data structure is static.
     ///
     /// \param bv the underlying bit vector
-    inline Rank(const BitVector& bv)
-        : m_bv(&bv),
-          m_supblock_size(block_size * block_size) {
-
-        DCHECK_GT(m_supblock_size, block_size)
-            << "superblocks must be larger than blocks!";
-        DCHECK_EQ(0, m_supblock_size % block_size)
-            << "superblock size must be a multiple of the block size!";
-
-        const size_t n = m_bv->size();
-        const auto data = m_bv->data();
+    inline Rank(const BitVector& bv) : m_size(bv.size()) {
+        const size_t num_words = idiv_ceil(m_size, block_size);
+        const auto data = bv.data();
 
-        // compute number of superblocks / blocks
-        const size_t num_supblocks = idiv_ceil(n, m_supblock_size);
-        const size_t num_blocks    = idiv_ceil(n, block_size);
+        allocate(num_lines());
+        uint64_t* line = m_data.data() + m_offset;
 
-        const size_t blocks_per_supblock = m_supblock_size / block_size;
-
-        m_supblocks = DynamicIntVector(num_supblocks, 0, bits_for(n));
-        m_blocks = DynamicIntVector(num_blocks, 0, bits_for(m_supblock_size));
-
-        // construct
         size_t rank_bv = 0; // 1-bits in whole BV
-        size_t rank_sb = 0; // 1-bits in current superblock
-        size_t cur_sb = 0;  // current superblock
-
-        for(size_t j = 0; j < num_blocks; j++) {
-            size_t i = j / blocks_per_supblock;
-            if(i > cur_sb) {
-                // we reached a new superblock
-                m_supblocks[cur_sb] = rank_bv;
-                rank_sb = 0;
-                cur_sb = i;
+        for(size_t j = 0; j < num_words; j += line_words - 1) {
+            line[0] = rank_bv;
+            for(size_t k = 1; k < line_words && j + k - 1 < num_words; ++k) {
+                line[k] = data[j + k - 1];
+                rank_bv += tdc::rank1(line[k]);
             }
+            line += line_words;
+        }
+    }
 
-            auto rank_b = tdc::rank1(data[j]);
-            rank_sb += rank_b;
-            rank_bv += rank_b;
+    /// \brief Returns the bit at the given position of the bit vector.
+    /// \param x the position
+    inline bool bit(size_t x) const {
+        DCHECK_LT(x, m_size);
+        const uint64_t* line = lines() + (x / line_bits) * line_words;
+        return (line[(x % line_bits) / block_size + 1] >> (x % block_size)) & 1ULL;
+    }
 
-            m_blocks[j] = rank_sb;
-        }
+    /// \brief Returns the size of the bit vector.
+    inline size_t size() const {
+        return m_size;
     }
 
     /// \brief Counts the amount of 1-bits from the beginning of the bit vector
@@ -124,17 +148,11 @@ public:
     /// \param x the position up to which to count (inclusively)
     /// \return the amount of counted 1-bits
     inline size_t rank1(size_t x) const {
-        DCHECK_LT(x, m_bv->size());
-        size_t r = 0;
-        size_t i = x / m_supblock_size;
-        if(i > 0) r += m_supblocks[i-1];
-        size_t j = x / block_size;
-
-        size_t k = j - i * (m_supblock_size / block_size);
-        if(k > 0) r += m_blocks[j-1];
-
-        r += tdc::rank1(m_bv->data()[j], x % block_size);
-        return r;
+        DCHECK_LT(x, m_size);
+        const uint64_t* line = lines() + (x / line_bits) * line_words;
+        const size_t w = (x % line_bits) / block_size;
+        return line[0] + count_words(line, w) +
+            tdc::rank1(line[w + 1], uint8_t(x % block_size));
     }
 
     /// \brief Counts the amount of 1-bits in the given interval (borders
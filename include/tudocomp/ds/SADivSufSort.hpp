@@ -3,6 +3,7 @@
 #include <tudocomp/ds/TextDSFlags.hpp>
 #include <tudocomp/ds/CompressMode.hpp>
 #include <tudocomp/ds/ArrayDS.hpp>
+#include <tudocomp/ds/TextDSPlan.hpp>
 #include <tudocomp/util/divsufsort.hpp>
 
 #include <tudocomp_stat/StatPhase.hpp>
@@ -24,6 +25,11 @@ public:
         };
     }
 
+    /// Restores the array from data constructed earlier.
+    inline SADivSufSort(Env&& env, iv_t&& data)
+        : Algorithm(std::move(env)), ArrayDS(std::move(data)) {
+    }
+
     template<typename textds_t>
     inline SADivSufSort(Env&& env, const textds_t& t, CompressMode cm)
         : Algorithm(std::move(env)) {
@@ -34,9 +40,7 @@ public:
             const size_t w = bits_for(n);
 
             // divsufsort needs one additional bit for signs
-            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ? w + 1 : INDEX_FAST_BITS));
-            //std::cout << w << "\n";
-            //std::cout << INDEX_FAST_BITS << "\n";
+            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ? w + 1 : index_width(size_t(1) << w)));
 
             // Use divsufsort to construct
             divsufsort(t.text(), (iv_t&) *this, n);
@@ -63,4 +67,28 @@ public:
     }
 };
 
+namespace ds {
+
+template<>
+struct SAConstruction<SADivSufSort> {
+    static constexpr bool modelled = true;
+
+    // with an additional bit for signs
+    inline static size_t width(size_t n, CompressMode cm) {
+        const size_t w = bits_for(n);
+        return (cm == CompressMode::compressed) ? w + 1 : index_width(size_t(1) << w);
+    }
+
+    inline static size_t compressed_width(size_t n, CompressMode) {
+        return bits_for(n);
+    }
+
+    // with the bucket arrays of divsufsort
+    inline static size_t peak(size_t n, CompressMode cm) {
+        return plan::bytes(n, width(n, cm)) + (256 + 256 * 256) * sizeof(int64_t);
+    }
+};
+
+}
+
 } //ns
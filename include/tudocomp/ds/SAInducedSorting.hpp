@@ -0,0 +1,507 @@
+#pragma once
+
+#include <vector>
+
+#include <tudocomp/ds/TextDSFlags.hpp>
+#include <tudocomp/ds/CompressMode.hpp>
+#include <tudocomp/ds/ArrayDS.hpp>
+#include <tudocomp/ds/TextDSPlan.hpp>
+
+#include <tudocomp_stat/StatPhase.hpp>
+
+namespace tdc {
+
+/// \cond INTERNAL
+namespace sais {
+
+using sidx_t = int64_t;
+
+/// Signed view on an array of plain 32 or 64 bit integers.
+template<typename int_t>
+class RawArray {
+    int_t* m_data;
+public:
+    inline RawArray(int_t* data) : m_data(data) {}
+    inline sidx_t get(sidx_t i) const { return m_data[i]; }
+    inline void set(sidx_t i, sidx_t v) { m_data[i] = int_t(v); }
+};
+
+/// Signed view on a bit-packed integer array, with the highest bit of each
+/// entry as its sign.
+///
+/// The words of the array are accessed directly, as this is considerably
+/// faster than the generic bit-packed element references.
+class PackedArray {
+    uint64_t* m_data;
+    size_t m_width;
+    size_t m_shift;
+    uint64_t m_mask;
+public:
+    inline PackedArray(DynamicIntVector& iv)
+        : m_data(iv.data()),
+          m_width(iv.width()),
+          m_shift(64 - iv.width()),
+          m_mask(uint64_t(-1) >> m_shift) {}
+
+    inline sidx_t get(sidx_t i) const {
+        const size_t pos = size_t(i) * m_width;
+        const size_t word = pos >> 6;
+        const size_t offset = pos & 63;
+        uint64_t v = m_data[word] >> offset;
+        if(offset + m_width > 64) v |= m_data[word + 1] << (64 - offset);
+        return sidx_t(v << m_shift) >> m_shift;
+    }
+    inline void set(sidx_t i, sidx_t v) {
+        const size_t pos = size_t(i) * m_width;
+        const size_t word = pos >> 6;
+        const size_t offset = pos & 63;
+        const uint64_t x = uint64_t(v) & m_mask;
+        m_data[word] = (m_data[word] & ~(m_mask << offset)) | (x << offset);
+        if(offset + m_width > 64) {
+            const size_t rest = offset + m_width - 64;
+            const uint64_t high = (uint64_t(1) << rest) - 1;
+            m_data[word + 1] = (m_data[word + 1] & ~high) | (x >> (64 - offset));
+        }
+    }
+};
+
+/// A part of an array, starting at an offset. Used for the reduced texts
+/// and for buckets that are kept in unused space of the suffix array.
+template<typename array_t>
+class Slice {
+    array_t* m_array;
+    sidx_t m_offset;
+public:
+    inline Slice(array_t& array, sidx_t offset)
+        : m_array(&array), m_offset(offset) {}
+    inline sidx_t get(sidx_t i) const { return m_array->get(m_offset + i); }
+    inline void set(sidx_t i, sidx_t v) { m_array->set(m_offset + i, v); }
+};
+
+/// Buckets that do not fit into unused space of the suffix array.
+class Buffer {
+    std::vector<sidx_t> m_data;
+public:
+    inline Buffer(sidx_t k) : m_data(k) {}
+    inline sidx_t get(sidx_t i) const { return m_data[i]; }
+    inline void set(sidx_t i, sidx_t v) { m_data[i] = v; }
+};
+
+/// The input text.
+class ByteText {
+    const uliteral_t* m_text;
+public:
+    inline ByteText(const uliteral_t* text) : m_text(text) {}
+    inline sidx_t get(sidx_t i) const { return m_text[i]; }
+};
+
+template<typename text_t, typename bucket_t>
+inline void get_counts(const text_t& text, bucket_t& C, sidx_t n, sidx_t k) {
+    for(sidx_t c = 0; c < k; ++c) C.set(c, 0);
+    for(sidx_t i = 0; i < n; ++i) {
+        const sidx_t c = text.get(i);
+        C.set(c, C.get(c) + 1);
+    }
+}
+
+/// Computes the bucket starts or ends from the counts. \c C and \c B may
+/// be the same.
+template<typename bucket_t>
+inline void get_buckets(const bucket_t& C, bucket_t& B, sidx_t k, bool end) {
+    sidx_t sum = 0;
+    for(sidx_t c = 0; c < k; ++c) {
+        const sidx_t count = C.get(c);
+        sum += count;
+        B.set(c, end ? sum : sum - count);
+    }
+}
+
+// The suffix array entries are signed during the induction. A positive
+// entry j > 0 is a suffix from which the suffix j - 1 still has to be
+// induced in the current scan, an entry ~j marks a suffix from which
+// nothing is induced. The suffix 0 and empty slots are both stored as 0,
+// as nothing is ever induced from them.
+
+/// Sorts the LMS substrings by inducing from the LMS suffixes, which have
+/// been placed at the ends of their buckets. Afterwards, the LMS suffixes
+/// are stored as ~j in the order of their substrings, all other entries are
+/// zero.
+template<typename text_t, typename array_t, typename bucket_t>
+inline void sort_lms_substrings(const text_t& text, array_t& sa,
+    bucket_t& C, bucket_t& B, sidx_t n, sidx_t k, bool shared) {
+
+    // induce the L-type suffixes, keeping only those preceded by an S-type
+    if(shared) get_counts(text, C, n, k);
+    get_buckets(C, B, k, false);
+
+    sidx_t j = n - 1;
+    sidx_t c1 = text.get(j);
+    sidx_t b = B.get(c1);
+    sa.set(b++, (j > 0 && text.get(j - 1) < c1) ? ~j : j);
+
+    for(sidx_t i = 0; i < n; ++i) {
+        const sidx_t v = sa.get(i);
+        if(v > 0) {
+            j = v - 1;
+            const sidx_t c0 = text.get(j);
+            if(c0 != c1) { B.set(c1, b); c1 = c0; b = B.get(c1); }
+            sa.set(b++, (j > 0 && text.get(j - 1) < c1) ? ~j : j);
+            sa.set(i, 0);
+        } else if(v < 0) {
+            sa.set(i, ~v);
+        }
+    }
+
+    // induce the S-type suffixes, keeping only the LMS suffixes
+    if(shared) get_counts(text, C, n, k);
+    get_buckets(C, B, k, true);
+
+    c1 = 0;
+    b = B.get(c1);
+    for(sidx_t i = n - 1; i >= 0; --i) {
+        const sidx_t v = sa.get(i);
+        if(v > 0) {
+            j = v - 1;
+            const sidx_t c0 = text.get(j);
+            if(c0 != c1) { B.set(c1, b); c1 = c0; b = B.get(c1); }
+            sa.set(--b, (j > 0 && text.get(j - 1) > c1) ? ~j : j);
+            sa.set(i, 0);
+        }
+    }
+}
+
+/// Moves the sorted LMS suffixes to <tt>sa[0, m)</tt> and names their
+/// substrings, starting with 1. The name of the LMS suffix \c p is stored
+/// at <tt>sa[m + p / 2]</tt>, all other entries of <tt>sa[m, n)</tt> are
+/// zero.
+///
+/// \return the amount of distinct names.
+template<typename text_t, typename array_t>
+inline sidx_t name_lms_substrings(
+    const text_t& text, array_t& sa, sidx_t n, sidx_t m) {
+
+    // compact the sorted LMS suffixes, which are never moved to the right
+    for(sidx_t i = 0, j = 0; j < m; ++i) {
+        const sidx_t v = sa.get(i);
+        if(v < 0) {
+            sa.set(j++, ~v);
+            if(i >= m) sa.set(i, 0);
+        }
+    }
+
+    // store the length of each LMS substring, including the next LMS
+    // character, or the virtual sentinel for the last one
+    {
+        sidx_t i = n - 1;
+        sidx_t j = n;
+        sidx_t c0 = text.get(n - 1), c1;
+        do { c1 = c0; } while(--i >= 0 && (c0 = text.get(i)) >= c1);
+        while(i >= 0) {
+            do { c1 = c0; } while(--i >= 0 && (c0 = text.get(i)) <= c1);
+            if(i >= 0) {
+                sa.set(m + ((i + 1) >> 1), j - i);
+                j = i + 1;
+                do { c1 = c0; } while(--i >= 0 && (c0 = text.get(i)) >= c1);
+            }
+        }
+    }
+
+    // name the substrings in their sorted order
+    sidx_t name = 0;
+    sidx_t q = n, qlen = 0;
+    for(sidx_t i = 0; i < m; ++i) {
+        const sidx_t p = sa.get(i);
+        const sidx_t plen = sa.get(m + (p >> 1));
+        bool diff = true;
+        if(plen == qlen && p + plen <= n && q + plen <= n) {
+            sidx_t d = 0;
+            while(d < plen && text.get(p + d) == text.get(q + d)) ++d;
+            diff = (d < plen);
+        }
+        if(diff) {
+            ++name;
+            q = p;
+            qlen = plen;
+        }
+        sa.set(m + (p >> 1), name);
+    }
+    return name;
+}
+
+/// Induces the suffix array from the sorted LMS suffixes, which have been
+/// placed at the ends of their buckets.
+template<typename text_t, typename array_t, typename bucket_t>
+inline void induce(const text_t& text, array_t& sa,
+    bucket_t& C, bucket_t& B, sidx_t n, sidx_t k, bool shared) {
+
+    // induce the L-type suffixes
+    if(shared) get_counts(text, C, n, k);
+    get_buckets(C, B, k, false);
+
+    sidx_t j = n - 1;
+    sidx_t c1 = text.get(j);
+    sidx_t b = B.get(c1);
+    sa.set(b++, (j > 0 && text.get(j - 1) < c1) ? ~j : j);
+
+    for(sidx_t i = 0; i < n; ++i) {
+        const sidx_t v = sa.get(i);
+        sa.set(i, ~v);
+        if(v > 0) {
+            j = v - 1;
+            const sidx_t c0 = text.get(j);
+            if(c0 != c1) { B.set(c1, b); c1 = c0; b = B.get(c1); }
+            sa.set(b++, (j > 0 && text.get(j - 1) < c1) ? ~j : j);
+        }
+    }
+
+    // induce the S-type suffixes
+    if(shared) get_counts(text, C, n, k);
+    get_buckets(C, B, k, true);
+
+    c1 = 0;
+    b = B.get(c1);
+    for(sidx_t i = n - 1; i >= 0; --i) {
+        const sidx_t v = sa.get(i);
+        if(v > 0) {
+            j = v - 1;
+            const sidx_t c0 = text.get(j);
+            if(c0 != c1) { B.set(c1, b); c1 = c0; b = B.get(c1); }
+            sa.set(--b, (j == 0 || text.get(j - 1) > c1) ? ~j : j);
+        } else {
+            sa.set(i, ~v);
+        }
+    }
+}
+
+template<typename text_t, typename array_t>
+inline void sort(const text_t& text, array_t& sa, sidx_t fs, sidx_t n, sidx_t k);
+
+/// Sorts the suffixes of a text of length \c n > 1 over the alphabet
+/// <tt>[0, k)</tt>. The free space <tt>sa[n, n + fs)</tt> is used for the
+/// reduced problem.
+template<typename text_t, typename array_t, typename bucket_t>
+inline void sort(const text_t& text, array_t& sa, sidx_t fs, sidx_t n, sidx_t k,
+    bucket_t& C, bucket_t& B, bool shared) {
+
+    // stage 1: place the LMS suffixes at the ends of their buckets
+    get_counts(text, C, n, k);
+    get_buckets(C, B, k, true);
+    for(sidx_t i = 0; i < n; ++i) sa.set(i, 0);
+
+    sidx_t m = 0;
+    {
+        sidx_t i = n - 1;
+        sidx_t c0 = text.get(n - 1), c1;
+        do { c1 = c0; } while(--i >= 0 && (c0 = text.get(i)) >= c1);
+        while(i >= 0) {
+            do { c1 = c0; } while(--i >= 0 && (c0 = text.get(i)) <= c1);
+            if(i >= 0) {
+                const sidx_t b = B.get(c1) - 1;
+                B.set(c1, b);
+                sa.set(b, i + 1);
+                ++m;
+                do { c1 = c0; } while(--i >= 0 && (c0 = text.get(i)) >= c1);
+            }
+        }
+    }
+
+    // sort and name the LMS substrings
+    sidx_t names = m;
+    if(m > 1) {
+        sort_lms_substrings(text, sa, C, B, n, k, shared);
+        names = name_lms_substrings(text, sa, n, m);
+    }
+
+    // stage 2: if the names are not unique, sort the LMS suffixes by
+    // sorting the suffixes of the reduced text, which is stored at the end
+    // of the free space
+    if(names < m) {
+        const sidx_t ra = n + fs - m;
+        for(sidx_t i = m + (n >> 1) - 1, j = m - 1; i >= m; --i) {
+            const sidx_t v = sa.get(i);
+            if(v != 0) sa.set(ra + j--, v - 1);
+        }
+
+        Slice<array_t> reduced(sa, ra);
+        sais::sort(reduced, sa, n + fs - 2 * m, m, names);
+
+        // map the reduced suffixes back to the LMS suffixes
+        sidx_t i = n - 1;
+        sidx_t j = m - 1;
+        sidx_t c0 = text.get(n - 1), c1;
+        do { c1 = c0; } while(--i >= 0 && (c0 = text.get(i)) >= c1);
+        while(i >= 0) {
+            do { c1 = c0; } while(--i >= 0 && (c0 = text.get(i)) <= c1);
+            if(i >= 0) {
+                reduced.set(j--, i + 1);
+                do { c1 = c0; } while(--i >= 0 && (c0 = text.get(i)) >= c1);
+            }
+        }
+        for(sidx_t i = 0; i < m; ++i) sa.set(i, reduced.get(sa.get(i)));
+    }
+
+    // stage 3: place the sorted LMS suffixes at the ends of their buckets,
+    // from right to left so that no suffix is overwritten, and induce
+    if(m > 1) {
+        get_counts(text, C, n, k);
+        get_buckets(C, B, k, true);
+
+        sidx_t i = m - 1;
+        sidx_t j = n;
+        sidx_t p = sa.get(i);
+        sidx_t c1 = text.get(p);
+        do {
+            const sidx_t c0 = c1;
+            const sidx_t end = B.get(c0);
+            while(end < j) sa.set(--j, 0);
+            do {
+                sa.set(--j, p);
+                if(--i < 0) break;
+                p = sa.get(i);
+            } while((c1 = text.get(p)) == c0);
+        } while(i >= 0);
+        while(j > 0) sa.set(--j, 0);
+    }
+
+    induce(text, sa, C, B, n, k, shared);
+}
+
+/// Sorts the suffixes of a text of length \c n over the alphabet
+/// <tt>[0, k)</tt>, keeping the buckets in the free space
+/// <tt>sa[n, n + fs)</tt> if they fit.
+template<typename text_t, typename array_t>
+inline void sort(const text_t& text, array_t& sa, sidx_t fs, sidx_t n, sidx_t k) {
+    if(n <= 1) {
+        if(n == 1) sa.set(0, 0);
+        return;
+    }
+
+    // the buckets are only needed before and after the recursion, which
+    // is why they may share the free space with the reduced text
+    if(2 * k <= fs) {
+        Slice<array_t> C(sa, n + fs - k);
+        Slice<array_t> B(sa, n + fs - 2 * k);
+        sort(text, sa, fs, n, k, C, B, false);
+    } else if(k <= fs) {
+        Slice<array_t> B(sa, n + fs - k);
+        sort(text, sa, fs, n, k, B, B, true);
+    } else if(k <= sidx_t(ULITERAL_MAX + 1)) {
+        Buffer C(k), B(k);
+        sort(text, sa, fs, n, k, C, B, false);
+    } else {
+        Buffer B(k);
+        sort(text, sa, fs, n, k, B, B, true);
+    }
+}
+
+}
+/// \endcond
+
+/// Constructs the suffix array by induced sorting (SA-IS).
+///
+/// The suffix array is constructed in place: the recursion works in the
+/// unused parts of the array, as do the buckets where possible, so that
+/// only the buckets of the input alphabet need extra space in most cases.
+/// Like divsufsort, the construction needs an additional bit per entry
+/// for marking suffixes.
+///
+/// In compressed mode, the array is not shrunk to the final bit width
+/// after construction, as that would require a copy and thus increase the
+/// memory peak.
+class SAInducedSorting: public Algorithm, public ArrayDS {
+    CompressMode m_cm;
+
+public:
+    inline static Meta meta() {
+        Meta m("sa", "sais", "Induced sorting (SA-IS)");
+        return m;
+    }
+
+    inline static ds::InputRestrictions restrictions() {
+        return ds::InputRestrictions {
+            { 0 },
+            true
+        };
+    }
+
+    /// Restores the array from data constructed earlier.
+    inline SAInducedSorting(Env&& env, iv_t&& data)
+        : Algorithm(std::move(env)), ArrayDS(std::move(data)),
+          m_cm(CompressMode::plain) {
+    }
+
+    template<typename textds_t>
+    inline SAInducedSorting(Env&& env, const textds_t& t, CompressMode cm)
+        : Algorithm(std::move(env)), m_cm(cm) {
+
+        StatPhase::wrap("Construct SA", [&]{
+            // Allocate
+            const size_t n = t.size();
+            const size_t w = bits_for(n);
+            const size_t k = ULITERAL_MAX + 1;
+
+            set_array(iv_t(n, 0, (cm == CompressMode::compressed) ?
+                w + 1 : index_width(size_t(1) << w)));
+
+            // Sort, on a plain array if possible
+            sais::ByteText text(t.text());
+            if(width() == 32) {
+                sais::RawArray<int32_t> sa((int32_t*) data());
+                sais::sort(text, sa, 0, n, k);
+            } else if(width() == 64) {
+                sais::RawArray<int64_t> sa((int64_t*) data());
+                sais::sort(text, sa, 0, n, k);
+            } else {
+                sais::PackedArray sa(*this);
+                sais::sort(text, sa, 0, n, k);
+            }
+
+            StatPhase::log("bit_width", size_t(width()));
+            StatPhase::log("size", bit_size() / 8);
+        });
+
+        if(cm == CompressMode::compressed || cm == CompressMode::delayed) {
+            compress();
+        }
+    }
+
+    void compress() {
+        debug_check_array_is_initialized();
+
+        StatPhase::wrap("Compress SA", [this]{
+            width(bits_for(size()));
+            if(m_cm != CompressMode::compressed) shrink_to_fit();
+
+            StatPhase::log("bit_width", size_t(width()));
+            StatPhase::log("size", bit_size() / 8);
+        });
+    }
+};
+
+namespace ds {
+
+template<>
+struct SAConstruction<SAInducedSorting> {
+    static constexpr bool modelled = true;
+
+    // with an additional bit for marking suffixes
+    inline static size_t width(size_t n, CompressMode cm) {
+        const size_t w = bits_for(n);
+        return (cm == CompressMode::compressed) ? w + 1 : index_width(size_t(1) << w);
+    }
+
+    // not shrunk in compressed mode
+    inline static size_t compressed_width(size_t n, CompressMode cm) {
+        return (cm == CompressMode::compressed) ? width(n, cm) : bits_for(n);
+    }
+
+    // with the buckets of the input alphabet, as those of the recursion
+    // fit into the unused part of the array
+    inline static size_t peak(size_t n, CompressMode cm) {
+        return plan::bytes(n, width(n, cm)) + 2 * (ULITERAL_MAX + 1) * sizeof(sais::sidx_t);
+    }
+};
+
+}
+
+} //ns
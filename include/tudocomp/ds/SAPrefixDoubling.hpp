@@ -0,0 +1,455 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <tudocomp/ds/TextDSFlags.hpp>
+#include <tudocomp/ds/CompressMode.hpp>
+#include <tudocomp/ds/ArrayDS.hpp>
+#include <tudocomp/ds/TextDSPlan.hpp>
+#include <tudocomp/util/Parallel.hpp>
+
+#include <tudocomp_stat/StatPhase.hpp>
+
+namespace tdc {
+
+/// \cond INTERNAL
+namespace doubling {
+
+/// Sorts the suffixes of a text by parallel prefix doubling.
+///
+/// The suffix array is partitioned into groups of suffixes that share a
+/// prefix of length \c h, and the rank of a suffix is the position of its
+/// group's first suffix. Groups with more than one suffix are sorted by the
+/// rank of the suffix \c h positions further, which yields the groups for
+/// <tt>2h</tt>. The first suffix of each group is flagged by the highest bit
+/// of its suffix array entry.
+///
+/// Groups are distributed over the threads in batches, except for groups
+/// larger than a thread's share of the unsorted suffixes, which are each
+/// processed by all threads.
+template<typename idx_t>
+class Sorter {
+    static constexpr idx_t FLAG = idx_t(1) << (8 * sizeof(idx_t) - 1);
+
+    /// The maximum binary logarithm of the amount of buckets for the
+    /// initial sort by the first characters.
+    static constexpr size_t BUCKET_BITS = 16;
+
+    /// Groups of at least this size are always processed by all threads.
+    static constexpr size_t LARGE_GROUP = 1ULL << 16;
+
+    /// The amount of batches of groups per thread, for load balancing.
+    static constexpr size_t BATCHES_PER_THREAD = 16;
+
+    struct Group {
+        idx_t begin;
+        idx_t end;
+
+        inline size_t size() const { return end - begin; }
+    };
+
+    /// A suffix and its sort key.
+    struct Record {
+        idx_t key;
+        idx_t suffix;
+    };
+
+    const uliteral_t* m_text;
+    const size_t m_n;
+    const size_t m_threads;
+
+    std::vector<idx_t> m_sa;
+    std::vector<idx_t> m_rank;
+
+    std::vector<Group> m_groups; // the groups with more than one suffix
+    size_t m_unsorted; // the amount of suffixes in these groups
+
+    std::vector<std::vector<Record>> m_buffers; // of each thread
+
+    /// The key of a suffix, given that its first h characters are sorted.
+    inline idx_t key(const size_t i, const size_t h) const {
+        return (i + h < m_n) ? m_rank[i + h] + 1 : 0;
+    }
+
+    inline bool is_large(const Group& g) const {
+        return m_threads > 1 &&
+            g.size() >= std::max(size_t(LARGE_GROUP), m_unsorted / m_threads);
+    }
+
+    /// Calls \c work(t, g) for each group \c g that is not large, using
+    /// dynamically assigned batches of groups.
+    template<typename work_t>
+    inline void for_small_groups(work_t work) {
+        const size_t batches = std::min(m_groups.size(), m_threads * BATCHES_PER_THREAD);
+        std::atomic<size_t> next(0);
+
+        parallel_run(m_threads, [&](size_t t) {
+            for(size_t b; (b = next++) < batches;) {
+                const size_t first = m_groups.size() * b / batches;
+                const size_t last = m_groups.size() * (b + 1) / batches;
+                for(size_t i = first; i < last; ++i) {
+                    if(!is_large(m_groups[i])) work(t, m_groups[i]);
+                }
+            }
+        });
+    }
+
+    /// Sorts the suffixes by their first characters, and returns the amount
+    /// of characters they are sorted by.
+    inline size_t bucket_sort() {
+        const size_t n = m_n;
+        std::vector<size_t> bounds(m_threads + 1);
+        for(size_t t = 0; t <= m_threads; ++t) bounds[t] = n * t / m_threads;
+
+        // map the occurring characters to consecutive codes
+        std::vector<size_t> hist(m_threads * (ULITERAL_MAX + 1), 0);
+        parallel_run(m_threads, [&](size_t t) {
+            size_t* h = hist.data() + t * (ULITERAL_MAX + 1);
+            for(size_t i = bounds[t]; i < bounds[t + 1]; ++i) ++h[m_text[i]];
+        });
+        std::vector<size_t> code(ULITERAL_MAX + 1, 0);
+        size_t sigma = 0;
+        for(size_t c = 0; c <= ULITERAL_MAX; ++c) {
+            bool occurs = false;
+            for(size_t t = 0; t < m_threads; ++t) occurs |= hist[t * (ULITERAL_MAX + 1) + c] > 0;
+            if(occurs) code[c] = sigma++;
+        }
+
+        // the bucket of a suffix is given by as many codes as fit into
+        // BUCKET_BITS bits, where positions beyond the text have code zero
+        const size_t bits = bits_for(std::max<size_t>(sigma, 1) - 1);
+        const size_t chars = std::max<size_t>(1, BUCKET_BITS / bits);
+        const size_t num_buckets = size_t(1) << (chars * bits);
+        const size_t mask = num_buckets - 1;
+
+        // calls f(i, bucket) for each suffix i of a chunk, in reverse order
+        auto for_buckets = [&](size_t t, auto f) {
+            if(bounds[t] == bounds[t + 1]) return;
+            size_t bucket = 0;
+            for(size_t j = 0; j < chars; ++j) {
+                const size_t i = bounds[t + 1] - 1 + j;
+                bucket = (bucket << bits) | ((i < n) ? code[m_text[i]] : 0);
+            }
+            for(size_t i = bounds[t + 1]; i-- > bounds[t];) {
+                if(i + 1 < bounds[t + 1]) {
+                    bucket = ((bucket >> bits) |
+                        (code[m_text[i]] << (bits * (chars - 1)))) & mask;
+                }
+                f(i, bucket);
+            }
+        };
+
+        std::vector<size_t> offsets(m_threads * num_buckets, 0);
+        parallel_run(m_threads, [&](size_t t) {
+            size_t* count = offsets.data() + t * num_buckets;
+            for_buckets(t, [&](size_t, size_t bucket) { ++count[bucket]; });
+        });
+
+        // turn the counts into positions, chunk by chunk within each bucket
+        std::vector<size_t> bucket_begin(num_buckets + 1);
+        size_t sum = 0;
+        for(size_t b = 0; b < num_buckets; ++b) {
+            bucket_begin[b] = sum;
+            for(size_t t = 0; t < m_threads; ++t) {
+                const size_t count = offsets[t * num_buckets + b];
+                offsets[t * num_buckets + b] = sum;
+                sum += count;
+            }
+        }
+        bucket_begin[num_buckets] = n;
+
+        parallel_run(m_threads, [&](size_t t) {
+            size_t* offset = offsets.data() + t * num_buckets;
+            for_buckets(t, [&](size_t i, size_t bucket) {
+                m_sa[offset[bucket]++] = idx_t(i);
+                m_rank[i] = idx_t(bucket_begin[bucket]);
+            });
+        });
+
+        // flag the buckets and collect the unsorted ones
+        m_unsorted = 0;
+        for(size_t b = 0; b < num_buckets; ++b) {
+            const Group g { idx_t(bucket_begin[b]), idx_t(bucket_begin[b + 1]) };
+            if(g.size() > 0) m_sa[g.begin] |= FLAG;
+            if(g.size() > 1) {
+                m_groups.push_back(g);
+                m_unsorted += g.size();
+            }
+        }
+
+        StatPhase::log("sigma", sigma);
+        StatPhase::log("initial_chars", chars);
+        return chars;
+    }
+
+    /// Writes the sorted records of a group back into the suffix array,
+    /// flagging the first suffix of each new group.
+    inline void write_back(const Group& g, const Record* r, size_t from, size_t to) {
+        for(size_t j = from; j < to; ++j) {
+            const bool first = (j == 0) || (r[j].key != r[j - 1].key);
+            m_sa[g.begin + j] = r[j].suffix | (first ? FLAG : 0);
+        }
+    }
+
+    /// Sorts each group by the keys of its suffixes for the given h.
+    inline void sort_groups(const size_t h) {
+        auto by_key = [](const Record& a, const Record& b) { return a.key < b.key; };
+
+        for_small_groups([&](size_t t, const Group& g) {
+            auto& records = m_buffers[t];
+            records.resize(g.size());
+            for(size_t x = g.begin; x < g.end; ++x) {
+                const idx_t i = m_sa[x] & ~FLAG;
+                records[x - g.begin] = Record { key(i, h), i };
+            }
+            std::sort(records.begin(), records.end(), by_key);
+            write_back(g, records.data(), 0, g.size());
+        });
+
+        std::vector<Record> records;
+        for(const Group& g : m_groups) {
+            if(!is_large(g)) continue;
+
+            const size_t size = g.size();
+            records.resize(size);
+            parallel_run(m_threads, [&](size_t t) {
+                for(size_t j = size * t / m_threads; j < size * (t + 1) / m_threads; ++j) {
+                    const idx_t i = m_sa[g.begin + j] & ~FLAG;
+                    records[j] = Record { key(i, h), i };
+                }
+            });
+            parallel_sort(records.begin(), records.end(), by_key, m_threads);
+            parallel_run(m_threads, [&](size_t t) {
+                write_back(g, records.data(), size * t / m_threads, size * (t + 1) / m_threads);
+            });
+        }
+    }
+
+    /// Sets the ranks of the suffixes of the sorted groups to the positions
+    /// of their new groups, and collects the new groups with more than one
+    /// suffix.
+    inline void update_ranks() {
+        std::vector<std::vector<Group>> found(m_threads);
+        std::vector<size_t> unsorted(m_threads, 0);
+
+        // processes the suffixes in [from, to) of a group, where the first
+        // suffix belongs to the group beginning at position g; new groups
+        // that begin in this range and end at most at next are collected
+        auto scan = [&](size_t t, size_t g, const size_t from, const size_t to, const size_t next) {
+            auto found_group = [&](size_t begin, size_t end) {
+                if(begin >= from && end - begin > 1) {
+                    found[t].push_back(Group { idx_t(begin), idx_t(end) });
+                    unsorted[t] += end - begin;
+                }
+            };
+            for(size_t x = from; x < to; ++x) {
+                const idx_t entry = m_sa[x];
+                if(entry & FLAG) {
+                    if(x > g) found_group(g, x);
+                    g = x;
+                }
+                m_rank[entry & ~FLAG] = idx_t(g);
+            }
+            found_group(g, next);
+        };
+
+        for_small_groups([&](size_t t, const Group& g) {
+            scan(t, g.begin, g.begin, g.end, g.end);
+        });
+
+        for(const Group& g : m_groups) {
+            if(!is_large(g)) continue;
+
+            // split the group into parts and find the first and last new
+            // group beginning in each part
+            const size_t size = g.size();
+            std::vector<size_t> part(m_threads + 1);
+            for(size_t t = 0; t <= m_threads; ++t) part[t] = g.begin + size * t / m_threads;
+
+            std::vector<size_t> first(m_threads, g.end), last(m_threads, g.end);
+            parallel_run(m_threads, [&](size_t t) {
+                for(size_t x = part[t]; x < part[t + 1]; ++x) {
+                    if(m_sa[x] & FLAG) {
+                        if(first[t] == g.end) first[t] = x;
+                        last[t] = x;
+                    }
+                }
+            });
+
+            // the group of the first suffix of each part, and the beginning
+            // of the first new group following each part
+            std::vector<size_t> incoming(m_threads), next(m_threads);
+            size_t current = g.begin;
+            for(size_t t = 0; t < m_threads; ++t) {
+                incoming[t] = current;
+                if(last[t] != g.end) current = last[t];
+            }
+            current = g.end;
+            for(size_t t = m_threads; t-- > 0;) {
+                next[t] = current;
+                if(first[t] != g.end) current = first[t];
+            }
+
+            parallel_run(m_threads, [&](size_t t) {
+                scan(t, incoming[t], part[t], part[t + 1], next[t]);
+            });
+        }
+
+        m_groups.clear();
+        m_unsorted = 0;
+        for(size_t t = 0; t < m_threads; ++t) {
+            m_groups.insert(m_groups.end(), found[t].begin(), found[t].end());
+            m_unsorted += unsorted[t];
+        }
+    }
+
+public:
+    /// Sorts the suffixes of a text of length \c n, which must be less than
+    /// the flag bit of \c idx_t.
+    inline Sorter(const uliteral_t* text, size_t n, size_t threads)
+        : m_text(text), m_n(n), m_threads(threads),
+          m_sa(n), m_rank(n), m_buffers(threads) {
+
+        DCHECK_LT(n, size_t(FLAG));
+
+        size_t h = bucket_sort();
+        size_t iterations = 0;
+        for(; !m_groups.empty(); h *= 2, ++iterations) {
+            sort_groups(h);
+            update_ranks();
+        }
+        StatPhase::log("iterations", iterations);
+
+        m_rank = std::vector<idx_t>();
+        m_buffers.clear();
+        parallel_run(m_threads, [&](size_t t) {
+            for(size_t x = n * t / m_threads; x < n * (t + 1) / m_threads; ++x) {
+                m_sa[x] &= ~FLAG;
+            }
+        });
+    }
+
+    /// The suffix array.
+    inline const std::vector<idx_t>& sa() const {
+        return m_sa;
+    }
+};
+
+} // namespace doubling
+/// \endcond
+
+/// Constructs the suffix array by prefix doubling on multiple threads.
+///
+/// The suffixes are first sorted by their first characters, then groups of
+/// suffixes that share a prefix of length \c h are repeatedly sorted by the
+/// suffixes \c h positions further, doubling \c h until every suffix is in
+/// its own group. The work is distributed over \c threads threads (0 for
+/// all hardware threads).
+///
+/// The suffix array is constructed in 32-bit integers for texts shorter
+/// than 2^31, and in 64-bit integers otherwise, along with the ranks of the
+/// suffixes in the same width. It is then copied into an array of the
+/// width requested by the compress mode.
+class SAPrefixDoubling: public Algorithm, public ArrayDS {
+    template<typename idx_t>
+    inline void construct(const uliteral_t* text, size_t n, size_t width, size_t threads) {
+        const doubling::Sorter<idx_t> sorter(text, n, threads);
+        const std::vector<idx_t>& sa = sorter.sa();
+
+        // allocate only now that the ranks have been freed
+        set_array(iv_t(n, 0, width));
+
+        // copy in chunks of whole words of the bit-packed array
+        const size_t words = idiv_ceil(n, 64);
+        parallel_run(threads, [&](size_t t) {
+            const size_t from = std::min(n, 64 * (words * t / threads));
+            const size_t to = std::min(n, 64 * (words * (t + 1) / threads));
+            for(size_t i = from; i < to; ++i) (*this)[i] = sa[i];
+        });
+    }
+
+public:
+    inline static Meta meta() {
+        Meta m("sa", "doubling", "Parallel prefix doubling");
+        m.option("threads").dynamic(0); // 0 for all hardware threads
+        return m;
+    }
+
+    inline static ds::InputRestrictions restrictions() {
+        return ds::InputRestrictions {
+            { 0 },
+            true
+        };
+    }
+
+    /// Restores the array from data constructed earlier.
+    inline SAPrefixDoubling(Env&& env, iv_t&& data)
+        : Algorithm(std::move(env)), ArrayDS(std::move(data)) {
+    }
+
+    template<typename textds_t>
+    inline SAPrefixDoubling(Env&& env, const textds_t& t, CompressMode cm)
+        : Algorithm(std::move(env)) {
+
+        StatPhase::wrap("Construct SA", [&]{
+            const size_t n = t.size();
+            const size_t threads = resolve_thread_count(
+                this->env().option("threads").as_integer());
+            StatPhase::log("threads", threads);
+
+            const size_t w = (cm == CompressMode::compressed) ? bits_for(n) : index_width(n);
+            if(n < (size_t(1) << 31)) {
+                construct<uint32_t>(t.text(), n, w, threads);
+            } else {
+                construct<uint64_t>(t.text(), n, w, threads);
+            }
+
+            StatPhase::log("bit_width", size_t(width()));
+            StatPhase::log("size", bit_size() / 8);
+        });
+
+        if(cm == CompressMode::compressed || cm == CompressMode::delayed) {
+            compress();
+        }
+    }
+
+    void compress() {
+        debug_check_array_is_initialized();
+
+        StatPhase::wrap("Compress SA", [this]{
+            width(bits_for(size()));
+            shrink_to_fit();
+
+            StatPhase::log("bit_width", size_t(width()));
+            StatPhase::log("size", bit_size() / 8);
+        });
+    }
+};
+
+namespace ds {
+
+template<>
+struct SAConstruction<SAPrefixDoubling> {
+    static constexpr bool modelled = true;
+
+    inline static size_t width(size_t n, CompressMode cm) {
+        return (cm == CompressMode::compressed) ? bits_for(n) : index_width(n);
+    }
+
+    inline static size_t compressed_width(size_t n, CompressMode) {
+        return bits_for(n);
+    }
+
+    // the suffix and rank arrays along with the records of a group, which
+    // may contain all suffixes, then the suffix array while it is copied
+    inline static size_t peak(size_t n, CompressMode cm) {
+        const size_t idx = (n < (size_t(1) << 31)) ? sizeof(uint32_t) : sizeof(uint64_t);
+        return std::max(4 * n * idx, n * idx + plan::bytes(n, width(n, cm)));
+    }
+};
+
+}
+
+}
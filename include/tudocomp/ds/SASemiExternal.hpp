@@ -0,0 +1,513 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <tudocomp/ds/TextDSFlags.hpp>
+#include <tudocomp/ds/CompressMode.hpp>
+#include <tudocomp/ds/ArrayDS.hpp>
+#include <tudocomp/util/Parallel.hpp>
+#include <tudocomp/util/View.hpp>
+
+#include <tudocomp_stat/StatPhase.hpp>
+
+namespace tdc {
+
+/// \cond INTERNAL
+namespace semi_external {
+
+/// A difference cover modulo \c v, i.e., a set \c D of residues such that
+/// every residue is the difference of two elements of \c D.
+///
+/// For any two positions \c i and \c j, there is a \c d less than \c v such
+/// that both <tt>i + d</tt> and <tt>j + d</tt> have residues in \c D. Hence,
+/// two suffixes that share a prefix of length \c v are ordered like the
+/// suffixes at these positions.
+class DifferenceCover {
+    size_t m_v;
+    size_t m_log_v;
+    std::vector<size_t> m_cover;
+    std::vector<size_t> m_index; // the index of each residue in the cover
+    std::vector<size_t> m_base;  // an element x with x + d in the cover
+
+public:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    /// Constructs a cover greedily, adding the residue that covers the most
+    /// differences not covered yet.
+    ///
+    /// \param v the modulus, a power of two.
+    inline DifferenceCover(size_t v)
+        : m_v(v), m_log_v(bits_for(v) - 1),
+          m_index(v, size_t(NONE)), m_base(v, size_t(NONE)) {
+
+        CHECK(v > 0 && (v & (v - 1)) == 0) << "the period must be a power of two";
+
+        auto add = [&](size_t x) {
+            m_index[x] = m_cover.size();
+            m_cover.push_back(x);
+            for(size_t y : m_cover) {
+                const size_t dxy = (x - y) & (v - 1), dyx = (y - x) & (v - 1);
+                if(m_base[dxy] == NONE) m_base[dxy] = y;
+                if(m_base[dyx] == NONE) m_base[dyx] = x;
+            }
+        };
+
+        add(0);
+        while(std::find(m_base.begin(), m_base.end(), size_t(NONE)) != m_base.end()) {
+            size_t best = 0, best_gain = 0;
+            for(size_t x = 1; x < v; ++x) {
+                if(m_index[x] != NONE) continue;
+
+                size_t gain = 0;
+                for(size_t y : m_cover) {
+                    const size_t dxy = (x - y) & (v - 1), dyx = (y - x) & (v - 1);
+                    gain += (m_base[dxy] == NONE) + (dyx != dxy && m_base[dyx] == NONE);
+                }
+                if(gain > best_gain) {
+                    best = x;
+                    best_gain = gain;
+                }
+            }
+            add(best);
+        }
+    }
+
+    inline size_t period() const { return m_v; }
+    inline size_t size() const { return m_cover.size(); }
+
+    /// Whether position \c i is in the sample.
+    inline bool sampled(size_t i) const {
+        return m_index[i & (m_v - 1)] != NONE;
+    }
+
+    /// The index of sampled position \c i among all sampled positions.
+    inline size_t index(size_t i) const {
+        return (i >> m_log_v) * m_cover.size() + m_index[i & (m_v - 1)];
+    }
+
+    /// An upper bound for the indices of the sampled positions of a text
+    /// of length \c n.
+    inline size_t index_bound(size_t n) const {
+        return ((n >> m_log_v) + 1) * m_cover.size();
+    }
+
+    /// The smallest \c d such that <tt>i + d</tt> and <tt>j + d</tt> are
+    /// sampled.
+    inline size_t offset(size_t i, size_t j) const {
+        return (m_base[(j - i) & (m_v - 1)] - i) & (m_v - 1);
+    }
+};
+
+/// Sorts the suffixes of a text in batches that fit into a buffer.
+///
+/// First, the suffixes starting at the positions of a difference cover
+/// sample are ranked by prefix doubling. Afterwards, any two suffixes can be
+/// compared by their first \c v characters and the ranks of two sampled
+/// suffixes, so each batch can be sorted by comparisons in memory.
+///
+/// A batch consists of the suffixes of consecutive buckets, where a bucket
+/// holds the suffixes starting with the same two characters. A bucket that
+/// does not fit into the buffer on its own is split into ranges of the
+/// suffix order by sampled splitter suffixes, repeatedly if a range is still
+/// too large. The suffixes of a batch are collected in a scan over the text,
+/// sorted and then passed on, in suffix array order.
+template<typename idx_t>
+class Sorter {
+    static constexpr size_t NONE = SIZE_MAX;
+
+    const View m_text;
+    const size_t m_n;
+    const size_t m_threads;
+    const DifferenceCover m_cover;
+
+    std::vector<idx_t> m_rank; // of the sampled suffixes
+
+    // the state of sort
+    std::vector<size_t> m_bounds; // of the chunks of the text per thread
+    std::vector<idx_t> m_batch;
+    size_t m_sorted;
+    size_t m_batches;
+
+    struct Group {
+        size_t begin;
+        size_t end;
+    };
+
+    inline static size_t bucket(View text, size_t i) {
+        return (size_t(text[i]) << 8) | ((i + 1 < text.size()) ? text[i + 1] : 0);
+    }
+
+    /// Compares the first \c max characters of two suffixes.
+    inline int compare_prefix(size_t i, size_t j, size_t max) const {
+        if(i == j) return 0;
+        const size_t l = lce(m_text, i, j, max);
+        if(l == max) return 0;
+        // the unique sentinel ensures a mismatch within the text
+        return (m_text[i + l] < m_text[j + l]) ? -1 : 1;
+    }
+
+    /// Ranks the sampled suffixes by prefix doubling.
+    inline void rank_sample() {
+        const size_t v = m_cover.period();
+
+        std::vector<idx_t> sa;
+        for(size_t i = 0; i < m_n; ++i) {
+            if(m_cover.sampled(i)) sa.push_back(idx_t(i));
+        }
+        const size_t m = sa.size();
+        m_rank.resize(m_cover.index_bound(m_n));
+
+        // sort by the first v characters
+        parallel_sort(sa.begin(), sa.end(), [&](idx_t i, idx_t j) {
+            return compare_prefix(i, j, v) < 0;
+        }, m_threads);
+
+        std::vector<Group> groups;
+        auto assign = [&](size_t begin, size_t end, auto equal) {
+            for(size_t x = begin; x < end;) {
+                size_t y = x + 1;
+                while(y < end && equal(y - 1, y)) ++y;
+                for(size_t z = x; z < y; ++z) m_rank[m_cover.index(sa[z])] = idx_t(x);
+                if(y - x > 1) groups.push_back(Group { x, y });
+                x = y;
+            }
+        };
+        assign(0, m, [&](size_t x, size_t y) {
+            return compare_prefix(sa[x], sa[y], v) == 0;
+        });
+
+        // refine the groups by the rank h positions further, which is
+        // sampled as well, updating ranks as soon as a group is sorted
+        struct Record {
+            idx_t key;
+            idx_t suffix;
+        };
+        std::vector<Record> records;
+        size_t iterations = 0;
+        for(size_t h = v; !groups.empty(); h *= 2, ++iterations) {
+            std::vector<Group> unsorted;
+            std::swap(groups, unsorted);
+
+            for(const Group& g : unsorted) {
+                records.resize(g.end - g.begin);
+                for(size_t x = g.begin; x < g.end; ++x) {
+                    const size_t i = sa[x];
+                    const idx_t key = (i + h < m_n) ? m_rank[m_cover.index(i + h)] + 1 : 0;
+                    records[x - g.begin] = Record { key, sa[x] };
+                }
+
+                auto by_key = [](const Record& a, const Record& b) { return a.key < b.key; };
+                if(records.size() >= (size_t(1) << 16)) {
+                    parallel_sort(records.begin(), records.end(), by_key, m_threads);
+                } else {
+                    std::sort(records.begin(), records.end(), by_key);
+                }
+
+                for(size_t x = g.begin; x < g.end; ++x) sa[x] = records[x - g.begin].suffix;
+                assign(g.begin, g.end, [&](size_t x, size_t y) {
+                    return records[x - g.begin].key == records[y - g.begin].key;
+                });
+            }
+        }
+
+        StatPhase::log("sample_size", m);
+        StatPhase::log("iterations", iterations);
+    }
+
+    /// Whether suffix \c i is smaller than suffix \c j.
+    inline bool less(size_t i, size_t j) const {
+        const size_t v = m_cover.period();
+        const int c = compare_prefix(i, j, v);
+        if(c != 0) return c < 0;
+
+        const size_t d = m_cover.offset(i, j);
+        return m_rank[m_cover.index(i + d)] < m_rank[m_cover.index(j + d)];
+    }
+
+    /// Collects the \c size suffixes \c i for which \c in_batch(i) holds,
+    /// sorts them and passes them on.
+    template<typename in_batch_t, typename emit_t>
+    inline void emit_batch(size_t size, in_batch_t in_batch, emit_t& emit) {
+        // each thread collects the suffixes of its chunk
+        std::vector<size_t> offsets(m_threads);
+        parallel_run(m_threads, [&](size_t t) {
+            size_t count = 0;
+            for(size_t i = m_bounds[t]; i < m_bounds[t + 1]; ++i) count += in_batch(i);
+            offsets[t] = count;
+        });
+        for(size_t t = 0, sum = 0; t < m_threads; ++t) {
+            std::swap(offsets[t], sum);
+            sum += offsets[t];
+        }
+
+        m_batch.resize(size);
+        parallel_run(m_threads, [&](size_t t) {
+            size_t x = offsets[t];
+            for(size_t i = m_bounds[t]; i < m_bounds[t + 1]; ++i) {
+                if(in_batch(i)) m_batch[x++] = idx_t(i);
+            }
+        });
+
+        parallel_sort(m_batch.begin(), m_batch.end(), [&](idx_t i, idx_t j) {
+            return less(i, j);
+        }, m_threads);
+
+        emit(m_sorted, m_batch);
+        m_sorted += size;
+        ++m_batches;
+    }
+
+    /// Passes on the \c size suffixes of bucket \c b that are not smaller
+    /// than suffix \c lo and smaller than suffix \c hi (\c NONE for no
+    /// bound), in batches of at most \c buffer suffixes.
+    template<typename emit_t>
+    inline void split(size_t b, size_t lo, size_t hi, size_t size,
+                      size_t buffer, emit_t& emit) {
+
+        auto in_range = [&](size_t i) {
+            return bucket(m_text, i) == b &&
+                (lo == NONE || !less(i, lo)) && (hi == NONE || less(i, hi));
+        };
+        if(size <= buffer) {
+            emit_batch(size, in_range, emit);
+            return;
+        }
+
+        // sample k + 1 suffixes of the range, aiming at parts of half the
+        // buffer, while the splitters and their counters per thread take at
+        // most half of it
+        const size_t k = std::min({
+            idiv_ceil(2 * size, buffer),
+            std::max<size_t>(buffer / (4 * (m_threads + 1)), 1),
+            size - 1});
+        const size_t step = size / (k + 1);
+
+        std::vector<idx_t> splitters;
+        splitters.reserve(k + 1);
+        for(size_t i = 0, x = 0; i < m_n && splitters.size() <= k; ++i) {
+            if(in_range(i) && x++ % step == 0) splitters.push_back(idx_t(i));
+        }
+        DCHECK_EQ(splitters.size(), k + 1);
+
+        // without the smallest sample, every part is smaller than the range
+        std::sort(splitters.begin(), splitters.end(), [&](idx_t i, idx_t j) {
+            return less(i, j);
+        });
+        splitters.erase(splitters.begin());
+
+        // count the suffixes of each part p, between splitters p - 1 and p
+        auto part = [&](size_t i) {
+            return size_t(std::upper_bound(splitters.begin(), splitters.end(), idx_t(i),
+                [&](idx_t x, idx_t y) { return less(x, y); }) - splitters.begin());
+        };
+        std::vector<idx_t> counts;
+        {
+            std::vector<idx_t> thread_counts(m_threads * (k + 1), 0);
+            parallel_run(m_threads, [&](size_t t) {
+                idx_t* count = thread_counts.data() + t * (k + 1);
+                for(size_t i = m_bounds[t]; i < m_bounds[t + 1]; ++i) {
+                    if(in_range(i)) ++count[part(i)];
+                }
+            });
+            counts.assign(thread_counts.begin(), thread_counts.begin() + k + 1);
+            for(size_t t = 1; t < m_threads; ++t) {
+                for(size_t p = 0; p <= k; ++p) counts[p] += thread_counts[t * (k + 1) + p];
+            }
+        }
+
+        // pass on consecutive parts that fit into the buffer together
+        for(size_t first = 0; first <= k;) {
+            size_t last = first;
+            size_t part_size = 0;
+            while(last <= k && (last == first || part_size + counts[last] <= buffer)) {
+                part_size += counts[last++];
+            }
+
+            if(part_size > 0) {
+                split(b,
+                    (first == 0) ? lo : size_t(splitters[first - 1]),
+                    (last > k) ? hi : size_t(splitters[last - 1]),
+                    part_size, buffer, emit);
+            }
+            first = last;
+        }
+    }
+
+public:
+    /// Prepares sorting the suffixes of a text.
+    ///
+    /// \param text the text, ending with a unique sentinel.
+    /// \param period the period of the difference cover.
+    /// \param threads the amount of threads.
+    inline Sorter(View text, size_t period, size_t threads)
+        : m_text(text), m_n(text.size()), m_threads(threads), m_cover(period) {
+
+        StatPhase::log("cover_size", m_cover.size());
+        rank_sample();
+    }
+
+    /// Sorts all suffixes and calls <tt>emit(offset, batch)</tt> for each
+    /// batch in order, where \c batch holds the entries of the suffix array
+    /// starting at \c offset.
+    ///
+    /// \param buffer the maximum amount of suffixes per batch.
+    template<typename emit_t>
+    inline void sort(size_t buffer, emit_t emit) {
+        static constexpr size_t BUCKETS = 1ULL << 16;
+
+        const size_t n = m_n;
+        m_bounds.resize(m_threads + 1);
+        for(size_t t = 0; t <= m_threads; ++t) m_bounds[t] = n * t / m_threads;
+
+        // count the suffixes in each bucket
+        std::vector<size_t> counts(m_threads * BUCKETS, 0);
+        parallel_run(m_threads, [&](size_t t) {
+            size_t* count = counts.data() + t * BUCKETS;
+            for(size_t i = m_bounds[t]; i < m_bounds[t + 1]; ++i) ++count[bucket(m_text, i)];
+        });
+
+        std::vector<size_t> bucket_size(BUCKETS, 0);
+        for(size_t t = 0; t < m_threads; ++t) {
+            for(size_t b = 0; b < BUCKETS; ++b) bucket_size[b] += counts[t * BUCKETS + b];
+        }
+
+        m_sorted = 0;
+        m_batches = 0;
+        for(size_t first = 0; first < BUCKETS;) {
+            // extend the batch by whole buckets
+            size_t last = first;
+            size_t size = 0;
+            while(last < BUCKETS && (last == first || size + bucket_size[last] <= buffer)) {
+                size += bucket_size[last++];
+            }
+
+            if(size > buffer) {
+                // a single bucket
+                split(first, NONE, NONE, size, buffer, emit);
+            } else if(size > 0) {
+                emit_batch(size, [&](size_t i) {
+                    const size_t b = bucket(m_text, i);
+                    return b >= first && b < last;
+                }, emit);
+            }
+            first = last;
+        }
+        DCHECK_EQ(m_sorted, n);
+
+        StatPhase::log("batches", m_batches);
+        m_batch = std::vector<idx_t>();
+    }
+};
+
+} // namespace semi_external
+/// \endcond
+
+/// Constructs the suffix array in batches of a bounded size.
+///
+/// Only the text, the ranks of a difference cover sample of the suffixes
+/// and one batch of suffixes are held in memory, while the suffix array is
+/// written batch by batch from left to right. Each batch costs one scan
+/// over the text, and splitting a bucket that exceeds the budget costs two
+/// more scans per level. Combined with file-backed storage for the suffix array
+/// (see the \c external option of \ref TextDS), this allows constructing
+/// suffix arrays that do not fit into memory.
+///
+/// The sample consists of about \c 1.5/sqrt(period) of the suffixes. Two
+/// suffixes are compared by at most \c period characters, followed by the
+/// ranks of two sampled suffixes. The batches are sorted on \c threads
+/// threads (0 for all hardware threads).
+class SASemiExternal: public Algorithm, public ArrayDS {
+    template<typename idx_t>
+    inline void construct(View text, size_t width, size_t budget,
+                          size_t period, size_t threads) {
+
+        semi_external::Sorter<idx_t> sorter(text, period, threads);
+
+        const size_t n = text.size();
+        set_array(iv_t(n, 0, width));
+
+        // sorting a batch takes a second buffer of the same size
+        const size_t buffer = std::max<size_t>(budget / (2 * sizeof(idx_t)), 1);
+        sorter.sort(buffer, [&](size_t offset, const std::vector<idx_t>& batch) {
+            // write in chunks of whole words of the bit-packed array
+            const size_t size = batch.size();
+            parallel_run(threads, [&](size_t t) {
+                auto boundary = [&](size_t t) {
+                    if(t == 0) return offset;
+                    if(t == threads) return offset + size;
+                    return std::max(offset, (offset + size * t / threads) & ~size_t(63));
+                };
+                for(size_t x = boundary(t); x < boundary(t + 1); ++x) {
+                    (*this)[x] = batch[x - offset];
+                }
+            });
+        });
+    }
+
+public:
+    inline static Meta meta() {
+        Meta m("sa", "semi_external", "Semi-external suffix sorting in batches");
+        m.option("budget").dynamic(1 << 30); // in bytes, for the batches
+        m.option("period").dynamic(64); // of the difference cover, a power of two
+        m.option("threads").dynamic(0); // 0 for all hardware threads
+        return m;
+    }
+
+    inline static ds::InputRestrictions restrictions() {
+        return ds::InputRestrictions {
+            { 0 },
+            true
+        };
+    }
+
+    /// Restores the array from data constructed earlier.
+    inline SASemiExternal(Env&& env, iv_t&& data)
+        : Algorithm(std::move(env)), ArrayDS(std::move(data)) {
+    }
+
+    template<typename textds_t>
+    inline SASemiExternal(Env&& env, const textds_t& t, CompressMode cm)
+        : Algorithm(std::move(env)) {
+
+        StatPhase::wrap("Construct SA", [&]{
+            const View text(t.text(), t.size());
+            const size_t n = text.size();
+            const size_t budget = this->env().option("budget").as_integer();
+            const size_t period = this->env().option("period").as_integer();
+            const size_t threads = resolve_thread_count(
+                this->env().option("threads").as_integer());
+            StatPhase::log("threads", threads);
+            StatPhase::log("period", period);
+
+            const size_t w = (cm == CompressMode::compressed) ? bits_for(n) : index_width(n);
+            if(n <= UINT32_MAX) {
+                construct<uint32_t>(text, w, budget, period, threads);
+            } else {
+                construct<uint64_t>(text, w, budget, period, threads);
+            }
+
+            StatPhase::log("bit_width", size_t(width()));
+            StatPhase::log("size", bit_size() / 8);
+        });
+
+        if(cm == CompressMode::compressed || cm == CompressMode::delayed) {
+            compress();
+        }
+    }
+
+    void compress() {
+        debug_check_array_is_initialized();
+
+        StatPhase::wrap("Compress SA", [this]{
+            width(bits_for(size()));
+            shrink_to_fit();
+
+            StatPhase::log("bit_width", size_t(width()));
+            StatPhase::log("size", bit_size() / 8);
+        });
+    }
+};
+
+}
@@ -8,179 +8,135 @@ namespace tdc {
 
 /// \brief Implements a select data structure for a \ref BitVector.
 ///
-/// The data structure follows a block / superblock principle, where superblocks
-/// always contain \c s flagged bits and blocks contain \c s' flagged bits
-/// (flagged bits meaning 1 for select1 and 0 for select0).
+/// The bits are kept in the cache lines of a \ref Rank data structure, which
+/// store the amount of 1-bits preceding each line. A directory samples the
+/// line containing every \ref sample_rate -th flagged bit (flagged bits
+/// meaning 1 for select1 and 0 for select0). A query looks up the lines of
+/// the two surrounding samples, binary searches the line counters between
+/// them and selects within the line word by word (see
+/// \ref select1(uint64_t, uint8_t)).
 ///
-/// The size of a block is logarithmic in the bit vector's length, the size of a
-/// superblock is the squared block size.
+/// Where the flagged bits are sparse, two samples may lie far apart. The
+/// positions of the flagged bits between samples that span more than
+/// \ref long_factor times the bits needed to store them are kept
+/// explicitly, like the long blocks of Clark's select. This costs at most
+/// a \ref long_factor -th of the bit vector's size and bounds the binary
+/// search to a constant amount of lines for a given position width, so a
+/// query takes constant time.
 ///
 /// \tparam m_bit the bits to flag (0 or 1)
 template<bool m_bit>
 class Select {
-private:
-    using data_t = BitVector::internal_data_type;
-    static constexpr size_t data_w = 8 * sizeof(data_t);
-
-    static_assert(data_w <= 64,
-        "bit vectors backing must have width of at most 64 bits");
+public:
+    /// The amount of flagged bits between two samples of the directory.
+    static constexpr size_t sample_rate = 256;
 
-    // template variants
-    static constexpr uint8_t basic_rank(data_t v);
-    static constexpr uint8_t basic_rank(data_t v, uint8_t l, uint8_t m);
-    static constexpr uint8_t basic_select(data_t, uint8_t k);
-    static constexpr uint8_t basic_select(data_t, uint8_t l, uint8_t k);
+    /// The ratio between the bits spanned by two samples and the bits
+    /// needed to store the positions between them from which on the
+    /// positions are stored explicitly.
+    static constexpr size_t long_factor = 4;
 
-    const BitVector* m_bv;
+private:
+    static constexpr size_t data_w = Rank::block_size;
 
+    Rank m_rank;
     size_t m_max;
-    size_t m_block_size;
-    size_t m_supblock_size;
 
-    DynamicIntVector m_blocks;
-    DynamicIntVector m_supblocks;
+    // the line containing the (i * sample_rate + 1)-th flagged bit
+    DynamicIntVector m_samples;
 
-public:
-    /// \brief Default constructor.
-    inline Select()
-        : m_bv(nullptr),
-          m_max(0),
-          m_block_size(0),
-          m_supblock_size(0) {
+    // the amount of long blocks of flagged bits, i.e., sample_rate flagged
+    // bits starting at a sample, before each block
+    DynamicIntVector m_long;
+
+    // the positions of the flagged bits of each long block
+    DynamicIntVector m_positions;
+
+    // the amount of flagged bits preceding a line
+    inline size_t flagged_before(size_t line) const {
+        const size_t ones = m_rank.lines()[line * Rank::line_words];
+        return m_bit ? ones : line * Rank::line_bits - ones;
     }
 
-    /// \brief Copy constructor.
-    inline Select(const Select& other)
-        : m_bv(other.m_bv),
-          m_max(other.m_max),
-          m_block_size(other.m_block_size),
-          m_supblock_size(other.m_supblock_size),
-          m_blocks(other.m_blocks),
-          m_supblocks(other.m_supblocks) {
+    inline static uint64_t flagged(uint64_t v) {
+        return m_bit ? v : ~v;
     }
 
-    /// \brief Move constructor.
-    inline Select(Select&& other)
-        : m_bv(other.m_bv),
-          m_max(other.m_max),
-          m_block_size(other.m_block_size),
-          m_supblock_size(other.m_supblock_size),
-          m_blocks(std::move(other.m_blocks)),
-          m_supblocks(std::move(other.m_supblocks)) {
+    // the last line that may contain flagged bits of the i-th block
+    inline size_t last_line(size_t i) const {
+        return (i + 1 < m_samples.size())
+            ? size_t(m_samples[i + 1]) : m_rank.num_lines() - 1;
     }
 
-    /// \brief Copy assignment.
-    inline Select& operator=(const Select& other) {
-        m_bv = other.m_bv;
-        m_max = other.m_max;
-        m_block_size = other.m_block_size;
-        m_supblock_size = other.m_supblock_size;
-        m_blocks = other.m_blocks;
-        m_supblocks = other.m_supblocks;
-        return *this;
+    // stores the positions of the flagged bits of the i-th block
+    inline void store_positions(size_t i, size_t k) {
+        const size_t first = i * sample_rate + 1;
+        const size_t last = std::min(first + sample_rate - 1, m_max);
+
+        for(size_t l = m_samples[i]; l <= last_line(i); ++l) {
+            size_t x = flagged_before(l);
+            const uint64_t* line = m_rank.lines() + l * Rank::line_words;
+            for(size_t w = 1; w < Rank::line_words; ++w) {
+                for(uint64_t v = flagged(line[w]); v; v &= v - 1) {
+                    if(++x < first) continue;
+                    if(x > last) return;
+                    m_positions[k * sample_rate + (x - first)] =
+                        l * Rank::line_bits + (w - 1) * data_w +
+                        __builtin_ctzll(v);
+                }
+            }
+        }
     }
 
-    /// \brief Move assignment.
-    inline Select& operator=(Select&& other) {
-        m_bv = other.m_bv;
-        m_max = other.m_max;
-        m_block_size = other.m_block_size;
-        m_supblock_size = other.m_supblock_size;
-        m_blocks = std::move(other.m_blocks);
-        m_supblocks = std::move(other.m_supblocks);
-        return *this;
+public:
+    /// \brief Default constructor.
+    inline Select() : m_max(0) {
     }
 
     /// \brief Constructs the select data structure for the given bit vector.
     ///
-    /// Note that changes to the bit vector after construction of this data
-    /// structure will cause the select operation to not work correctly
-    /// anymore. In other words, this data structure is static.
+    /// The bits are copied into the data structure, so changes to the bit
+    /// vector after construction are not reflected by the select operation.
+    /// In other words, this data structure is static.
     ///
     /// \param bv the underlying bit vector
-    inline Select(BitVector& bv) : m_bv(&bv) {
+    inline Select(const BitVector& bv) : m_rank(bv) {
         const size_t n = bv.size();
-
-        const size_t log_n = bits_for(n);
-
-        // construct
-        m_supblock_size = log_n * log_n;
-        m_block_size    = log_n;
-
-        m_supblocks = DynamicIntVector(idiv_ceil(n, m_supblock_size), 0, log_n);
-        m_blocks = DynamicIntVector(idiv_ceil(n, m_block_size), 0, log_n);
-
-        m_max = 0;
-        size_t r_sb = 0; // current bit count in superblock
-        size_t r_b = 0;  // current bit count in block
-
-        size_t cur_sb = 0;        // current superblock
-        size_t cur_sb_offset = 0; // starting position of current superblock
-        size_t longest_sb = 0;    // length of longest superblock
-
-        size_t cur_b = 0; // current block
-
-        auto data = bv.data();
-        for(size_t i = 0; i < idiv_ceil(n, data_w); i++) {
-            const auto v = data[i];
-            const uint8_t r = basic_rank(v);
-            m_max += r;
-
-            if(r_b + r >= m_block_size) {
-                // entered new block
-
-                // amount of bits needed to fill current block
-                size_t distance_b = m_block_size - r_b;
-
-                // stores the offset of the last bit in the current block
-                uint8_t offs = 0;
-
-                r_b += r;
-
-                size_t distance_sum = 0;
-                while(r_b >= m_block_size) {
-                    // find exact position of the bit in question
-                    offs = basic_select(v, offs, distance_b);
-                    DCHECK_NE(SELECT_FAIL, offs);
-
-                    const size_t pos = i * data_w + offs;
-
-                    distance_sum += distance_b;
-                    r_sb += distance_b;
-                    if(r_sb >= m_supblock_size) {
-                        // entered new superblock
-                        longest_sb = std::max(longest_sb, pos - cur_sb_offset);
-                        cur_sb_offset = pos;
-
-                        m_supblocks[cur_sb++] = pos;
-
-                        r_sb -= m_supblock_size;
-                    }
-
-                    m_blocks[cur_b++] = pos - cur_sb_offset;
-                    r_b -= m_block_size;
-                    distance_b = m_block_size;
-
-                    ++offs;
-                }
-
-                DCHECK_GE(size_t(r), distance_sum);
-                r_sb += r - distance_sum;
-            } else {
-                r_b  += r;
-                r_sb += r;
+        const size_t num_lines = m_rank.num_lines();
+
+        m_max = (n == 0) ? 0 : (m_bit ? m_rank.rank1(n - 1) : m_rank.rank0(n - 1));
+        m_samples = DynamicIntVector(idiv_ceil(m_max, sample_rate), 0,
+                                     bits_for(num_lines));
+
+        size_t next = 0; // the next sample to assign
+        for(size_t line = 0; line < num_lines; ++line) {
+            const size_t after = (line + 1 < num_lines)
+                ? flagged_before(line + 1) : m_max;
+            while(next < m_samples.size() && next * sample_rate < after) {
+                m_samples[next++] = line;
             }
         }
+        DCHECK_EQ(next, m_samples.size());
+
+        // store the positions of blocks spanning many lines explicitly
+        const size_t pos_w = bits_for(n);
+        const size_t long_lines = idiv_ceil(
+            long_factor * sample_rate * pos_w, Rank::line_bits);
 
-        longest_sb = std::max(longest_sb, n - cur_sb_offset);
-        const size_t w_block = bits_for(longest_sb);
+        size_t num_long = 0;
+        for(size_t i = 0; i < m_samples.size(); ++i) {
+            if(last_line(i) - m_samples[i] >= long_lines) ++num_long;
+        }
 
-        m_blocks.resize(cur_b);
-        m_blocks.width(w_block);
-        m_blocks.shrink_to_fit();
+        m_long = DynamicIntVector(m_samples.size() + 1, 0, bits_for(num_long));
+        m_positions = DynamicIntVector(num_long * sample_rate, 0, pos_w);
 
-        m_supblocks.resize(cur_sb);
-        m_supblocks.shrink_to_fit();
+        size_t k = 0;
+        for(size_t i = 0; i < m_samples.size(); ++i) {
+            m_long[i] = k;
+            if(last_line(i) - m_samples[i] >= long_lines) store_positions(i, k++);
+        }
+        m_long[m_samples.size()] = k;
     }
 
     /// \brief Finds the position of the x-th flagged bit in the bit vector.
@@ -190,55 +146,35 @@ public:
     ///         returned.
     inline size_t select(size_t x) const {
         DCHECK_GT(x, 0) << "order must be at least one";
-        if(x > m_max) return m_bv->size();
-
-        size_t pos = 0;
-
-        //narrow down to block
-        {
-            const size_t i = x / m_supblock_size;
-            const size_t j = x / m_block_size;
-
-            if(i > 0) {
-                pos += m_supblocks[i-1];
-                x -= i * m_supblock_size;
-            }
-            if(x == 0) return pos;
+        if(x > m_max) return m_rank.size();
 
-            // block j is the k-th block within the i-th superblock
-            size_t k = j - i * (m_supblock_size / m_block_size);
-            if(k > 0) {
-                pos += m_blocks[j-1];
-                x   -= k * m_block_size;
-            }
-            if(x == 0) return pos;
-
-            if(i > 0 || k > 0) ++pos; // offset from block boundary
+        // look up long blocks
+        const size_t i = (x - 1) / sample_rate;
+        const size_t k = m_long[i];
+        if(m_long[i + 1] > k) {
+            return m_positions[k * sample_rate + (x - 1) % sample_rate];
         }
 
-        // from this point forward, search directly in the bit vector
-        auto data = m_bv->data();
-
-        size_t i = pos / data_w;
-        size_t offs  = pos % data_w;
-
-        uint8_t s = basic_select(data[i], offs, x);
-        if(s != SELECT_FAIL) {
-            // found in first data segment
-            return pos + s - offs;
-        } else {
-            // linearly search in the next segments
-            size_t passes = 1;
-
-            x -= basic_rank(data[i], offs, data_w-1);
-            do {
-                ++passes;
-                pos = (++i) * data_w;
-                s = basic_select(data[i], x);
-                if(s == SELECT_FAIL) x -= basic_rank(data[i]);
-            } while(s == SELECT_FAIL);
+        // narrow down to the last line with less than x flagged bits before
+        size_t lo = m_samples[i];
+        size_t hi = last_line(i);
+        while(lo < hi) {
+            const size_t mid = lo + (hi - lo + 1) / 2;
+            if(flagged_before(mid) < x) lo = mid;
+            else hi = mid - 1;
+        }
 
-            return pos + s;
+        // scan the words of the line
+        x -= flagged_before(lo);
+        const uint64_t* line = m_rank.lines() + lo * Rank::line_words;
+        for(size_t w = 1;; ++w) {
+            const uint64_t v = flagged(line[w]);
+            const size_t r = tdc::rank1(v);
+            if(x <= r) {
+                return lo * Rank::line_bits + (w - 1) * data_w +
+                    tdc::select1(v, uint8_t(x));
+            }
+            x -= r;
         }
     }
 
@@ -249,51 +185,6 @@ public:
 };
 
 using Select1 = Select<1>;
-
-/// \cond INTERNAL
-template<>
-inline constexpr uint8_t Select1::basic_rank(data_t v) {
-    return tdc::rank1(v);
-}
-
-template<>
-inline constexpr uint8_t Select1::basic_rank(data_t v, uint8_t l, uint8_t m) {
-    return tdc::rank1(v, l, m);
-}
-
-template<>
-inline constexpr uint8_t Select1::basic_select(data_t v, uint8_t k) {
-    return tdc::select1(v, k);
-}
-
-template<>
-inline constexpr uint8_t Select1::basic_select(data_t v, uint8_t l, uint8_t k) {
-    return tdc::select1(v, l, k);
-}
-///\endcond
-
 using Select0 = Select<0>;
 
-/// \cond INTERNAL
-template<>
-inline constexpr uint8_t Select0::basic_rank(data_t v) {
-    return tdc::rank0(v);
-}
-
-template<>
-inline constexpr uint8_t Select0::basic_rank(data_t v, uint8_t l, uint8_t m) {
-    return tdc::rank0(v, l, m);
-}
-
-template<>
-inline constexpr uint8_t Select0::basic_select(data_t v, uint8_t k) {
-    return tdc::select0(v, k);
-}
-
-template<>
-inline constexpr uint8_t Select0::basic_select(data_t v, uint8_t l, uint8_t k) {
-    return tdc::select0(v, l, k);
-}
-///\endcond
-
 }
@@ -21,8 +21,7 @@ public:
 private:
     const sa_t* m_sa;
 
-    BitVector m_has_shortcut;
-    Rank      m_rank;
+    Rank m_rank; // marks the positions that have a shortcut
 
     iv_t m_shortcuts;
 
@@ -50,13 +49,13 @@ public:
         m_sa = &tds.require_sa(cm);
 
         const size_t n = m_sa->size();
-        m_has_shortcut = BitVector(n);
 
         const size_t t = this->env().option("t").as_integer();
 
         // Construct
         StatPhase::wrap("Construct sparse ISA", [&]{
             auto v = BitVector(n);
+            auto has_shortcut = BitVector(n);
             for(size_t i = 0; i < n; i++) {
                 if(!v[i]) {
                     // new cycle
@@ -66,7 +65,7 @@ public:
 
                     while(j != i) {
                         if((k % t) == 0) {
-                            m_has_shortcut[j] = 1;
+                            has_shortcut[j] = 1;
                         }
 
                         v[j] = 1;
@@ -74,11 +73,12 @@ public:
                         ++k;
                     }
 
-                    if(k > t) m_has_shortcut[i] = 1;
+                    if(k > t) has_shortcut[i] = 1;
                 }
             }
 
-            m_rank = Rank(m_has_shortcut);
+            m_rank = Rank(has_shortcut);
+            has_shortcut = BitVector();
             m_shortcuts = DynamicIntVector(m_rank(n-1), 0, bits_for(n));
 
             for(size_t i = 0; i < n; i++) {
@@ -86,7 +86,7 @@ public:
                     v[i] = 0;
                     size_t j = (*m_sa)[i];
                     while(v[j]) {
-                        if(m_has_shortcut[j]) {
+                        if(m_rank.bit(j)) {
                             m_shortcuts[m_rank(j)-1] = i;
                             i = j;
                         }
@@ -94,7 +94,7 @@ public:
                         j = (*m_sa)[j];
                     }
 
-                    if(m_has_shortcut[j]) {
+                    if(m_rank.bit(j)) {
                         m_shortcuts[m_rank(j)-1] = i;
                     }
 
@@ -110,7 +110,7 @@ public:
         bool s = true;
 
         while((*m_sa)[j] != i) {
-            if(s && m_has_shortcut[j]) {
+            if(s && m_rank.bit(j)) {
                 j = m_shortcuts[m_rank(j)-1];
                 s = false;
             } else {
@@ -125,7 +125,7 @@ public:
     }
 
     inline size_t size() const {
-        return m_has_shortcut.size();
+        return m_rank.size();
     }
 
     /// \brief Forces the data structure to relinquish its data storage.
@@ -5,6 +5,9 @@
 #include <tudocomp/ds/IntVector.hpp>
 
 #include <tudocomp/ds/CompressMode.hpp>
+#include <tudocomp/ds/MappedStorage.hpp>
+#include <tudocomp/ds/TextDSCache.hpp>
+#include <tudocomp/ds/TextDSPlan.hpp>
 
 //Defaults
 #include <tudocomp/ds/SADivSufSort.hpp>
@@ -69,20 +72,104 @@ private:
 
     dsflags_t m_ds_requested;
     CompressMode m_cm;
+    size_t m_mem_budget;
+    bool m_plan;
+
+    /// Whether the memory needed to construct the arrays can be estimated.
+    static constexpr bool plannable =
+        ds::SAConstruction<sa_t>::modelled &&
+        std::is_same<phi_t, PhiFromSA>::value &&
+        std::is_same<plcp_t, PLCPFromPhi>::value &&
+        std::is_same<lcp_t, LCPFromPLCP>::value &&
+        std::is_same<isa_t, ISAFromSA>::value;
+
+    TextDSCache m_cache;
+
+    dsflags_t m_external;
+    std::shared_ptr<MappedStorage> m_storage;
+
+    dsflags_t m_huge_pages;
+    std::shared_ptr<MappedStorage> m_huge_storage;
+
+    inline static dsflags_t parse_ds_list(const std::string& list, const std::string& option) {
+        dsflags_t flags = 0;
+        std::istringstream in(list);
+        for(std::string name; std::getline(in, name, ',');) {
+            if(name == "sa")        flags |= SA;
+            else if(name == "phi")  flags |= PHI;
+            else if(name == "plcp") flags |= PLCP;
+            else if(name == "lcp")  flags |= LCP;
+            else if(name == "isa")  flags |= ISA;
+            else if(name == "all")  flags |= SA | PHI | PLCP | LCP | ISA;
+            else if(name != "none") {
+                throw std::invalid_argument(
+                    "unknown data structure in " + option + " option: " + name);
+            }
+        }
+        return flags;
+    }
 
     template<typename ds_t>
-    inline std::unique_ptr<ds_t> construct_ds(const std::string& option, CompressMode cm) {
+    inline std::unique_ptr<ds_t> construct_ds(
+        const std::string& option, CompressMode cm, std::false_type) {
+
         return std::make_unique<ds_t>(
                     env().env_for_option(option),
                     *this,
                     cm_select(cm, m_cm));
     }
 
+    // array data structures can be restored from the cache
+    template<typename ds_t>
+    inline std::unique_ptr<ds_t> construct_ds(
+        const std::string& option, CompressMode cm, std::true_type) {
+
+        if(!m_cache.enabled()) {
+            return construct_ds<ds_t>(option, cm, std::false_type());
+        }
+
+        cm = cm_select(cm, m_cm);
+        std::ostringstream key;
+        key << option << ", " << int(cm) << ", "
+            << env().option(option);
+
+        ArrayDS::iv_t data;
+        const bool hit = StatPhase::wrap(("Load " + option + " from Cache").c_str(), [&]{
+            const bool hit = m_cache.load(key.str(), data);
+            StatPhase::log("hit", hit);
+            return hit;
+        });
+        if(hit) {
+            return std::make_unique<ds_t>(
+                env().env_for_option(option), std::move(data));
+        }
+
+        auto p = construct_ds<ds_t>(option, cm, std::false_type());
+        StatPhase::wrap(("Store " + option + " in Cache").c_str(), [&]{
+            m_cache.store(key.str(), *p);
+            StatPhase::log("size", p->bit_size() / 8);
+        });
+        return p;
+    }
+
+    // arrays selected by the external option are allocated in files,
+    // those selected by the huge_pages option in huge pages
+    template<typename ds_t>
+    inline std::unique_ptr<ds_t> construct_ds(
+        dsflags_t flag, const std::string& option, CompressMode cm) {
+
+        MappedStorage::Scope scope(
+            (m_external & flag)   ? m_storage :
+            (m_huge_pages & flag) ? m_huge_storage : nullptr);
+        return construct_ds<ds_t>(option, cm,
+            std::is_constructible<ds_t, Env&&, ArrayDS::iv_t&&>());
+    }
+
     template<typename ds_t>
     inline const ds_t& require_ds(
-        std::unique_ptr<ds_t>& p, const std::string& option, CompressMode cm) {
+        std::unique_ptr<ds_t>& p, dsflags_t flag, const std::string& option, CompressMode cm) {
 
-        if(!p) p = construct_ds<ds_t>(option, cm_select(cm, m_cm));
+        if(!p) p = construct_ds<ds_t>(flag, option, cm_select(cm, m_cm));
         return *p;
     }
 
@@ -101,7 +188,7 @@ private:
     inline typename ds_t::data_type inplace_ds(
         std::unique_ptr<ds_t>& p, dsflags_t flag, const std::string& option, CompressMode cm) {
 
-        if(!p) p = construct_ds<ds_t>(option, cm_select(cm, m_cm));
+        if(!p) p = construct_ds<ds_t>(flag, option, cm_select(cm, m_cm));
         if(m_ds_requested & flag) {
             // data structure is requested, return a copy of the data
             return p->copy();
@@ -121,13 +208,18 @@ public:
         m.option("plcp").templated<plcp_t, PLCPFromPhi>("plcp");
         m.option("lcp").templated<lcp_t, LCPFromPLCP>("lcp");
         m.option("isa").templated<isa_t, ISAFromSA>("isa");
-        m.option("compress").dynamic("delayed");
+        m.option("compress").dynamic("auto"); // "delayed", unless planned by mem_budget
+        m.option("cache").dynamic("none"); // directory to cache arrays in
+        m.option("mem_budget").dynamic(0); // in bytes, 0 for none; only with compress = "auto"
+        m.option("external").dynamic("none"); // arrays to keep in files, e.g., "sa,lcp" or "all"
+        m.option("external_dir").dynamic("/tmp"); // directory for the files of external arrays
+        m.option("huge_pages").dynamic("none"); // arrays to back by huge pages, e.g., "sa,isa" or "all"
         return m;
     }
 
     inline TextDS(Env&& env, const View& text)
         : Algorithm(std::move(env)),
-          m_text(text), m_ds_requested(0) {
+          m_text(text), m_ds_requested(0), m_external(0), m_huge_pages(0) {
 
         if(!m_text.ends_with(uint8_t(0))){
              throw std::logic_error(
@@ -138,13 +230,40 @@ public:
         }
 
         auto& cm_str = this->env().option("compress").as_string();
-        if(cm_str == "delayed") {
+        if(cm_str == "delayed" || cm_str == "auto") {
             m_cm = CompressMode::delayed;
         } else if(cm_str == "compressed") {
             m_cm = CompressMode::compressed;
         } else {
             m_cm = CompressMode::plain;
         }
+
+        // an explicit compress mode is never overridden
+        m_mem_budget = this->env().option("mem_budget").as_integer();
+        m_plan = (cm_str == "auto") && (m_mem_budget > 0);
+
+        auto& cache_str = this->env().option("cache").as_string();
+        if(cache_str != "none") {
+            m_cache = TextDSCache(cache_str, m_text);
+        }
+
+        m_external = parse_ds_list(
+            this->env().option("external").as_string(), "external");
+        if(m_external) {
+            m_storage = MappedStorage::external(
+                this->env().option("external_dir").as_string());
+        }
+
+        // arrays not selected by the option may still get huge pages from
+        // the TDC_HUGE_PAGES environment switch
+        m_huge_pages = parse_ds_list(
+            this->env().option("huge_pages").as_string(), "huge_pages");
+        if(m_huge_pages) {
+            m_huge_storage = MappedStorage::huge_pages();
+        } else {
+            auto storage = MappedStorage::current();
+            if(storage && storage->is_huge_pages()) m_huge_storage = storage;
+        }
     }
 
     inline TextDS(Env&& env, const View& text, dsflags_t flags, CompressMode cm = CompressMode::select)
@@ -156,19 +275,19 @@ public:
     // require methods
 
     inline const sa_t& require_sa(CompressMode cm = CompressMode::select) {
-        return require_ds(m_sa, "sa", cm);
+        return require_ds(m_sa, SA, "sa", cm);
     }
     inline const phi_t& require_phi(CompressMode cm = CompressMode::select) {
-        return require_ds(m_phi, "phi", cm);
+        return require_ds(m_phi, PHI, "phi", cm);
     }
     inline const plcp_t& require_plcp(CompressMode cm = CompressMode::select) {
-        return require_ds(m_plcp, "plcp", cm);
+        return require_ds(m_plcp, PLCP, "plcp", cm);
     }
     inline const lcp_t& require_lcp(CompressMode cm = CompressMode::select) {
-        return require_ds(m_lcp, "lcp", cm);
+        return require_ds(m_lcp, LCP, "lcp", cm);
     }
     inline const isa_t& require_isa(CompressMode cm = CompressMode::select) {
-        return require_ds(m_isa, "isa", cm);
+        return require_ds(m_isa, ISA, "isa", cm);
     }
 
     // inplace methods
@@ -234,6 +353,28 @@ private:
         discard_ds(m_isa, ISA);
     }
 
+    inline CompressMode plan(dsflags_t flags, std::true_type) {
+        return StatPhase::wrap("Plan Construction", [&]{
+            const CompressMode cm = ds::plan_compress_mode<sa_t>(
+                size(), flags, m_mem_budget);
+
+            StatPhase::log("mem_budget", m_mem_budget);
+            StatPhase::log("planned", size_t(1));
+            StatPhase::log("compress_mode", size_t(cm));
+            StatPhase::log("estimated_peak", ds::estimate_peak<sa_t>(size(), flags, cm));
+            return cm;
+        });
+    }
+
+    // the arrays are not modelled, so the compress option is kept
+    inline CompressMode plan(dsflags_t, std::false_type) {
+        return StatPhase::wrap("Plan Construction", [&]{
+            StatPhase::log("mem_budget", m_mem_budget);
+            StatPhase::log("planned", size_t(0));
+            return CompressMode::select;
+        });
+    }
+
     inline void discard_unneeded() {
         // discard unrequested structures
         if(!(m_ds_requested & SA)) discard_sa();
@@ -244,9 +385,22 @@ private:
     }
 
 public:
+    /// \brief Constructs the requested data structures and discards all
+    ///        others.
+    ///
+    /// If no compress mode is given, the \c compress option is \c auto and
+    /// the \c mem_budget option is set, the fastest compress mode is
+    /// selected whose estimated memory peak fits into the budget. This
+    /// requires the default array data structures and a suffix array type
+    /// modelled by \ref ds::SAConstruction; otherwise, the arrays are
+    /// constructed as with \c delayed.
     inline void require(dsflags_t flags, CompressMode cm = CompressMode::select) {
         m_ds_requested = flags;
 
+        if(cm == CompressMode::select && m_plan) {
+            cm = plan(flags, std::integral_constant<bool, plannable>());
+        }
+
         // TODO: we need something like a dependency graph here
 
         // construct requested structures
@@ -289,6 +443,12 @@ public:
             if(m_phi) m_phi->compress();
             if(m_plcp) m_plcp->compress();
         }
+
+        // report how much of the mapped memory the kernel backs by huge pages
+        if(m_huge_storage) {
+            StatPhase::log("huge_pages_mapped", m_huge_storage->size());
+            StatPhase::log("huge_pages_obtained", m_huge_storage->huge_page_bytes());
+        }
     }
 
     /// Accesses the input text at position i.
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+#include <tudocomp/util/View.hpp>
+#include <tudocomp/ds/IntVector.hpp>
+
+namespace tdc {
+
+/// \brief Stores constructed text data structures in files of a directory,
+///        so that they can be reused by later runs on the same input.
+///
+/// A data structure is stored in a file named after a hash of the input
+/// text and a hash of a key, which should identify the data structure and
+/// its configuration. The file also records the size of the input, which
+/// is checked when loading. Files are written under a temporary name and
+/// then renamed, so concurrent runs sharing a directory never read a
+/// partially written file.
+class TextDSCache {
+private:
+    /// Identifies cache files and their format version.
+    static constexpr uint64_t MAGIC = 0x7464636473000001ULL;
+
+    std::string m_dir;
+    View m_text;
+
+    mutable bool m_hashed = false;
+    mutable uint64_t m_text_hash = 0;
+
+    /// Hashes a byte sequence, eight bytes at a time.
+    inline static uint64_t hash(const uint8_t* data, size_t size) {
+        auto mix = [](uint64_t x) {
+            x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+            x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+            return x ^ (x >> 31);
+        };
+
+        uint64_t h = mix(size);
+        size_t i = 0;
+        for(; i + 8 <= size; i += 8) {
+            uint64_t w;
+            std::memcpy(&w, data + i, sizeof(w));
+            h = (h ^ mix(w)) * UINT64_C(0x9e3779b97f4a7c15);
+        }
+        uint64_t w = 0;
+        std::memcpy(&w, data + i, size - i);
+        return mix(h ^ mix(w));
+    }
+
+    inline std::string path(const std::string& key) const {
+        if(!m_hashed) {
+            m_text_hash = hash(m_text.data(), m_text.size());
+            m_hashed = true;
+        }
+
+        std::ostringstream ss;
+        ss << m_dir << '/' << std::hex << std::setfill('0')
+           << std::setw(16) << m_text_hash << '-'
+           << std::setw(16) << hash((const uint8_t*) key.data(), key.size())
+           << ".ds";
+        return ss.str();
+    }
+
+public:
+    /// Constructs a disabled cache.
+    inline TextDSCache() {}
+
+    /// \brief Constructs a cache for the given text.
+    ///
+    /// \param dir the directory to store the files in, which must exist.
+    /// \param text the input text.
+    inline TextDSCache(const std::string& dir, View text)
+        : m_dir(dir), m_text(text) {
+    }
+
+    /// Returns whether the cache is enabled.
+    inline bool enabled() const {
+        return !m_dir.empty();
+    }
+
+    /// \brief Loads the array stored for a key.
+    ///
+    /// \param key the key identifying the array.
+    /// \param iv the vector to load the array into.
+    /// \return \c true if a valid file was found, \c false otherwise.
+    inline bool load(const std::string& key, DynamicIntVector& iv) const {
+        std::ifstream in(path(key), std::ios::binary);
+        if(!in) return false;
+
+        uint64_t header[3];
+        in.read((char*) header, sizeof(header));
+        if(!in || header[0] != MAGIC || header[1] != m_text.size() ||
+           header[2] == 0 || header[2] > 64) {
+            return false;
+        }
+
+        DynamicIntVector loaded(header[1], 0, header[2]);
+        const size_t words = idiv_ceil(loaded.bit_size(), 64);
+        in.read((char*) loaded.data(), words * sizeof(uint64_t));
+        if(!in) return false;
+
+        iv = std::move(loaded);
+        return true;
+    }
+
+    /// \brief Stores an array for a key.
+    ///
+    /// Failing to write the file is not an error, it merely leaves the
+    /// array uncached.
+    ///
+    /// \param key the key identifying the array.
+    /// \param iv the array to store.
+    inline void store(const std::string& key, const DynamicIntVector& iv) const {
+        const std::string file = path(key);
+        const std::string tmp = file + "." + std::to_string(getpid()) + ".tmp";
+
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            const uint64_t header[3] = { MAGIC, iv.size(), iv.width() };
+            out.write((const char*) header, sizeof(header));
+            const size_t words = idiv_ceil(iv.bit_size(), 64);
+            out.write((const char*) iv.data(), words * sizeof(uint64_t));
+            if(!out) {
+                out.close();
+                std::remove(tmp.c_str());
+                return;
+            }
+        }
+
+        if(std::rename(tmp.c_str(), file.c_str()) != 0) {
+            std::remove(tmp.c_str());
+        }
+    }
+};
+
+} //ns
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+
+#include <tudocomp/def.hpp>
+#include <tudocomp/util.hpp>
+#include <tudocomp/ds/TextDSFlags.hpp>
+#include <tudocomp/ds/CompressMode.hpp>
+
+namespace tdc {
+namespace ds {
+
+/// \brief Describes the memory needed to construct a suffix array type, for
+///        planning the compress mode of \c TextDS.
+///
+/// Suffix array types whose construction can be estimated specialize this
+/// template with \c modelled set to \c true and the static functions
+///
+/// - <tt>size_t width(size_t n, CompressMode cm)</tt>, the bits per entry
+///   of the array right after construction,
+/// - <tt>size_t compressed_width(size_t n, CompressMode cm)</tt>, the bits
+///   per entry allocated after the array has been compressed, and
+/// - <tt>size_t peak(size_t n, CompressMode cm)</tt>, the bytes held during
+///   construction, including the array itself,
+///
+/// where \c n is the length of the text. No compress mode is planned for
+/// the other types.
+template<typename sa_t>
+struct SAConstruction {
+    static constexpr bool modelled = false;
+};
+
+/// \cond INTERNAL
+namespace plan {
+
+/// The bytes allocated for \c n entries of \c width bits.
+inline size_t bytes(size_t n, size_t width) {
+    return idiv_ceil(n * width, 64) * 8;
+}
+
+/// Replays the construction steps of \c TextDS::require and keeps track of
+/// the memory held by the arrays.
+///
+/// The suffix array is modelled by \ref SAConstruction. All other arrays
+/// follow the default data structures: Phi is built from the suffix
+/// array, the PLCP array is computed in place of Phi and the LCP and
+/// inverse suffix arrays are allocated next to the suffix array. Arrays
+/// that depend on the longest common prefix are assumed to need as many
+/// bits per entry as the other arrays do. Temporary buffers of the
+/// construction algorithms are included.
+template<typename sa_t>
+class Simulation {
+    using sa_model = SAConstruction<sa_t>;
+
+    const size_t m_n;
+    const dsflags_t m_requested;
+
+    std::map<dsflags_t, size_t> m_alive;
+    size_t m_current = 0;
+    size_t m_peak = 0;
+
+    inline size_t bytes(size_t width) const {
+        return plan::bytes(m_n, width);
+    }
+
+    inline size_t fast_width() const {
+        return index_width(m_n);
+    }
+
+    inline size_t compressed_width() const {
+        return bits_for(m_n);
+    }
+
+    // the assignment buffer of parallel_scatter, used for Phi and ISA on
+    // multiple threads
+    inline size_t scatter_buffer() const {
+        return (m_n > (size_t(1) << 16)) ? idiv_ceil(m_n, 4) * 2 * sizeof(len_t) : 0;
+    }
+
+    inline void temporary(size_t size) {
+        m_peak = std::max(m_peak, m_current + size);
+    }
+
+    inline void alloc(dsflags_t ds, size_t size) {
+        m_alive[ds] = size;
+        m_current += size;
+        m_peak = std::max(m_peak, m_current);
+    }
+
+    inline void discard(dsflags_t ds) {
+        m_current -= m_alive[ds];
+        m_alive.erase(ds);
+    }
+
+    // shrinking an array reallocates it
+    inline void shrink(dsflags_t ds, size_t size) {
+        const size_t old = m_alive[ds];
+        m_current += size;
+        m_peak = std::max(m_peak, m_current);
+        m_current -= old;
+        m_alive[ds] = size;
+    }
+
+    inline bool alive(dsflags_t ds) const {
+        return m_alive.count(ds) > 0;
+    }
+
+    inline void construct(dsflags_t ds, CompressMode cm) {
+        if(alive(ds)) return;
+
+        const bool compressed = (cm == CompressMode::compressed);
+        const bool eager = compressed || (cm == CompressMode::delayed);
+        const size_t width = compressed ? compressed_width() : fast_width();
+
+        if(ds == SA) {
+            temporary(sa_model::peak(m_n, cm));
+            alloc(SA, bytes(sa_model::width(m_n, cm)));
+            if(eager) shrink(SA, bytes(sa_model::compressed_width(m_n, cm)));
+        } else if(ds == PHI) {
+            construct(SA, cm);
+            alloc(PHI, bytes(width));
+            temporary(scatter_buffer());
+            if(cm == CompressMode::delayed) shrink(PHI, bytes(compressed_width()));
+        } else if(ds == PLCP) {
+            construct(PHI, cm);
+            if(m_requested & PHI) {
+                alloc(PLCP, m_alive[PHI]);
+            } else {
+                alloc(PLCP, 0);
+                std::swap(m_alive[PLCP], m_alive[PHI]);
+                discard(PHI);
+            }
+            if(eager) shrink(PLCP, bytes(compressed_width()));
+        } else if(ds == LCP) {
+            construct(SA, cm);
+            construct(PLCP, cm);
+            alloc(LCP, bytes(width));
+            if(cm == CompressMode::delayed) shrink(LCP, bytes(compressed_width()));
+        } else if(ds == ISA) {
+            construct(SA, cm);
+            alloc(ISA, bytes(width));
+            temporary(scatter_buffer());
+            if(cm == CompressMode::delayed) shrink(ISA, bytes(compressed_width()));
+        }
+    }
+
+    inline void compress(dsflags_t ds, CompressMode cm) {
+        if(!alive(ds)) return;
+        shrink(ds, bytes((ds == SA) ?
+            sa_model::compressed_width(m_n, cm) : compressed_width()));
+    }
+
+    inline void discard_unneeded() {
+        for(dsflags_t ds : { SA, PHI, PLCP, LCP, ISA }) {
+            if(alive(ds) && !(m_requested & ds)) discard(ds);
+        }
+    }
+
+public:
+    inline Simulation(size_t n, dsflags_t flags, CompressMode cm)
+        : m_n(n), m_requested(flags) {
+
+        const bool coherent = (cm == CompressMode::coherent_delayed);
+
+        if(flags & SA)  { construct(SA, cm); discard_unneeded(); }
+        if(flags & PHI) { construct(PHI, cm); discard_unneeded(); }
+        if(flags & PLCP) {
+            construct(PLCP, cm);
+            discard_unneeded();
+            if(coherent && !(flags & LCP)) compress(PLCP, cm);
+        }
+        if(flags & LCP) {
+            construct(LCP, cm);
+            discard_unneeded();
+            if(coherent) compress(LCP, cm);
+        }
+        if(flags & ISA) {
+            construct(ISA, cm);
+            discard_unneeded();
+            if(coherent) compress(ISA, cm);
+        }
+        if(coherent) {
+            compress(SA, cm);
+            compress(PHI, cm);
+            compress(PLCP, cm);
+        }
+    }
+
+    /// The peak amount of bytes held by the arrays.
+    inline size_t peak() const {
+        return m_peak;
+    }
+};
+
+}
+/// \endcond
+
+/// \brief Estimates the peak amount of memory in bytes used by the arrays
+///        during \c TextDS::require.
+///
+/// The estimate excludes the text itself and assumes the default array
+/// data structures for all arrays but the suffix array.
+///
+/// \tparam sa_t the suffix array type, modelled by \ref SAConstruction.
+/// \param n the length of the text, including the sentinel.
+/// \param flags the requested data structures.
+/// \param cm the compress mode passed to the constructors, i.e.,
+///           \c coherent_delayed for the \c delayed option of \c TextDS.
+template<typename sa_t>
+inline size_t estimate_peak(size_t n, dsflags_t flags, CompressMode cm) {
+    static_assert(SAConstruction<sa_t>::modelled,
+        "the construction of the suffix array type is not modelled");
+    return plan::Simulation<sa_t>(n, flags, cm).peak();
+}
+
+/// \brief Selects the fastest compress mode for \c TextDS::require whose
+///        estimated memory peak does not exceed a budget.
+///
+/// The candidates are, in order of decreasing speed: no compression,
+/// compression after all arrays have been constructed, compression of each
+/// array right after its construction, and construction in compressed
+/// space. If none fits into the budget, the latter is selected.
+///
+/// \tparam sa_t the suffix array type, modelled by \ref SAConstruction.
+/// \param n the length of the text, including the sentinel.
+/// \param flags the requested data structures.
+/// \param budget the memory budget in bytes.
+template<typename sa_t>
+inline CompressMode plan_compress_mode(size_t n, dsflags_t flags, size_t budget) {
+    for(auto cm : { CompressMode::plain,
+                    CompressMode::coherent_delayed,
+                    CompressMode::delayed }) {
+        if(estimate_peak<sa_t>(n, flags, cm) <= budget) return cm;
+    }
+    return CompressMode::compressed;
+}
+
+}} //ns
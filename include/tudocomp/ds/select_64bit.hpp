@@ -3,10 +3,15 @@
 #include <cstdint>
 #include <tudocomp/util.hpp>
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 namespace tdc {
 
-// thiss linear shifting approach is indeed the fastest, compared with
-// a binary search approach and one using __builtin_ffs / __builtin_ctz
+// for generic integer types, the linear shifting approach is indeed the
+// fastest, compared with a binary search approach and one using
+// __builtin_ffs / __builtin_ctz; 64-bit words use the overloads below
 
 /// \brief Returned by \ref select0 and \ref select1 in case the searched
 ///        bit does not exist in the given input value.
@@ -36,6 +41,53 @@ inline constexpr uint8_t select1(uint_t v, uint8_t k) {
     return SELECT_FAIL; //TODO: throw error?
 }
 
+/// \brief Finds the position of the k-th 1-bit in the binary representation
+///        of the given 64-bit value.
+///
+/// With BMI2, the k-th lowest bit of an all-ones mask is deposited at the
+/// position of the k-th 1-bit (\c pdep) and located by counting trailing
+/// zeros. Otherwise, the byte containing the bit is found via bytewise
+/// prefix popcounts, and the bit is searched within that byte only.
+///
+/// \param v the input value
+/// \param k the searched 1-bit
+/// \return the position of the k-th 1-bit (LSBF and zero-based),
+///         or \ref SELECT_FAIL if no such bit exists
+inline uint8_t select1(uint64_t v, uint8_t k) {
+    DCHECK(k > 0) << "order must be at least one";
+    if(k > 64) return SELECT_FAIL;
+#ifdef __BMI2__
+    const uint64_t bit = _pdep_u64(uint64_t(1) << (k - 1), v);
+    return bit ? uint8_t(__builtin_ctzll(bit)) : SELECT_FAIL;
+#else
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highs = 0x8080808080808080ULL;
+
+    // byte i holds the amount of 1-bits in the bytes 0 to i
+    uint64_t s = v - ((v >> 1) & 0x5555555555555555ULL);
+    s = (s & 0x3333333333333333ULL) + ((s >> 2) & 0x3333333333333333ULL);
+    s = ((s + (s >> 4)) & 0x0F0F0F0F0F0F0F0FULL) * ones;
+
+    // the bytes with less than k 1-bits up to them precede the searched one,
+    // the bytewise subtraction cannot borrow as all counts are below 128
+    const uint8_t byte = __builtin_popcountll(~((s | highs) - k * ones) & highs);
+    if(byte == 8) return SELECT_FAIL;
+    if(byte > 0) k -= uint8_t(s >> (8 * byte - 8));
+
+    uint8_t b = uint8_t(v >> (8 * byte));
+    for(--k; k > 0; --k) b &= b - 1;
+    return 8 * byte + __builtin_ctz(b);
+#endif
+}
+
+/// \brief Finds the position of the k-th 0-bit in the binary representation
+///        of the given 64-bit value.
+///
+/// \see select1(uint64_t, uint8_t)
+inline uint8_t select0(uint64_t v, uint8_t k) {
+    return select1(~v, k);
+}
+
 /// \brief Finds the position of the k-th 1-bit in the binary representation
 ///        of the given value.
 ///
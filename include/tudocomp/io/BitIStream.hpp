@@ -2,6 +2,7 @@
 
 #include <climits>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <tudocomp/util.hpp>
 
@@ -11,55 +12,113 @@ namespace io {
 /// \brief Wrapper for input streams that provides bitwise reading
 /// functionality.
 ///
-/// The current byte in the underlying input stream is buffered and processed
-/// bitwise using another cursor.
+/// The input is read in blocks. The next bits are held in a 64-bit
+/// accumulator in MSB first order, which is refilled from the block a word
+/// at a time.
+///
+/// The end of the bits is determined by the format written by
+/// \ref BitOStream. In order to recognize it, the last two bytes of the
+/// input are only moved into the accumulator once the end of the input has
+/// been reached.
 class BitIStream {
-    InputStream m_stream;
-
-    uint8_t m_current = 0;
-    uint8_t m_next = 0;
+    /// The size of the block buffer in bytes.
+    static constexpr size_t BLOCK_SIZE = 4096;
 
-    bool m_is_final = false;
-    uint8_t m_final_bits = 0;
+    InputStream m_stream;
 
-    uint8_t m_cursor = 0;
+    // next bits, left-aligned; bits beyond m_acc_bits are either zero or the
+    // bits that follow
+    uint64_t m_acc = 0;
+    size_t m_acc_bits = 0;
 
-    inline void read_next() {
-        const uint8_t MSB = 7;
+    uint8_t m_block[BLOCK_SIZE];
+    size_t m_pos = 0;
+    size_t m_end = 0;
 
-        m_current = m_next;
-        m_cursor = MSB;
+    size_t m_total_bytes = 0;
+    bool m_is_final = false;
+    uint8_t m_final_bits = 8; // valid bits of the last byte once final
 
-        char c;
-        if(m_stream.get(c)) {
-            m_next = c;
+    /// Reads the next block from the input, keeping unconsumed bytes.
+    ///
+    /// Once the input is exhausted, the terminator is removed from the
+    /// block and the unused bits of the last byte are cleared.
+    inline void read_block() {
+        const size_t rest = m_end - m_pos;
+        std::memmove(m_block, m_block + m_pos, rest);
+        m_pos = 0;
+        m_end = rest;
+
+        m_stream.read((char*) m_block + m_end, BLOCK_SIZE - m_end);
+        const size_t got = m_stream.gcount();
+        m_end += got;
+        m_total_bytes += got;
+
+        if(m_end < BLOCK_SIZE) {
+            m_is_final = true;
+            if(m_end == 0) return; // empty input
 
-            if(m_stream.get(c)) {
-                /*DLOG(INFO) << "read_next: ...";*/
+            // the three lowest bits of the last byte tell how many bits the
+            // last byte containing data holds; if there are more than five,
+            // that is the byte before
+            const uint8_t set = m_block[m_end - 1] & 0x7;
+            if(set >= 6 && m_total_bytes > 1) --m_end;
 
-                // stream still going
-                m_stream.unget();
+            if(set == 0) {
+                --m_end;
+                m_final_bits = 8;
             } else {
-                // stream over after next, do some checks
-                m_final_bits = c;
-                m_final_bits &= 0x7;
-                if(m_final_bits >= 6) {
-                    // special case - already final
-                    m_is_final = true;
-                    m_next = 0;
-                    /*DLOG(INFO) << "read_next: EOF*" <<
-                        ", m_final_bits := " << size_t(m_final_bits);*/
+                m_final_bits = set;
+                m_block[m_end - 1] &= uint8_t(0xFF << (8 - set));
+            }
+        }
+    }
+
+    /// Loads as many bytes as possible into the accumulator.
+    inline void refill() {
+        while(m_acc_bits <= 56) {
+            // bytes that may be loaded with certainty
+            const size_t avail = m_is_final ? (m_end - m_pos)
+                : ((m_end - m_pos > 2) ? m_end - m_pos - 2 : 0);
+
+            if(avail >= 9) {
+                // load a word, of which the whole bytes are taken
+                uint64_t word = 0;
+                for(size_t i = 0; i < 8; ++i) {
+                    word = (word << 8) | m_block[m_pos + i];
                 }
+                m_acc |= word >> m_acc_bits;
+
+                const size_t bytes = (64 - m_acc_bits) >> 3;
+                m_pos += bytes;
+                m_acc_bits += 8 * bytes;
+            } else if(avail > 0) {
+                const uint8_t byte = m_block[m_pos++];
+                m_acc |= uint64_t(byte) << (56 - m_acc_bits);
+                m_acc_bits += (m_is_final && m_pos == m_end) ? m_final_bits : 8;
+            } else if(!m_is_final) {
+                read_block();
+            } else {
+                return;
             }
-        } else {
-            m_is_final = true;
-            m_final_bits = m_current & 0x7;
+        }
+    }
+
+    /// Discards the next \c n bits, at most as many as available.
+    inline void drop(size_t n) {
+        m_acc = (n >= 64) ? 0 : (m_acc << n);
+        m_acc_bits -= n;
+        if(m_acc_bits == 0) refill();
+    }
 
-            m_next = 0;
+    /// Reads up to 56 bits, which are zero beyond the end of the input.
+    inline uint64_t read_bits(size_t n) {
+        if(n == 0) return 0;
+        if(m_acc_bits < n) refill();
 
-            /*DLOG(INFO) << "read_next: EOF" <<
-                ", m_final_bits := " << size_t(m_final_bits);*/
-        }
+        const uint64_t value = m_acc >> (64 - n);
+        drop(std::min(n, m_acc_bits));
+        return value;
     }
 
 public:
@@ -67,17 +126,7 @@ public:
     ///
     /// \param input The underlying input stream.
     inline BitIStream(InputStream&& input) : m_stream(std::move(input)) {
-        char c;
-        if(m_stream.get(c)) {
-            m_is_final = false;
-            m_next = c;
-
-            read_next();
-        } else {
-            //empty stream
-            m_is_final = true;
-            m_final_bits = 0;
-        }
+        refill();
     }
 
     /// \brief Constructs a bitwise input stream.
@@ -89,19 +138,9 @@ public:
     /// \brief Reads the next single bit from the input.
     /// \return 1 if the next bit is set, 0 otherwise.
     inline uint8_t read_bit() {
-        /*DLOG(INFO) <<"read_bit: " <<
-                "m_is_final = " << m_is_final <<
-                ", m_final_bits = " << size_t(m_final_bits) <<
-                ", m_cursor = " << size_t(m_cursor);*/
-
         if(!eof()) {
-            uint8_t bit = (m_current >> m_cursor) & 1;
-            if(m_cursor) {
-                --m_cursor;
-            } else {
-                read_next();
-            }
-
+            const uint8_t bit = m_acc >> 63;
+            drop(1);
             return bit;
         } else {
             return 0; //EOF
@@ -110,6 +149,9 @@ public:
 
     /// \brief Reads the integer value of the next \c amount bits in MSB first
     ///        order.
+    ///
+    /// Bits beyond the end of the input are read as zero.
+    ///
     /// \tparam The integer type to read.
     /// \param amount The bit width of the integer to read. By default, this
     ///               equals the bit width of type \c T.
@@ -117,18 +159,70 @@ public:
     ///         order.
     template<class T>
     inline T read_int(size_t amount = sizeof(T) * CHAR_BIT) {
-        T value = 0;
-        for(size_t i = 0; i < amount; i++) {
-            value <<= 1;
-            value |= read_bit();
+        DCHECK_LE(amount, 64U);
+        if(amount <= 56) {
+            return T(read_bits(amount));
+        } else {
+            const uint64_t hi = read_bits(amount - 32);
+            return T((hi << 32) | read_bits(32));
         }
-        return value;
     }
 
+    /// \brief Reads a sequence of bytes written by
+    ///        \ref BitOStream::write_bytes.
+    ///
+    /// \param data The array to store the bytes in.
+    /// \param size The amount of bytes to read.
+    inline void read_bytes(uint8_t* data, size_t size) {
+        for(; size >= 8; data += 8, size -= 8) {
+            const uint64_t word = read_int<uint64_t>(64);
+            for(size_t j = 0; j < 8; ++j) data[j] = uint8_t(word >> (56 - 8 * j));
+        }
+        for(; size > 0; ++data, --size) *data = uint8_t(read_bits(8));
+    }
+
+    /// \brief Returns the next \c amount bits in MSB first order without
+    ///        reading them.
+    ///
+    /// Bits beyond the end of the input are returned as zero. Together with
+    /// \ref consume, this allows decoding prefix codes by table lookup.
+    ///
+    /// \param amount The amount of bits, at most 56.
+    /// \return The integer value of the next \c amount bits.
+    inline uint64_t peek(size_t amount) {
+        DCHECK_LE(amount, 56U);
+        if(amount == 0) return 0;
+        if(m_acc_bits < amount) refill();
+        return m_acc >> (64 - amount);
+    }
+
+    /// \brief Skips the next \c amount bits.
+    ///
+    /// \param amount The amount of bits, at most 56.
+    inline void consume(size_t amount) {
+        DCHECK_LE(amount, 56U);
+        if(m_acc_bits < amount) refill();
+        drop(std::min(amount, m_acc_bits));
+    }
+
+    /// Reads the amount of zero bits preceding the next one bit, and skips
+    /// all of them.
     template<typename value_t>
     inline value_t read_unary() {
         value_t v = 0;
-        while(!read_bit()) ++v;
+        while(!eof()) {
+            // bits beyond m_acc_bits are valid as well, if set
+            if(m_acc != 0) {
+                const size_t zeros = __builtin_clzll(m_acc);
+                if(zeros < m_acc_bits) {
+                    drop(zeros + 1);
+                    return v + value_t(zeros);
+                }
+            }
+
+            v += value_t(m_acc_bits);
+            drop(m_acc_bits);
+        }
         return v;
     }
 
@@ -187,9 +281,9 @@ public:
         return T(value);
     }
 
-    /// TODO document
+    /// \brief Tells whether all bits have been read.
     inline bool eof() const {
-        return m_is_final && m_cursor <= (7 - m_final_bits);
+        return m_acc_bits == 0;
     }
 };
 
@@ -12,27 +12,63 @@ namespace io {
 /// \brief Wrapper for output streams that provides bitwise writing
 /// functionality.
 ///
-/// Bits are written into a buffer byte, which is written to the output when
-/// it is either filled or when a flush is explicitly requested.
+/// Bits are collected in a 64-bit accumulator in MSB first order. Whenever
+/// it is full, its eight bytes are appended to a block buffer, which is
+/// written to the output when it is either filled or the stream is
+/// destroyed.
+///
+/// When the stream is destroyed, the remaining bits are padded to a full
+/// byte, and the amount of bits used in the last byte is stored in the
+/// three lowest bits of that byte. If these are occupied by data, the
+/// amount is stored in an additional byte.
 class BitOStream {
+    /// The size of the block buffer in bytes.
+    static constexpr size_t BLOCK_SIZE = 4096;
+
     OutputStream m_stream;
 
-    bool m_dirty;
-    uint8_t m_next;
-    int m_cursor;
+    // pending bits, right-aligned
+    uint64_t m_acc;
+    size_t m_acc_bits;
+
+    char m_block[BLOCK_SIZE];
+    size_t m_block_size;
 
-    inline void reset() {
-        const int MSB = 7;
+    inline static uint64_t low_mask(size_t bits) {
+        return (bits >= 64) ? ~uint64_t(0) : ((uint64_t(1) << bits) - 1);
+    }
+
+    inline void flush_block() {
+        m_stream.write(m_block, m_block_size);
+        m_block_size = 0;
+    }
 
-        m_next = 0;
-        m_cursor = MSB;
-        m_dirty = false;
+    inline void put_byte(uint8_t byte) {
+        if(m_block_size == BLOCK_SIZE) flush_block();
+        m_block[m_block_size++] = char(byte);
     }
 
-    inline void write_next() {
-        if (m_dirty) {
-            m_stream.put(char(m_next));
-            reset();
+    /// Appends a full accumulator to the block buffer.
+    inline void put_word(uint64_t word) {
+        if(m_block_size + 8 > BLOCK_SIZE) flush_block();
+        for(size_t i = 0; i < 8; ++i) {
+            m_block[m_block_size++] = char(word >> (56 - 8 * i));
+        }
+    }
+
+    /// Appends up to 64 bits, which must not exceed \c bits.
+    inline void append(uint64_t value, size_t bits) {
+        const size_t free = 64 - m_acc_bits;
+        if(bits < free) {
+            m_acc = (m_acc << bits) | value;
+            m_acc_bits += bits;
+        } else {
+            const size_t rest = bits - free;
+            const uint64_t word = (free == 64 ? 0 : (m_acc << free)) |
+                                  (value >> rest);
+            put_word(word);
+            m_acc = value & low_mask(rest);
+            m_acc_bits = rest;
         }
     }
 
@@ -40,8 +76,11 @@ public:
     /// \brief Constructs a bitwise output stream.
     ///
     /// \param output The underlying output stream.
-    inline BitOStream(OutputStream&& output) : m_stream(std::move(output)) {
-        reset();
+    inline BitOStream(OutputStream&& output)
+        : m_stream(std::move(output)),
+          m_acc(0),
+          m_acc_bits(0),
+          m_block_size(0) {
     }
 
     /// \brief Constructs a bitwise output stream.
@@ -51,40 +90,41 @@ public:
     }
 
     ~BitOStream() {
-        char set = 7 - m_cursor;
-        if(m_cursor >= 2) {
-            m_next |= set;
+        // write out full bytes
+        while(m_acc_bits >= 8) {
+            m_acc_bits -= 8;
+            put_byte(uint8_t(m_acc >> m_acc_bits));
+        }
+
+        // write the last byte, padded, with the amount of bits it contains
+        const uint8_t set = m_acc_bits;
+        const uint8_t last = uint8_t(m_acc << (8 - m_acc_bits));
+        if(set <= 5) {
+            put_byte(last | set);
         } else {
-            write_next();
-            m_next = set;
+            put_byte(last);
+            put_byte(set);
         }
 
-        m_dirty = true;
-        write_next();
+        flush_block();
     }
 
     /// \brief Returns the output position indicator of the underlying stream,
-    ///        which should equal the amount of bytes written to it.
+    ///        plus the amount of complete bytes that are buffered.
     ///
-    /// Note that this value does not include bits that have not yet been
-    /// flushed.
+    /// Note that this value does not include bits that do not yet form a
+    /// complete byte.
     ///
-    /// \return the output position indicator of the underlying stream
+    /// \return the amount of complete bytes written so far
     inline auto tellp() -> decltype(m_stream.tellp()) {
-        return m_stream.tellp();
+        return m_stream.tellp() +
+            std::streamoff(m_block_size + m_acc_bits / 8);
     }
 
     /// \brief Writes a single bit to the output.
     /// \param set The bit value (0 or 1).
     inline void write_bit(bool set) {
-        if (set) {
-            m_next |= (1 << m_cursor);
-        }
-
-        m_dirty = true;
-        if (--m_cursor < 0) {
-            write_next();
-        }
+        append(set, 1);
     }
 
     /// Writes the bit representation of an integer in MSB first order to
@@ -93,21 +133,37 @@ public:
     /// \tparam The type of integer to write.
     /// \param value The integer to write.
     /// \param bits The amount of low bits of the value to write. By default,
-    ///             this equals the bit width of type \c T.
+    ///             this equals the bit width of type \c T. Bits beyond the
+    ///             width of \c T are written as zero.
     template<class T>
     inline void write_int(T value, size_t bits = sizeof(T) * CHAR_BIT) {
-        for (int i = bits - 1; i >= 0; i--) {
-            write_bit((value & T(T(1) << i)) != T(0));
+        DCHECK_LE(bits, 64U);
+        const size_t width = std::min<size_t>(bits, sizeof(T) * CHAR_BIT);
+        append(uint64_t(value) & low_mask(width), bits);
+    }
+
+    /// \brief Writes a sequence of bytes to the output.
+    ///
+    /// \param data The bytes to write.
+    /// \param size The amount of bytes.
+    inline void write_bytes(const uint8_t* data, size_t size) {
+        for(; size >= 8; data += 8, size -= 8) {
+            uint64_t word = 0;
+            for(size_t j = 0; j < 8; ++j) word = (word << 8) | data[j];
+            append(word, 64);
         }
+        for(; size > 0; ++data, --size) append(*data, 8);
     }
 
+    /// Writes \c v zero bits followed by a one bit.
     template<typename value_t>
     inline void write_unary(value_t v) {
-        while(v--) {
-            write_bit(0);
+        uint64_t zeros = v;
+        while(zeros >= 64) {
+            append(0, 64);
+            zeros -= 64;
         }
-
-        write_bit(1);
+        append(1, zeros + 1);
     }
 
     template<typename value_t>
@@ -122,12 +178,21 @@ public:
         write_int(3, 2); // terminator -> 11
     }
 
+    /// Writes the amount of bits of \c v in unary, followed by these bits.
     template<typename value_t>
     inline void write_elias_gamma(value_t v) {
-        write_unary(bits_for(v));
-        write_int(v, bits_for(v));
+        const size_t bits = bits_for(v);
+        if(2 * bits < 64) {
+            // both parts in a single append
+            append((uint64_t(1) << bits) | uint64_t(v), 2 * bits + 1);
+        } else {
+            write_unary(bits);
+            write_int(v, bits);
+        }
     }
 
+    /// Writes the amount of bits of \c v as an Elias gamma code, followed by
+    /// these bits.
     template<typename value_t>
     inline void write_elias_delta(value_t v) {
         write_elias_gamma(bits_for(v));
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace tdc {
+namespace io {
+
+/// \cond INTERNAL
+
+/// A bounded byte queue connecting exactly one writing and one reading
+/// thread.
+///
+/// Transfers are lock-free ring buffer copies. A side that has to wait for
+/// the other one spins briefly and then blocks on a condition variable, so
+/// that slow producers (e.g. a stage computing a suffix array) do not keep a
+/// core busy.
+class BoundedPipe {
+    static constexpr size_t SPIN_ROUNDS = 64;
+
+    std::vector<uint8_t> m_buffer;
+
+    // total amount of bytes read from and written to the buffer
+    std::atomic<size_t> m_head {0};
+    std::atomic<size_t> m_tail {0};
+
+    std::atomic<bool> m_write_closed {false};
+    std::atomic<bool> m_read_closed {false};
+
+    std::atomic<bool> m_reader_waiting {false};
+    std::atomic<bool> m_writer_waiting {false};
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+
+    inline void wake(std::atomic<bool>& waiting) {
+        if(waiting.load()) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cv.notify_all();
+        }
+    }
+
+    template<typename pred_t>
+    inline void wait(std::atomic<bool>& waiting, pred_t ready) {
+        for(size_t i = 0; i < SPIN_ROUNDS; ++i) {
+            if(ready()) return;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        waiting.store(true);
+        m_cv.wait(lock, ready);
+        waiting.store(false);
+    }
+
+public:
+    /// Constructs a pipe that buffers at most \c capacity bytes.
+    inline BoundedPipe(size_t capacity):
+        m_buffer(std::max<size_t>(capacity, 1)) {}
+
+    inline BoundedPipe(const BoundedPipe&) = delete;
+
+    /// Writes \c n bytes, blocking while the pipe is full.
+    ///
+    /// Bytes written after the reader has closed the pipe are discarded.
+    inline void write(const uint8_t* data, size_t n) {
+        const size_t cap = m_buffer.size();
+        while(n > 0) {
+            const size_t head_pos = m_head.load();
+            const size_t tail_pos = m_tail.load(std::memory_order_relaxed);
+            if(m_read_closed.load()) return;
+
+            const size_t space = cap - (tail_pos - head_pos);
+            if(space == 0) {
+                wait(m_writer_waiting, [&]{
+                    return m_read_closed.load() || m_head.load() != head_pos;
+                });
+                continue;
+            }
+
+            const size_t k = std::min(n, space);
+            const size_t i = tail_pos % cap;
+            const size_t first = std::min(k, cap - i);
+            std::memcpy(m_buffer.data() + i, data, first);
+            std::memcpy(m_buffer.data(), data + first, k - first);
+
+            m_tail.store(tail_pos + k);
+            wake(m_reader_waiting);
+
+            data += k;
+            n -= k;
+        }
+    }
+
+    /// Reads up to \c n bytes, blocking until at least one byte is available.
+    ///
+    /// \return the amount of bytes read, zero if the writer has closed the
+    ///         pipe and all bytes have been read.
+    inline size_t read(uint8_t* data, size_t n) {
+        const size_t cap = m_buffer.size();
+        while(true) {
+            const size_t head_pos = m_head.load(std::memory_order_relaxed);
+            const size_t tail_pos = m_tail.load();
+
+            const size_t avail = tail_pos - head_pos;
+            if(avail == 0) {
+                if(m_write_closed.load()) {
+                    // the writer may have written its last bytes just
+                    // before closing
+                    if(m_tail.load() == head_pos) return 0;
+                    continue;
+                }
+                wait(m_reader_waiting, [&]{
+                    return m_write_closed.load() || m_tail.load() != tail_pos;
+                });
+                continue;
+            }
+
+            const size_t k = std::min(n, avail);
+            const size_t i = head_pos % cap;
+            const size_t first = std::min(k, cap - i);
+            std::memcpy(data, m_buffer.data() + i, first);
+            std::memcpy(data + first, m_buffer.data(), k - first);
+
+            m_head.store(head_pos + k);
+            wake(m_writer_waiting);
+            return k;
+        }
+    }
+
+    /// Signals the reader that no more bytes will be written.
+    inline void close_write() {
+        m_write_closed.store(true);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cv.notify_all();
+    }
+
+    /// Signals the writer that no more bytes will be read.
+    inline void close_read() {
+        m_read_closed.store(true);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cv.notify_all();
+    }
+};
+
+/// Stream buffer writing into a \ref BoundedPipe in chunks.
+class PipeOStreamBuf: public std::streambuf {
+    BoundedPipe* m_pipe;
+    std::vector<char> m_chunk;
+    size_t m_flushed = 0;
+
+    inline void flush_chunk() {
+        const size_t n = pptr() - pbase();
+        m_pipe->write((const uint8_t*) pbase(), n);
+        m_flushed += n;
+        setp(m_chunk.data(), m_chunk.data() + m_chunk.size());
+    }
+
+public:
+    inline PipeOStreamBuf(BoundedPipe& pipe, size_t chunk_size = 4096):
+        m_pipe(&pipe), m_chunk(std::max<size_t>(chunk_size, 1)) {
+        setp(m_chunk.data(), m_chunk.data() + m_chunk.size());
+    }
+
+    virtual ~PipeOStreamBuf() {
+        flush_chunk();
+    }
+
+protected:
+    virtual int overflow(int ch) override {
+        flush_chunk();
+        if(ch != traits_type::eof()) {
+            *pptr() = char(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    virtual int sync() override {
+        flush_chunk();
+        return 0;
+    }
+
+    virtual std::streampos seekoff(std::streamoff off,
+                                   std::ios_base::seekdir way,
+                                   std::ios_base::openmode which) override {
+        // only support querying the position, used by tellp
+        if(off == 0 && way == std::ios_base::cur && (which & std::ios_base::out)) {
+            return std::streampos(m_flushed + (pptr() - pbase()));
+        }
+        return std::streampos(std::streamoff(-1));
+    }
+};
+
+/// Stream buffer reading from a \ref BoundedPipe in chunks.
+class PipeIStreamBuf: public std::streambuf {
+    BoundedPipe* m_pipe;
+    std::vector<char> m_chunk;
+    size_t m_consumed = 0;
+
+public:
+    inline PipeIStreamBuf(BoundedPipe& pipe, size_t chunk_size = 4096):
+        m_pipe(&pipe), m_chunk(std::max<size_t>(chunk_size, 1)) {
+        setg(m_chunk.data(), m_chunk.data(), m_chunk.data());
+    }
+
+protected:
+    virtual int underflow() override {
+        if(gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+
+        m_consumed += egptr() - eback();
+        const size_t n = m_pipe->read((uint8_t*) m_chunk.data(), m_chunk.size());
+        setg(m_chunk.data(), m_chunk.data(), m_chunk.data() + n);
+
+        if(n == 0) return traits_type::eof();
+        return traits_type::to_int_type(*gptr());
+    }
+
+    virtual std::streampos seekoff(std::streamoff off,
+                                   std::ios_base::seekdir way,
+                                   std::ios_base::openmode which) override {
+        // only support querying the position, used by tellg
+        if(off == 0 && way == std::ios_base::cur && (which & std::ios_base::in)) {
+            return std::streampos(m_consumed + (gptr() - eback()));
+        }
+        return std::streampos(std::streamoff(-1));
+    }
+};
+
+/// \endcond
+
+}}
+
@@ -158,6 +158,21 @@ namespace tdc {namespace io {
         Input(std::istream& stream):
             m_data(std::make_shared<Variant>(InputSource(&stream))) {}
 
+        /// \brief Constructs an input reading from a stream that can only be
+        /// read once.
+        ///
+        /// The first call of \ref as_stream reads directly from the stream
+        /// without buffering it in memory, after which the input cannot be
+        /// accessed anymore. If \ref as_view or \ref size are called
+        /// first, the stream gets buffered like for regular stream inputs.
+        ///
+        /// \param stream The input stream.
+        static Input single_pass(std::istream& stream) {
+            Input input;
+            input.m_data = std::make_shared<Variant>(InputSource(&stream, true));
+            return input;
+        }
+
         /// \brief Move assignment operator.
         Input& operator=(Input&& other) {
             m_data = std::move(other.m_data);
@@ -215,7 +230,7 @@ namespace tdc {namespace io {
         ///
         /// For example, if your source is a `istream` it will
         /// generally have to create a copy to allow calling this method
-        /// multiple times.
+        /// multiple times. Single-pass inputs are streamed directly instead.
         ///
         /// \return A character stream for the input.
         inline InputStream as_stream() const;
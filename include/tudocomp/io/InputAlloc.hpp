@@ -175,6 +175,16 @@ namespace tdc {namespace io {
 
             // If there isn't one yet, create it.
             if (parent_ptr == nullptr) {
+                if (src.is_single_pass()) {
+                    auto& state = src.single_pass_state();
+                    if (state == InputSource::SinglePassState::Streamed) {
+                        throw std::runtime_error(
+                            "Attempt to access a single-pass stream `Input` "
+                            "after it has been streamed.");
+                    }
+                    state = InputSource::SinglePassState::Buffered;
+                }
+
                 create_buffer([&](std::weak_ptr<InputAlloc> ptr) {
                     return InputAllocChunkOwned {
                         RestrictedBuffer(src,
@@ -47,7 +47,7 @@ namespace tdc {namespace io {
         } else if (source().is_stream()) {
             if(escaped_size_unknown()) {
                 auto p = alloc().find_or_construct(
-                    InputSource(source().stream()), from(), to(), restrictions());
+                    source(), from(), to(), restrictions());
                 set_escaped_size(p->view().size());
                 unregister_alloc_chunk_handle(p);
             }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <tudocomp/util/View.hpp>
 
@@ -16,12 +17,22 @@ namespace tdc {namespace io {
             File,
             Stream
         };
+
+        /// How a single-pass stream has been accessed so far.
+        enum class SinglePassState {
+            Unused,
+            Buffered,
+            Streamed
+        };
     private:
         Content       m_content;
 
         View          m_view = ""_v;
         std::string   m_path = "";
         std::istream* m_stream = nullptr;
+
+        // shared by all copies of the source, null unless single-pass
+        std::shared_ptr<SinglePassState> m_single_pass;
     public:
         friend inline bool operator==(const InputSource&, const InputSource&);
 
@@ -34,10 +45,17 @@ namespace tdc {namespace io {
         inline InputSource(std::istream* stream):
             m_content(Content::Stream),
             m_stream(stream) {}
+        inline InputSource(std::istream* stream, bool single_pass):
+            m_content(Content::Stream),
+            m_stream(stream),
+            m_single_pass(single_pass
+                ? std::make_shared<SinglePassState>(SinglePassState::Unused)
+                : nullptr) {}
 
         inline bool is_view() const { return m_content == Content::View; }
         inline bool is_stream() const { return m_content == Content::Stream; }
         inline bool is_file() const { return m_content == Content::File; }
+        inline bool is_single_pass() const { return bool(m_single_pass); }
 
         inline const View& view() const {
             DCHECK(is_view());
@@ -53,6 +71,11 @@ namespace tdc {namespace io {
             DCHECK(is_file());
             return m_path;
         }
+
+        inline SinglePassState& single_pass_state() const {
+            DCHECK(is_single_pass());
+            return *m_single_pass;
+        }
     };
 
     inline bool operator==(const InputSource& lhs, const InputSource& rhs) {
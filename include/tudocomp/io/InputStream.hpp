@@ -69,6 +69,18 @@ namespace tdc {namespace io {
             inline File() = delete;
         };
 
+        class Direct: public InputStreamInternal::Variant {
+            std::istream* m_stream;
+
+            friend class InputStreamInternal;
+        public:
+            inline Direct(std::istream* stream): m_stream(stream) {}
+
+            inline std::istream& stream() override {
+                return *m_stream;
+            }
+        };
+
         std::unique_ptr<InputStreamInternal::Variant> m_variant;
         std::unique_ptr<RestrictedIStreamBuf> m_restricted_istream;
 
@@ -100,6 +112,17 @@ namespace tdc {namespace io {
                 );
             }
         }
+        inline InputStreamInternal(InputStreamInternal::Direct&& d,
+                                   const InputRestrictions& restrictions):
+            m_variant(std::make_unique<InputStreamInternal::Direct>(std::move(d)))
+        {
+            if (!restrictions.has_no_restrictions()) {
+                m_restricted_istream = std::make_unique<RestrictedIStreamBuf>(
+                    m_variant->stream(),
+                    restrictions
+                );
+            }
+        }
         inline InputStreamInternal(InputStreamInternal&& s):
             m_variant(std::move(s.m_variant)),
             m_restricted_istream(std::move(s.m_restricted_istream)) {}
@@ -170,6 +193,21 @@ namespace tdc {namespace io {
                     restrictions()
                 }
             };
+        } if (source().is_stream() && source().is_single_pass()
+              && from() == 0 && to_unknown()
+              && source().single_pass_state()
+                 == InputSource::SinglePassState::Unused) {
+            // Nothing has been buffered yet, so read the stream directly
+            source().single_pass_state() = InputSource::SinglePassState::Streamed;
+
+            return InputStream {
+                InputStreamInternal {
+                    InputStream::Direct {
+                        source().stream()
+                    },
+                    restrictions()
+                }
+            };
         } else {
             auto h = alloc().find_or_construct(
                 source(), from(), to(), restrictions());
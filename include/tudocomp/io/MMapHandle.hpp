@@ -6,6 +6,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <cstring>
+#include <cstdlib>
+#include <fstream>
 
 #include <tudocomp_stat/malloc.hpp>
 #include <tudocomp/def.hpp>
@@ -29,7 +31,8 @@ namespace tdc {namespace io {
         enum class State {
             Unmapped,
             Shared,
-            Private
+            Private,
+            File
         };
 
         inline static size_t adj_size(size_t v) {
@@ -54,6 +57,8 @@ namespace tdc {namespace io {
         State    m_state = State::Unmapped;
         Mode     m_mode  = Mode::Read;
 
+        bool     m_hugetlb = false;
+
     public:
         inline static bool is_offset_valid(size_t offset) {
             return (offset % pagesize()) == 0;
@@ -199,6 +204,126 @@ namespace tdc {namespace io {
             })
         }
 
+        /// Create a read-write memory map of length `size` backed by a new
+        /// file in the directory `dir`.
+        ///
+        /// The file is removed right away, so it only lives as long as the
+        /// mapping. Pages that are not accessed can be evicted to the file
+        /// by the kernel, so the mapping does not need to fit into memory.
+        inline static MMap temporary_file(const std::string& dir, size_t size) {
+            std::string path = dir + "/tudocomp-XXXXXX";
+            auto fd = mkstemp(&path[0]);
+            if (fd == -1) {
+                perror("Creating temporary file");
+            }
+            CHECK(fd != -1) << "Error at creating a file in " << dir;
+            unlink(path.c_str());
+
+            auto ret = ftruncate(fd, adj_size(size));
+            if (ret == -1) {
+                perror("Resizing temporary file");
+            }
+            CHECK(ret != -1);
+
+            void* ptr = mmap(NULL,
+                             adj_size(size),
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED,
+                             fd,
+                             0);
+            close(fd);
+            check_mmap_error(ptr, "mapping temporary file into memory");
+
+            MMap map;
+            map.m_ptr = (uint8_t*) ptr;
+            map.m_size = size;
+            map.m_state = State::File;
+            map.m_mode = Mode::ReadWrite;
+            return map;
+        }
+
+        /// Create an anonymous read-write memory map of length `size`
+        /// backed by huge pages.
+        ///
+        /// Tries to map pages from the huge page pool first (`MAP_HUGETLB`).
+        /// If the pool is exhausted or not configured, falls back to a regular
+        /// mapping advised for transparent huge pages (`MADV_HUGEPAGE`),
+        /// which the kernel may or may not honor. The size is rounded up to a
+        /// multiple of \ref huge_pagesize. Use \ref huge_page_bytes to find out
+        /// how much of the mapping is actually backed by huge pages.
+        inline static MMap huge_pages(size_t size) {
+            const size_t hps = huge_pagesize();
+            size = std::max(size_t(1), (size + hps - 1) / hps) * hps;
+
+            MMap map;
+            void* ptr = MAP_FAILED;
+            #ifdef MAP_HUGETLB
+            ptr = mmap(NULL,
+                       size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                       -1,
+                       0);
+            #endif
+            if (ptr != MAP_FAILED) {
+                map.m_ptr = (uint8_t*) ptr;
+                map.m_size = size;
+                map.m_state = State::Private;
+                map.m_mode = Mode::ReadWrite;
+                map.m_hugetlb = true;
+                IF_STATS({
+                    malloc_callback::on_alloc(size);
+                })
+            } else {
+                map = MMap(size);
+                #ifdef MADV_HUGEPAGE
+                map.advise(MADV_HUGEPAGE);
+                #endif
+            }
+            return map;
+        }
+
+        /// The size of a huge page in bytes, as used by \ref huge_pages.
+        inline static size_t huge_pagesize() {
+            return size_t(2) << 20;
+        }
+
+        /// Returns the amount of bytes of this mapping that are currently
+        /// backed by huge pages.
+        ///
+        /// For transparent huge pages, this is read from `/proc/self/smaps`
+        /// and only includes pages that have been touched already.
+        inline size_t huge_page_bytes() const {
+            if (m_state == State::Unmapped) return 0;
+            if (m_hugetlb) return m_size;
+
+            std::ifstream smaps("/proc/self/smaps");
+            const uintptr_t addr = uintptr_t(m_ptr);
+            bool found = false;
+            for(std::string line; std::getline(smaps, line);) {
+                const size_t dash = line.find('-');
+                if (dash != std::string::npos && line.find(':') > dash &&
+                    line.find(' ') > dash) {
+                    // mapping header, e.g., "7f0000000000-7f0000200000 rw-p ..."
+                    const uintptr_t begin = std::strtoull(line.c_str(), nullptr, 16);
+                    const uintptr_t end = std::strtoull(line.c_str() + dash + 1, nullptr, 16);
+                    found = (begin <= addr && addr < end);
+                } else if (found && line.compare(0, 14, "AnonHugePages:") == 0) {
+                    const size_t kib = std::strtoull(line.c_str() + 14, nullptr, 10);
+                    return std::min(m_size, kib * 1024);
+                }
+            }
+            return 0;
+        }
+
+        /// Advises the kernel about the expected access pattern,
+        /// e.g., `MADV_SEQUENTIAL`.
+        inline void advise(int advice) {
+            if (m_state != State::Unmapped) {
+                madvise(m_ptr, adj_size(m_size), advice);
+            }
+        }
+
         /// Changes the size of this mapping.
         ///
         /// Only works if the mapping is in read-write mode.
@@ -239,7 +364,7 @@ namespace tdc {namespace io {
         GenericView<uint8_t> view() {
             const auto err = "Attempting to get a mutable view into a read-only mapping. Call the const overload of view() instead"_v;
 
-            DCHECK(m_state == State::Private) << err;
+            DCHECK(m_state == State::Private || m_state == State::File) << err;
             DCHECK(m_mode == Mode::ReadWrite) << err;
             return GenericView<uint8_t>(m_ptr, m_size);
         }
@@ -253,6 +378,7 @@ namespace tdc {namespace io {
 
             m_state = other.m_state;
             m_mode  = other.m_mode;
+            m_hugetlb = other.m_hugetlb;
 
             other.m_state = State::Unmapped;
             other.m_ptr = (uint8_t*) EMPTY;
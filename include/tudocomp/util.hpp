@@ -226,6 +226,25 @@ inline constexpr uint_fast8_t bytes_for(size_t n) {
     return idiv_ceil(bits_for(n), 8U);
 }
 
+/// \brief Selects the width of the narrowest index type that can store
+/// the given integer value.
+///
+/// The candidates are 32, 40 and 64 bits, i.e., the widths of `uint32_t`,
+/// `uint_t<40>` and `uint64_t`. This allows arrays of text positions to be
+/// as compact as the input permits while keeping byte-aligned entries,
+/// regardless of \ref len_compact_t.
+///
+/// Examples:
+/// - `index_width(0xFFFFFFFF) == 32`
+/// - `index_width(0x100000000) == 40`
+/// - `index_width(0x10000000000) == 64`
+///
+/// \param n The integer to be stored.
+/// \return The width of the index type in bits.
+inline constexpr uint_fast8_t index_width(size_t n) {
+    return bits_for(n) <= 32 ? 32U : (bits_for(n) <= 40 ? 40U : 64U);
+}
+
 /// \brief Yields the position of the most significant bit for the template
 ///        integer type.
 ///
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace tdc {
+
+/// \brief Scales counts of symbols to frequencies that sum up to a power of
+///        two, as needed by table-based entropy coders.
+///
+/// Each symbol with a non-zero count keeps a frequency of at least one.
+/// Rounding errors are corrected at the expense of the most frequent
+/// symbols.
+///
+/// \param counts the count of each symbol, at least one of them non-zero.
+/// \param log the binary logarithm of the sum, where <tt>2^log</tt> must be at
+///            least the amount of symbols with a non-zero count.
+/// \return the frequency of each symbol.
+inline std::vector<size_t> normalize_frequencies(
+    const std::vector<size_t>& counts, const size_t log) {
+
+    const size_t target = size_t(1) << log;
+
+    size_t total = 0;
+    for(const size_t count : counts) total += count;
+    DCHECK_GT(total, 0U);
+
+    std::vector<size_t> freqs(counts.size(), 0);
+    size_t sum = 0;
+    size_t most_frequent = 0;
+    for(size_t c = 0; c < counts.size(); ++c) {
+        if(counts[c] == 0) continue;
+        freqs[c] = std::max<size_t>(1, (counts[c] * target + total / 2) / total);
+        sum += freqs[c];
+        if(counts[c] > counts[most_frequent]) most_frequent = c;
+    }
+
+    // correct the rounding errors
+    while(sum > target) {
+        auto it = std::max_element(freqs.begin(), freqs.end());
+        DCHECK_GT(*it, 1U);
+        --(*it);
+        --sum;
+    }
+    freqs[most_frequent] += target - sum;
+    return freqs;
+}
+
+}
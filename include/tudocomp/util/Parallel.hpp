@@ -0,0 +1,377 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tudocomp/def.hpp>
+
+namespace tdc {
+
+/// \brief Resolves a requested thread count.
+///
+/// A request of zero threads selects the number of hardware threads.
+///
+/// \param requested the requested amount of threads.
+/// \return the amount of threads to use, at least one.
+inline size_t resolve_thread_count(size_t requested) {
+    if(requested == 0) {
+        requested = std::thread::hardware_concurrency();
+    }
+    return std::max<size_t>(requested, 1);
+}
+
+/// \brief Calls \c work(t) for each \c t in <tt>[0, threads)</tt>, each on
+///        its own thread.
+///
+/// The calling thread processes \c t = 0. If any call throws, the first
+/// exception is rethrown on the calling thread after all threads have been
+/// joined.
+///
+/// \param threads the amount of threads.
+/// \param work the function to call, called concurrently.
+template<typename work_t>
+inline void parallel_run(size_t threads, work_t work) {
+    std::mutex mutex;
+    std::exception_ptr error;
+
+    auto run = [&](size_t t) {
+        try {
+            work(t);
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!error) error = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(run, t);
+    }
+    run(0);
+
+    for(auto& t : pool) {
+        t.join();
+    }
+
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/// \brief Sorts a range using \c threads threads.
+///
+/// The range is split into one chunk per thread, the chunks are sorted
+/// concurrently and then merged pairwise in rounds. Each merge is split into
+/// independent parts of equal output size, so that all threads take part in
+/// every round. The sort is not stable.
+///
+/// \param begin the beginning of the range.
+/// \param end the end of the range.
+/// \param comp the comparison function.
+/// \param threads the amount of threads.
+template<typename iterator_t, typename compare_t>
+inline void parallel_sort(
+    iterator_t begin, iterator_t end, compare_t comp, size_t threads) {
+
+    using value_t = typename std::iterator_traits<iterator_t>::value_type;
+
+    // chunks smaller than this are not worth a thread
+    static constexpr size_t MIN_CHUNK = 1ULL << 14;
+
+    const size_t n = end - begin;
+    threads = std::max<size_t>(1, std::min(threads, n / MIN_CHUNK));
+    if(threads == 1) {
+        std::sort(begin, end, comp);
+        return;
+    }
+
+    // the boundaries of the sorted runs
+    std::vector<size_t> bounds(threads + 1);
+    for(size_t t = 0; t <= threads; ++t) bounds[t] = n * t / threads;
+
+    parallel_run(threads, [&](size_t t) {
+        std::sort(begin + bounds[t], begin + bounds[t + 1], comp);
+    });
+
+    std::vector<value_t> buffer(n);
+    bool in_buffer = false; // whether the runs are in the buffer
+
+    while(bounds.size() > 2) {
+        const size_t runs = bounds.size() - 1;
+        const size_t pairs = runs / 2;
+        const size_t parts = std::max<size_t>(1, threads / pairs);
+
+        // merge run 2p with run 2p + 1 in parts, and copy a single last run
+        auto merge = [&](auto src, auto dst) {
+            parallel_run(pairs * parts, [&](size_t job) {
+                const size_t p = job / parts;
+                const size_t part = job % parts;
+
+                const size_t a_begin = bounds[2 * p];
+                const size_t b_begin = bounds[2 * p + 1];
+                const size_t b_end = bounds[2 * p + 2];
+                const size_t a_size = b_begin - a_begin;
+                const size_t b_size = b_end - b_begin;
+                const size_t size = a_size + b_size;
+
+                // the amount of elements taken from the first run for the
+                // first k merged elements
+                auto split = [&](size_t k) {
+                    size_t lo = (k > b_size) ? k - b_size : 0;
+                    size_t hi = std::min(k, a_size);
+                    while(lo < hi) {
+                        const size_t mid = (lo + hi) / 2;
+                        if(comp(src[b_begin + k - mid - 1], src[a_begin + mid])) {
+                            hi = mid;
+                        } else {
+                            lo = mid + 1;
+                        }
+                    }
+                    return lo;
+                };
+
+                const size_t k0 = size * part / parts;
+                const size_t k1 = size * (part + 1) / parts;
+                const size_t i0 = split(k0);
+                const size_t i1 = split(k1);
+                std::merge(
+                    src + a_begin + i0, src + a_begin + i1,
+                    src + b_begin + (k0 - i0), src + b_begin + (k1 - i1),
+                    dst + a_begin + k0, comp);
+            });
+            if(runs % 2 == 1) {
+                std::copy(src + bounds[runs - 1], src + bounds[runs], dst + bounds[runs - 1]);
+            }
+        };
+        if(in_buffer) merge(buffer.begin(), begin);
+        else          merge(begin, buffer.begin());
+        in_buffer = !in_buffer;
+
+        // every second boundary vanishes
+        std::vector<size_t> merged;
+        for(size_t r = 0; r < runs; r += 2) merged.push_back(bounds[r]);
+        merged.push_back(n);
+        bounds = std::move(merged);
+    }
+
+    if(in_buffer) {
+        parallel_run(threads, [&](size_t t) {
+            std::copy(buffer.begin() + n * t / threads,
+                      buffer.begin() + n * (t + 1) / threads,
+                      begin + n * t / threads);
+        });
+    }
+}
+
+/// \brief Assigns <tt>out[dest(i)] = value(i)</tt> for each \c i in
+///        <tt>[0, n)</tt> using \c threads threads.
+///
+/// Random writes into a large array are bound by cache misses. Therefore,
+/// the destination range is divided into blocks that fit into the cache,
+/// the assignments are first bucketed by their destination block into a
+/// buffer and then performed block by block, with each thread writing into
+/// its own blocks. To bound the size of the buffer, this is done in rounds
+/// of a part of the indices. A single thread performs the assignments
+/// directly, without the buffer.
+///
+/// The blocks consist of a multiple of 64 entries, so that threads never
+/// write into the same word of a bit-packed \c out.
+///
+/// \param out the array to write into, of size \c m.
+/// \param m the size of the destination range.
+/// \param n the amount of assignments.
+/// \param dest the destination of assignment \c i, pairwise distinct.
+/// \param value the value of assignment \c i.
+/// \param threads the amount of threads.
+template<typename array_t, typename dest_t, typename value_t>
+inline void parallel_scatter(array_t& out, size_t m, size_t n,
+    dest_t dest, value_t value, size_t threads) {
+
+    // the binary logarithm of the minimum amount of entries in a block
+    static constexpr size_t MIN_BLOCK_BITS = 16;
+
+    // the maximum amount of blocks, bounding the amount of output streams
+    // when bucketing
+    static constexpr size_t MAX_BLOCKS = 1024;
+
+    // the amount of rounds, bounding the size of the buffer
+    static constexpr size_t ROUNDS = 4;
+
+    size_t block_bits = MIN_BLOCK_BITS;
+    while((m >> block_bits) >= MAX_BLOCKS) ++block_bits;
+    const size_t blocks = (m + (size_t(1) << block_bits) - 1) >> block_bits;
+
+    threads = std::min(threads, blocks);
+    if(threads <= 1) {
+        for(size_t i = 0; i < n; ++i) {
+            const size_t d = dest(i);
+            out[d] = value(i);
+        }
+        return;
+    }
+
+    struct Assignment {
+        len_t dest;
+        len_t value;
+    };
+
+    const size_t round = std::max<size_t>(1, (n + ROUNDS - 1) / ROUNDS);
+    std::vector<Assignment> buffer(std::min(n, round));
+    std::vector<size_t> offsets(threads * blocks);
+
+    for(size_t from = 0; from < n; from += round) {
+        const size_t to = std::min(n, from + round);
+        auto chunk_begin = [&](size_t t) { return from + (to - from) * t / threads; };
+
+        // count the assignments of each thread per block
+        parallel_run(threads, [&](size_t t) {
+            size_t* count = offsets.data() + t * blocks;
+            std::fill(count, count + blocks, 0);
+            for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); ++i) {
+                ++count[size_t(dest(i)) >> block_bits];
+            }
+        });
+
+        // order the buffer by block, then by thread
+        size_t sum = 0;
+        std::vector<size_t> block_begin(blocks + 1);
+        for(size_t b = 0; b < blocks; ++b) {
+            block_begin[b] = sum;
+            for(size_t t = 0; t < threads; ++t) {
+                const size_t count = offsets[t * blocks + b];
+                offsets[t * blocks + b] = sum;
+                sum += count;
+            }
+        }
+        block_begin[blocks] = sum;
+
+        // bucket the assignments
+        parallel_run(threads, [&](size_t t) {
+            size_t* offset = offsets.data() + t * blocks;
+            for(size_t i = chunk_begin(t); i < chunk_begin(t + 1); ++i) {
+                const size_t d = dest(i);
+                buffer[offset[d >> block_bits]++] = Assignment { len_t(d), len_t(value(i)) };
+            }
+        });
+
+        // perform the assignments block by block
+        parallel_run(threads, [&](size_t t) {
+            for(size_t b = blocks * t / threads; b < blocks * (t + 1) / threads; ++b) {
+                for(size_t j = block_begin[b]; j < block_begin[b + 1]; ++j) {
+                    out[buffer[j].dest] = buffer[j].value;
+                }
+            }
+        });
+    }
+}
+
+/// \brief Processes \c n independent jobs on a pool of worker threads while
+///        consuming their results in order.
+///
+/// \c work(i) is called for each job \c i on one of \c threads worker
+/// threads. \c emit(i) is called on the calling thread in ascending order of
+/// \c i, as soon as job \c i has finished. Workers never run further ahead
+/// than \c window jobs past the last emitted one, which bounds the amount of
+/// results that are kept in memory at any time.
+///
+/// If any call to \c work or \c emit throws, no further jobs are started and
+/// the first exception is rethrown on the calling thread after all workers
+/// have been joined.
+///
+/// \param n the amount of jobs.
+/// \param threads the amount of worker threads.
+/// \param window the maximum amount of jobs that are started but not emitted.
+/// \param work the job function, called concurrently.
+/// \param emit the result consumer, called sequentially.
+template<typename work_t, typename emit_t>
+inline void parallel_for_ordered(
+    size_t n, size_t threads, size_t window, work_t work, emit_t emit) {
+
+    threads = std::max<size_t>(std::min(threads, n), 1);
+    window = std::max(window, threads);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    size_t next = 0;
+    size_t emitted = 0;
+    std::vector<bool> done(n, false);
+    std::exception_ptr error;
+
+    auto fail = [&](std::exception_ptr e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!error) error = e;
+        cv.notify_all();
+    };
+
+    auto worker = [&]() {
+        while(true) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]{
+                    return error || next >= n || next < emitted + window;
+                });
+                if(error || next >= n) return;
+                i = next++;
+            }
+
+            try {
+                work(i);
+            } catch(...) {
+                fail(std::current_exception());
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done[i] = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for(size_t t = 0; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+
+    for(size_t i = 0; i < n; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]{ return error || done[i]; });
+            if(error) break;
+        }
+
+        try {
+            emit(i);
+        } catch(...) {
+            fail(std::current_exception());
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            emitted = i + 1;
+        }
+        cv.notify_all();
+    }
+
+    for(auto& t : pool) {
+        t.join();
+    }
+
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}
+
@@ -19,10 +19,69 @@
 #include <tudocomp/util/GenericView.hpp>
 #include <tudocomp/util/GenericConstU8View.hpp>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace tdc {
 
 using ByteView = ConstGenericView<uint8_t>;
 using View = ByteView;
 using string_ref = View;
 
+/// \brief Returns the length of the longest common prefix of the byte
+///        sequences starting at \c a and \c b, but at most \c max_len.
+///
+/// The sequences are compared a word at a time: the first mismatching
+/// byte within a word is located via the lowest set bit of the XOR of both
+/// words. With AVX2, long common prefixes are skipped 32 bytes at a time.
+///
+/// Where most extensions are expected to be empty, callers should test the
+/// first byte themselves before calling this: the result of a plain byte
+/// comparison can be predicted, while the result of this function is a data
+/// dependency for any following access.
+///
+/// \param a the first sequence, of at least \c max_len bytes.
+/// \param b the second sequence, of at least \c max_len bytes.
+/// \param max_len the maximum length to compare.
+inline size_t lce(const uint8_t* a, const uint8_t* b, size_t max_len) {
+    size_t len = 0;
+#ifdef __AVX2__
+    for(; len + 32 <= max_len; len += 32) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(a + len));
+        const __m256i y = _mm256_loadu_si256((const __m256i*)(b + len));
+        const uint32_t eq = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+        if(eq != 0xFFFFFFFFu) {
+            return len + __builtin_ctz(~eq);
+        }
+    }
+#endif
+    for(; len + 8 <= max_len; len += 8) {
+        uint64_t x, y;
+        std::memcpy(&x, a + len, sizeof(x));
+        std::memcpy(&y, b + len, sizeof(y));
+        if(x != y) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return len + (__builtin_ctzll(x ^ y) >> 3);
+#else
+            return len + (__builtin_clzll(x ^ y) >> 3);
+#endif
+        }
+    }
+    while(len < max_len && a[len] == b[len]) ++len;
+    return len;
+}
+
+/// \brief Returns the length of the longest common extension of the
+///        positions \c i and \c j of \c text, i.e., the length of the
+///        longest common prefix of the suffixes starting at \c i and \c j,
+///        but at most \c max_len.
+inline size_t lce(View text, size_t i, size_t j,
+                  size_t max_len = View::npos) {
+    DCHECK_LE(i, text.size());
+    DCHECK_LE(j, text.size());
+    return lce(text.data() + i, text.data() + j,
+        std::min(max_len, text.size() - std::max(i, j)));
+}
+
 }
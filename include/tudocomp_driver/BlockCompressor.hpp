@@ -0,0 +1,402 @@
+#pragma once
+
+#include <tudocomp/Compressor.hpp>
+#include <tudocomp/Env.hpp>
+#include <tudocomp/Registry.hpp>
+#include <tudocomp/io.hpp>
+#include <tudocomp/CreateAlgorithm.hpp>
+#include <tudocomp/util/Parallel.hpp>
+#include <tudocomp_driver/Registry.hpp>
+#include <tudocomp_stat/StatPhase.hpp>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tdc {
+
+/// Splits the input into independent blocks and compresses them in parallel
+/// using separate instances of an arbitrary compressor.
+///
+/// The output is a sequence of frames followed by an empty frame. Each frame
+/// starts with its amount of blocks \c n, followed by a block table of \c n
+/// pairs (uncompressed size, compressed size) and the \c n compressed blocks.
+/// All integers are stored as 64-bit little endian values. The block table
+/// allows the decompressor to locate all blocks up front and restore them in
+/// parallel as well.
+///
+/// The empty frame is followed by a block index, which stores a triple
+/// (uncompressed offset, compressed offset, compressed size) for every block,
+/// and a trailer consisting of the total uncompressed size, the amount of
+/// blocks and a magic number. The index can be read from the end of the
+/// container and allows #decompress_range to restore an arbitrary range of
+/// the text by only decoding the blocks that overlap it.
+class BlockCompressor: public Compressor {
+public:
+    inline static Meta meta() {
+        Meta m("compressor", "blocks",
+            "Compresses independent blocks of the input in parallel.");
+        m.option("compressor").dynamic_compressor();
+        m.option("block_size").dynamic("16777216");
+        m.option("threads").dynamic(0);
+        return m;
+    }
+
+    /// No default construction allowed
+    inline BlockCompressor() = delete;
+
+    /// Construct the class with an environment.
+    inline BlockCompressor(Env&& env):
+        Compressor(std::move(env)) {}
+
+private:
+    /// Marks the end of a block container that carries a block index.
+    static constexpr uint64_t INDEX_MAGIC = 0x5849'4b4c'4243'4454ULL; // "TDCBLKIX"
+
+    /// Size of a block index entry and of the trailer, in bytes.
+    static constexpr size_t INDEX_ENTRY_SIZE = 24;
+    static constexpr size_t TRAILER_SIZE = 24;
+
+    std::mutex m_registry_mutex;
+
+    struct Block {
+        size_t raw_offset;
+        size_t raw_size;
+        size_t offset;
+        size_t size;
+    };
+
+    inline static void write_u64(io::OutputStream& os, uint64_t v) {
+        for(size_t i = 0; i < 8; ++i) {
+            os.put(char(uint8_t(v >> (8 * i))));
+        }
+    }
+
+    inline static uint64_t read_u64(const View& view, size_t& pos) {
+        if(pos + 8 > view.size()) {
+            throw std::runtime_error("truncated block container");
+        }
+        uint64_t v = 0;
+        for(size_t i = 0; i < 8; ++i) {
+            v |= uint64_t(view[pos + i]) << (8 * i);
+        }
+        pos += 8;
+        return v;
+    }
+
+    inline const AlgorithmValue& block_algorithm() {
+        auto& option_value = env().option("compressor");
+        DCHECK(option_value.is_algorithm());
+        return option_value.as_algorithm();
+    }
+
+    /// Creates a fresh instance of the block compressor. This may be called
+    /// from worker threads, so registry lookups are serialized.
+    inline std::unique_ptr<Compressor> create_block_compressor() {
+        std::lock_guard<std::mutex> lock(m_registry_mutex);
+        return create_algo_with_registry_dynamic(
+            tdc_algorithms::COMPRESSOR_REGISTRY, block_algorithm());
+    }
+
+    /// Parses the frame structure of a block container, yielding the
+    /// location of every compressed block within the given view.
+    inline static std::vector<Block> read_block_table(const View& view) {
+        std::vector<Block> blocks;
+        size_t raw_offset = 0;
+        size_t pos = 0;
+        while(true) {
+            const size_t n = read_u64(view, pos);
+            if(n == 0) break;
+
+            const size_t table_begin = pos;
+            size_t payload = table_begin + 16 * n;
+            for(size_t i = 0; i < n; ++i) {
+                size_t entry = table_begin + 16 * i;
+                const size_t raw_size = read_u64(view, entry);
+                const size_t size = read_u64(view, entry);
+                blocks.push_back(Block { raw_offset, raw_size, payload, size });
+                raw_offset += raw_size;
+                payload += size;
+            }
+
+            if(payload > view.size()) {
+                throw std::runtime_error("truncated block container");
+            }
+            pos = payload;
+        }
+        return blocks;
+    }
+
+    /// Reads the block index from the end of a block container.
+    ///
+    /// Only the trailer and the index are accessed, so this takes time
+    /// proportional to the amount of blocks rather than the container size.
+    /// Falls back to parsing the frame structure if the container has no
+    /// valid index.
+    inline static std::vector<Block> read_block_index(const View& view) {
+        if(view.size() >= TRAILER_SIZE) {
+            size_t pos = view.size() - TRAILER_SIZE;
+            const size_t raw_total = read_u64(view, pos);
+            const size_t n = read_u64(view, pos);
+            const uint64_t magic = read_u64(view, pos);
+
+            const size_t avail = (view.size() - TRAILER_SIZE) / INDEX_ENTRY_SIZE;
+            if(magic == INDEX_MAGIC && n <= avail) {
+                std::vector<Block> blocks(n);
+                pos = view.size() - TRAILER_SIZE - n * INDEX_ENTRY_SIZE;
+                const size_t index_begin = pos;
+
+                bool valid = true;
+                for(size_t i = 0; i < n; ++i) {
+                    blocks[i].raw_offset = read_u64(view, pos);
+                    blocks[i].offset = read_u64(view, pos);
+                    blocks[i].size = read_u64(view, pos);
+                    valid = valid
+                        && blocks[i].offset <= index_begin
+                        && blocks[i].size <= index_begin - blocks[i].offset
+                        && blocks[i].raw_offset <= raw_total
+                        && (i == 0 || blocks[i].raw_offset >= blocks[i-1].raw_offset);
+                }
+
+                if(valid) {
+                    for(size_t i = 0; i < n; ++i) {
+                        const size_t end = (i + 1 < n)
+                            ? blocks[i + 1].raw_offset : raw_total;
+                        blocks[i].raw_size = end - blocks[i].raw_offset;
+                    }
+                    return blocks;
+                }
+            }
+        }
+
+        return read_block_table(view);
+    }
+
+    /// Decompresses the blocks `[first, last)` in parallel and passes each
+    /// restored block to `emit` in order.
+    template<typename emit_t>
+    inline void decompress_blocks(const View& view,
+                                  const std::vector<Block>& blocks,
+                                  size_t first, size_t last,
+                                  emit_t emit) {
+        const size_t threads = resolve_thread_count(
+            env().option("threads").as_integer());
+
+        const auto flags = block_algorithm().textds_flags();
+
+        StatPhase::log("threads", threads);
+        StatPhase::log("blocks", last - first);
+
+        std::vector<std::vector<uint8_t>> buffers(last - first);
+
+        parallel_for_ordered(last - first, threads, 2 * threads,
+            [&](size_t j) {
+                const Block& b = blocks[first + j];
+                buffers[j].reserve(b.raw_size);
+
+                auto compressor = create_block_compressor();
+                Input block(view.substr(b.offset, b.size));
+                {
+                    Output out(buffers[j]);
+                    if(flags.has_restrictions()) {
+                        Output unrestricted(out, flags);
+                        compressor->decompress(block, unrestricted);
+                    } else {
+                        compressor->decompress(block, out);
+                    }
+                }
+
+                if(buffers[j].size() != b.raw_size) {
+                    throw std::runtime_error(
+                        "block decompressed to an unexpected size");
+                }
+            },
+            [&](size_t j) {
+                emit(blocks[first + j], buffers[j]);
+                buffers[j] = std::vector<uint8_t>();
+            });
+    }
+
+public:
+    /// Compress `inp` into `out`.
+    ///
+    /// \param input The input stream.
+    /// \param output The output stream.
+    inline virtual void compress(Input& input, Output& output) override final {
+        const size_t block_size = env().option("block_size").as_integer();
+        const size_t threads = resolve_thread_count(
+            env().option("threads").as_integer());
+        CHECK_GT(block_size, 0u) << "block_size must be positive";
+
+        const auto flags = block_algorithm().textds_flags();
+
+        auto view = input.as_view();
+        const size_t num_blocks = (view.size() + block_size - 1) / block_size;
+
+        StatPhase::log("block_size", block_size);
+        StatPhase::log("threads", threads);
+        StatPhase::log("blocks", num_blocks);
+
+        std::vector<std::vector<uint8_t>> buffers(num_blocks);
+
+        // compressed offset and size of each block, for the block index
+        std::vector<size_t> offsets(num_blocks);
+        std::vector<size_t> sizes(num_blocks);
+
+        auto os = output.as_stream();
+        size_t pos = 0;
+        std::vector<size_t> frame;
+        const size_t frame_blocks = threads;
+
+        auto write_frame = [&]() {
+            write_u64(os, frame.size());
+            for(size_t i : frame) {
+                const size_t from = i * block_size;
+                write_u64(os, std::min(view.size(), from + block_size) - from);
+                write_u64(os, buffers[i].size());
+            }
+            pos += 8 + 16 * frame.size();
+            for(size_t i : frame) {
+                offsets[i] = pos;
+                sizes[i] = buffers[i].size();
+                os.write((const char*) buffers[i].data(), buffers[i].size());
+                pos += buffers[i].size();
+                buffers[i] = std::vector<uint8_t>();
+            }
+            frame.clear();
+        };
+
+        StatPhase::wrap("Compress Blocks", [&]{
+            parallel_for_ordered(num_blocks, threads, 2 * frame_blocks,
+                [&](size_t i) {
+                    const size_t from = i * block_size;
+                    const size_t to = std::min(view.size(), from + block_size);
+
+                    auto compressor = create_block_compressor();
+                    Input block(view.slice(from, to));
+                    Output out(buffers[i]);
+                    if(flags.has_restrictions()) {
+                        Input restricted(block, flags);
+                        compressor->compress(restricted, out);
+                    } else {
+                        compressor->compress(block, out);
+                    }
+                },
+                [&](size_t i) {
+                    frame.push_back(i);
+                    if(frame.size() == frame_blocks || i + 1 == num_blocks) {
+                        write_frame();
+                    }
+                });
+        });
+
+        write_u64(os, 0);
+
+        // block index and trailer
+        for(size_t i = 0; i < num_blocks; ++i) {
+            write_u64(os, i * block_size);
+            write_u64(os, offsets[i]);
+            write_u64(os, sizes[i]);
+        }
+        write_u64(os, view.size());
+        write_u64(os, num_blocks);
+        write_u64(os, INDEX_MAGIC);
+    }
+
+    /// Decompress `inp` into `out`.
+    ///
+    /// \param input The input stream.
+    /// \param output The output stream.
+    inline virtual void decompress(Input& input, Output& output) override final {
+        auto view = input.as_view();
+        const auto blocks = read_block_table(view);
+
+        auto os = output.as_stream();
+
+        StatPhase::wrap("Decompress Blocks", [&]{
+            decompress_blocks(view, blocks, 0, blocks.size(),
+                [&](const Block&, const std::vector<uint8_t>& buffer) {
+                    os.write((const char*) buffer.data(), buffer.size());
+                });
+        });
+    }
+
+    /// Decompress the range `[from, to)` of the original text into `output`.
+    ///
+    /// Only the blocks overlapping the range are decompressed. Positions
+    /// past the end of the text are ignored.
+    ///
+    /// \param input The compressed input.
+    /// \param from The first text position to restore.
+    /// \param to The text position after the last one to restore.
+    /// \param output The output stream.
+    inline void decompress_range(Input& input, size_t from, size_t to,
+                                 Output& output) {
+        auto view = input.as_view();
+        const auto blocks = read_block_index(view);
+
+        // find the blocks overlapping [from, to)
+        auto first = std::upper_bound(blocks.begin(), blocks.end(), from,
+            [](size_t pos, const Block& b) { return pos < b.raw_offset; });
+        if(first != blocks.begin()) --first;
+        auto last = std::lower_bound(first, blocks.end(), to,
+            [](const Block& b, size_t pos) { return b.raw_offset < pos; });
+        if(from >= to) last = first;
+
+        auto os = output.as_stream();
+
+        StatPhase::wrap("Decompress Range", [&]{
+            decompress_blocks(view, blocks,
+                first - blocks.begin(), last - blocks.begin(),
+                [&](const Block& b, const std::vector<uint8_t>& buffer) {
+                    const size_t begin = std::max(from, b.raw_offset);
+                    const size_t end = std::min(to, b.raw_offset + b.raw_size);
+                    if(begin < end) {
+                        os.write((const char*) buffer.data() + (begin - b.raw_offset),
+                                 end - begin);
+                    }
+                });
+        });
+    }
+};
+
+/// Decompress the range `[from, to)` of the original text into `output`.
+///
+/// For the block-parallel compressor, only the blocks overlapping the range
+/// are decompressed. Any other compressor restores the whole text, of which
+/// only the requested range is written.
+///
+/// \param compressor The compressor that produced the input.
+/// \param input The compressed input.
+/// \param from The first text position to restore.
+/// \param to The text position after the last one to restore.
+/// \param output The output stream.
+inline void decompress_range(Compressor& compressor, Input& input,
+                             size_t from, size_t to, Output& output) {
+    if(auto blocks = dynamic_cast<BlockCompressor*>(&compressor)) {
+        blocks->decompress_range(input, from, to, output);
+        return;
+    }
+
+    const auto flags = compressor.env().root()->algo_value().textds_flags();
+
+    std::vector<uint8_t> buffer;
+    {
+        Output out(buffer);
+        if(flags.has_restrictions()) {
+            Output unrestricted(out, flags);
+            compressor.decompress(input, unrestricted);
+        } else {
+            compressor.decompress(input, out);
+        }
+    }
+
+    to = std::min(to, buffer.size());
+    if(from < to) {
+        auto os = output.as_stream();
+        os.write((const char*) buffer.data() + from, to - from);
+    }
+}
+
+}
+
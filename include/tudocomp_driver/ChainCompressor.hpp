@@ -5,18 +5,34 @@
 #include <tudocomp/Registry.hpp>
 #include <tudocomp/io.hpp>
 #include <tudocomp/CreateAlgorithm.hpp>
+#include <tudocomp/io/BoundedPipe.hpp>
 #include <tudocomp_driver/Registry.hpp>
+#include <exception>
+#include <thread>
 #include <vector>
 #include <memory>
 
 namespace tdc {
 
+/// Runs two compressors one after another, the output of the first one
+/// becoming the input of the second one.
+///
+/// By default, both stages run concurrently on separate threads and are
+/// connected by a bounded queue of \c queue_size bytes. A stage that reads
+/// its input as a stream then consumes the output of the previous stage
+/// while it is being produced. A stage that requires random access to its
+/// input buffers it in full before it starts. A \c queue_size of zero runs
+/// the stages sequentially with a full intermediate buffer instead.
+///
+/// Note that statistics phases of the first stage are not recorded when the
+/// stages run concurrently, since they are tracked per thread.
 class ChainCompressor: public Compressor {
 public:
     inline static Meta meta() {
         Meta m("compressor", "chain");
         m.option("first").dynamic_compressor();
         m.option("second").dynamic_compressor();
+        m.option("queue_size").dynamic("1048576");
         return m;
     }
 
@@ -35,31 +51,79 @@ public:
             std::swap(first_algo, second_algo);
         }
 
-        auto run = [&](Input& i, Output& o, string_ref option) {
+        struct Stage {
+            std::unique_ptr<Compressor> compressor;
+            ds::InputRestrictionsAndFlags textds_flags;
+        };
+
+        auto create = [&](string_ref option) {
             auto& option_value = env().option(option);
             DCHECK(option_value.is_algorithm());
 
             auto av = option_value.as_algorithm();
 
-            auto textds_flags = av.textds_flags();
-
             DVLOG(1) << "dynamic creation of" << av.name() << "\n";
-            auto compressor = create_algo_with_registry_dynamic(
-                tdc_algorithms::COMPRESSOR_REGISTRY, av);
-
-            f(i, o, *compressor, textds_flags);
+            return Stage {
+                create_algo_with_registry_dynamic(
+                    tdc_algorithms::COMPRESSOR_REGISTRY, av),
+                av.textds_flags(),
+            };
         };
 
-        std::vector<uint8_t> between_buf;
-        {
-            Output between(between_buf);
-            run(input, between, first_algo);
+        // create both stages up front, so that errors in their
+        // configuration surface before any thread is started
+        auto first = create(first_algo);
+        auto second = create(second_algo);
+
+        const size_t queue_size = env().option("queue_size").as_integer();
+
+        if (queue_size == 0) {
+            std::vector<uint8_t> between_buf;
+            {
+                Output between(between_buf);
+                f(input, between, *first.compressor, first.textds_flags);
+            }
+            DLOG(INFO) << "Buffer between chain: " << vec_to_debug_string(between_buf);
+            {
+                Input between(between_buf);
+                f(between, output, *second.compressor, second.textds_flags);
+            }
+            return;
         }
-        DLOG(INFO) << "Buffer between chain: " << vec_to_debug_string(between_buf);
-        {
-            Input between(between_buf);
-            run(between, output, second_algo);
+
+        io::BoundedPipe pipe(queue_size);
+        std::exception_ptr first_error;
+
+        std::thread first_thread([&] {
+            try {
+                io::PipeOStreamBuf buf(pipe);
+                std::ostream os(&buf);
+                Output between(os);
+                f(input, between, *first.compressor, first.textds_flags);
+            } catch (...) {
+                first_error = std::current_exception();
+            }
+            pipe.close_write();
+        });
+
+        std::exception_ptr second_error;
+        try {
+            io::PipeIStreamBuf buf(pipe);
+            std::istream is(&buf);
+            Input between = Input::single_pass(is);
+            f(between, output, *second.compressor, second.textds_flags);
+        } catch (...) {
+            second_error = std::current_exception();
         }
+
+        // unblock the first stage in case the second one did not read
+        // all of its input
+        pipe.close_read();
+        first_thread.join();
+
+        // an error in the first stage likely caused any error in the second
+        if (first_error) std::rethrow_exception(first_error);
+        if (second_error) std::rethrow_exception(second_error);
     }
 
     /// Compress `inp` into `out`.
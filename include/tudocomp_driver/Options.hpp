@@ -11,6 +11,9 @@ constexpr int OPT_HELP   = 1000;
 constexpr int OPT_RAW    = 1001;
 constexpr int OPT_STDIN  = 1002;
 constexpr int OPT_STDOUT = 1003;
+constexpr int OPT_THREADS = 1004;
+constexpr int OPT_BLOCK_SIZE = 1005;
+constexpr int OPT_RANGE = 1006;
 
 constexpr option OPTIONS[] = {
     {"algorithm",  required_argument, nullptr, 'a'},
@@ -25,6 +28,9 @@ constexpr option OPTIONS[] = {
     {"raw",        no_argument,       nullptr, OPT_RAW},
     {"usestdin",   no_argument,       nullptr, OPT_STDIN},
     {"usestdout",  no_argument,       nullptr, OPT_STDOUT},
+    {"threads",    required_argument, nullptr, OPT_THREADS},
+    {"block-size", required_argument, nullptr, OPT_BLOCK_SIZE},
+    {"range",      required_argument, nullptr, OPT_RANGE},
     {"logdir",     required_argument, nullptr, 'L'},
     {"loglevel",   required_argument, nullptr, 'O'},
     {"logverbosity",   required_argument, nullptr, 'V'},
@@ -128,6 +134,27 @@ public:
             << "use stdout for input"
             << endl;
 
+        // --threads
+        out << right << setw(W_NOSF) << ""
+            << left << setw(W_LF) << "--threads=N"
+            << "compress independent blocks on N threads"
+            << endl << setw(W_INDENT) << "" << "(0 uses all hardware threads)"
+            << endl;
+
+        // --block-size
+        out << right << setw(W_NOSF) << ""
+            << left << setw(W_LF) << "--block-size=S"
+            << "size of the independent blocks in bytes"
+            << endl << setw(W_INDENT) << "" << "(implied by --threads, see the blocks compressor)"
+            << endl;
+
+        // --range
+        out << right << setw(W_NOSF) << ""
+            << left << setw(W_LF) << "--range=FROM:TO"
+            << "only decompress the text positions [FROM, TO)"
+            << endl << setw(W_INDENT) << "" << "(fast for input compressed with --threads or --block-size)"
+            << endl;
+
         // -v, --version
         out << right << setw(W_SF) << "-v" << ", "
             << left << setw(W_LF) << "--version"
@@ -177,6 +204,10 @@ private:
     bool m_stats;
     std::string m_stats_title;
 
+    std::string m_threads;
+    std::string m_block_size;
+    std::string m_range;
+
     std::vector<std::string> m_remaining;
 
 public:
@@ -264,6 +295,18 @@ public:
                     m_stdout = true;
                     break;
 
+                case OPT_THREADS: // --threads=<optarg>
+                    m_threads = std::string(optarg);
+                    break;
+
+                case OPT_BLOCK_SIZE: // --block-size=<optarg>
+                    m_block_size = std::string(optarg);
+                    break;
+
+                case OPT_RANGE: // --range=<optarg>
+                    m_range = std::string(optarg);
+                    break;
+
                 case '?': // unknown option
                     m_unknown_options = true;
                     break;
@@ -302,6 +345,10 @@ public:
     const bool& stats = m_stats;
     const std::string& stats_title = m_stats_title;
 
+    const std::string& threads = m_threads;
+    const std::string& block_size = m_block_size;
+    const std::string& range = m_range;
+
     const std::vector<std::string>& remaining = m_remaining;
 };
 
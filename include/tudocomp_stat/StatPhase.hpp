@@ -41,9 +41,13 @@ inline void get_monotonic_time(struct timespec *ts){
 /// Phases are used to track runtime and memory allocations over the course
 /// of the application. The measured data can be printed as a JSON string for
 /// use in the tudocomp charter for visualization or third party applications.
+///
+/// The current phase is tracked per thread, so phases started on worker
+/// threads form independent trees and do not interfere with the phases of
+/// the thread that spawned them.
 class StatPhase {
 private:
-    static StatPhase* s_current;
+    static thread_local StatPhase* s_current;
 
     inline static unsigned long current_time_millis() {
         timespec t;
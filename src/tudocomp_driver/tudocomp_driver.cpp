@@ -4,6 +4,7 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -13,6 +14,7 @@
 #include <tudocomp/io/IOUtil.hpp>
 #include <tudocomp/version.hpp>
 
+#include <tudocomp_driver/BlockCompressor.hpp>
 #include <tudocomp_driver/Options.hpp>
 #include <tudocomp_driver/Registry.hpp>
 
@@ -38,6 +40,43 @@ static void exit(std::string msg) {
     throw std::runtime_error(msg);
 }
 
+/// Wraps an algorithm id into the block-parallel compressor if
+/// --threads or --block-size were passed.
+static std::string with_blocks(const std::string& id_string,
+                               const Options& options) {
+    if(options.threads.empty() && options.block_size.empty()) {
+        return id_string;
+    }
+
+    std::stringstream ss;
+    ss << "blocks(" << id_string;
+    if(!options.block_size.empty()) {
+        ss << ", block_size = \"" << options.block_size << "\"";
+    }
+    if(!options.threads.empty()) {
+        ss << ", threads = \"" << options.threads << "\"";
+    }
+    ss << ")";
+    return ss.str();
+}
+
+/// Parses a text range given as FROM:TO.
+static bool parse_range(const std::string& range, size_t& from, size_t& to) {
+    const size_t sep = range.find(':');
+    if(sep == std::string::npos) return false;
+
+    try {
+        size_t end;
+        from = std::stoull(range.substr(0, sep), &end);
+        if(end != sep) return false;
+        to = std::stoull(range.substr(sep + 1), &end);
+        if(end != range.size() - sep - 1) return false;
+    } catch(std::logic_error&) {
+        return false;
+    }
+    return from <= to;
+}
+
 static int bad_usage(const char* cmd, const std::string& message) {
     using namespace std;
     cerr << cmd << ": " << message << endl;
@@ -118,6 +157,16 @@ int main(int argc, char** argv) {
             }
         }
 
+        size_t range_from = 0, range_to = 0;
+        if(!options.range.empty()) {
+            if(do_compress) {
+                return bad_usage(cmd, "--range is only allowed for decompression");
+            }
+            if(!parse_range(options.range, range_from, range_to)) {
+                return bad_usage(cmd, "invalid range, expected FROM:TO");
+            }
+        }
+
         // select input
         if(!options.stdin && options.generator.empty() && options.remaining.empty()) {
             return bad_usage(cmd, "missing generator, input file or standard input");
@@ -210,7 +259,7 @@ int main(int argc, char** argv) {
         Selection selection;
 
         if (!options.algorithm.empty()) {
-            auto id_string = options.algorithm;
+            auto id_string = with_blocks(options.algorithm, options);
 
             auto av = compressor_registry.parse_algorithm_id(id_string);
             auto input_restrictions = av.textds_flags();
@@ -333,15 +382,23 @@ int main(int argc, char** argv) {
                     DLOG(INFO) << "Using manually given " << selection.id_string();
                 }
 
-                if (selection.input_restrictions().has_restrictions()) {
-                    out = Output(out, selection.input_restrictions());
-                }
+                if (!options.range.empty()) {
+                    // decompress_range undoes the input restrictions itself
+                    setup_time = clk::now();
+                    decompress_range(selection.compressor(),
+                        inp, range_from, range_to, out);
+                    comp_time = clk::now();
+                } else {
+                    if (selection.input_restrictions().has_restrictions()) {
+                        out = Output(out, selection.input_restrictions());
+                    }
 
-                //TODO: split?
-                //selection.algorithm_env()->restart_stats("Decompress");
-                setup_time = clk::now();
-                selection.compressor().decompress(inp, out);
-                comp_time = clk::now();
+                    //TODO: split?
+                    //selection.algorithm_env()->restart_stats("Decompress");
+                    setup_time = clk::now();
+                    selection.compressor().decompress(inp, out);
+                    comp_time = clk::now();
+                }
             } else {
                 setup_time = clk::now();
 
@@ -0,0 +1,113 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchpress/benchpress.hpp>
+
+#include <tudocomp/io.hpp>
+#include <tudocomp/util.hpp>
+
+using namespace tdc;
+using namespace tdc::io;
+using namespace benchpress;
+
+const size_t N_VALUES = 100000;
+const size_t BITS = 20;
+
+// pseudo-random values of BITS bits, with geometrically distributed bit
+// widths for the universal codes
+static const std::vector<uint64_t>& values() {
+    static std::vector<uint64_t> v = [] {
+        std::vector<uint64_t> v(N_VALUES);
+        uint64_t seed = 1;
+        for(auto& x : v) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            x = (seed >> 33) & ((1ULL << BITS) - 1);
+            x >>= (seed >> 20) % BITS;
+        }
+        return v;
+    }();
+    return v;
+}
+
+struct BitwiseInt {
+    static void write(BitOStream& out, uint64_t v) {
+        for(size_t i = BITS; i > 0; --i) out.write_bit((v >> (i - 1)) & 1);
+    }
+    static uint64_t read(BitIStream& in) {
+        uint64_t v = 0;
+        for(size_t i = 0; i < BITS; ++i) v = (v << 1) | in.read_bit();
+        return v;
+    }
+};
+
+struct Int {
+    static void write(BitOStream& out, uint64_t v) { out.write_int(v, BITS); }
+    static uint64_t read(BitIStream& in) { return in.read_int<uint64_t>(BITS); }
+};
+
+struct Unary {
+    static void write(BitOStream& out, uint64_t v) { out.write_unary(bits_for(v)); }
+    static uint64_t read(BitIStream& in) { return in.read_unary<uint64_t>(); }
+};
+
+struct Gamma {
+    static void write(BitOStream& out, uint64_t v) { out.write_elias_gamma(v); }
+    static uint64_t read(BitIStream& in) { return in.read_elias_gamma<uint64_t>(); }
+};
+
+struct Delta {
+    static void write(BitOStream& out, uint64_t v) { out.write_elias_delta(v); }
+    static uint64_t read(BitIStream& in) { return in.read_elias_delta<uint64_t>(); }
+};
+
+template<class Code>
+static std::string encode() {
+    std::ostringstream ss;
+    {
+        Output output(ss);
+        BitOStream out(output);
+        for(auto v : values()) Code::write(out, v);
+    }
+    return ss.str();
+}
+
+// each iteration writes or reads N_VALUES values
+template<class Code>
+inline void write_bench(benchpress::context* ctx) {
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        std::ostringstream ss;
+        {
+            Output output(ss);
+            BitOStream out(output);
+            for(auto v : values()) Code::write(out, v);
+        }
+        escape(&ss);
+    }
+}
+
+template<class Code>
+inline void read_bench(benchpress::context* ctx) {
+    const std::string data = encode<Code>();
+    uint64_t sum = 0;
+
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        Input input(data);
+        BitIStream in(input);
+        for(size_t j = 0; j < N_VALUES; ++j) sum += Code::read(in);
+        escape(&sum);
+    }
+}
+
+BENCHMARK("write::bitwise", write_bench<BitwiseInt>)
+BENCHMARK("write::int", write_bench<Int>)
+BENCHMARK("write::unary", write_bench<Unary>)
+BENCHMARK("write::gamma", write_bench<Gamma>)
+BENCHMARK("write::delta", write_bench<Delta>)
+
+BENCHMARK("read::bitwise", read_bench<BitwiseInt>)
+BENCHMARK("read::int", read_bench<Int>)
+BENCHMARK("read::unary", read_bench<Unary>)
+BENCHMARK("read::gamma", read_bench<Gamma>)
+BENCHMARK("read::delta", read_bench<Delta>)
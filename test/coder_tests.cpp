@@ -16,6 +16,8 @@
 #include <tudocomp/coders/SLECoder.hpp>
 #include <tudocomp/coders/ArithmeticCoder.hpp>
 #include <tudocomp/coders/TernaryCoder.hpp>
+#include <tudocomp/coders/TANSCoder.hpp>
+#include <tudocomp/coders/RANSCoder.hpp>
 
 using namespace tdc;
 
@@ -226,3 +228,14 @@ TEST(coder, ternary_bits) { test_bits<TernaryCoder>(); }
 TEST(coder, ternary_int) { test_int<TernaryCoder>(); }
 TEST(coder, ternary_str) { test_str<TernaryCoder>(); }
 TEST(coder, ternary_mixed) { test_mixed<TernaryCoder>(); }
+
+// huff_streams and tans code the literals in advance, so they only support
+// encoding exactly the literals they are given
+TEST(coder, huff_streams_str) { test_str<HuffmanStreamsCoder>(); }
+TEST(coder, tans_str) { test_str<TANSCoder>(); }
+
+TEST(coder, rans_mt) { test_mt<RANSCoder>(); }
+TEST(coder, rans_bits) { test_bits<RANSCoder>(); }
+TEST(coder, rans_int) { test_int<RANSCoder>(); }
+TEST(coder, rans_str) { test_str<RANSCoder>(); }
+TEST(coder, rans_mixed) { test_mixed<RANSCoder>(); }
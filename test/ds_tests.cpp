@@ -11,6 +11,9 @@
 #include <tudocomp/ds/bwt.hpp>
 #include <tudocomp/ds/SparseISA.hpp>
 #include <tudocomp/ds/CompressedLCP.hpp>
+#include <tudocomp/ds/SAPrefixDoubling.hpp>
+#include <tudocomp/ds/SAInducedSorting.hpp>
+#include <tudocomp/ds/SASemiExternal.hpp>
 #include <tudocomp/CreateAlgorithm.hpp>
 #include "test/util.hpp"
 
@@ -160,3 +163,297 @@ using textds_comp_lcp_t = TextDS<
 
 TEST(ds, comp_lcp_LCP)         { TEST_DS_STRINGCOLLECTION(textds_comp_lcp_t, test_lcp); }
 TEST(ds, comp_lcp_Integration) { TEST_DS_STRINGCOLLECTION(textds_comp_lcp_t, test_all_ds); }
+
+using textds_doubling_t = TextDS<SAPrefixDoubling>;
+
+TEST(ds, doubling_SA)          { TEST_DS_STRINGCOLLECTION(textds_doubling_t, test_sa); }
+TEST(ds, doubling_Integration) { TEST_DS_STRINGCOLLECTION(textds_doubling_t, test_all_ds); }
+
+TEST(ds, doubling_threads) {
+    // texts large enough for groups to be sorted by all threads
+    std::vector<std::string> texts;
+    texts.push_back(std::string(200000, 'a'));
+    const std::string text = test::number_text(300000, 1000);
+    texts.push_back(text);
+    texts.push_back(text + text);
+
+    for(const auto& str : texts) {
+        test::TestInput input = test::compress_input(str);
+        InputView in = input.as_view();
+        auto expected = create_algo<TextDS<>>("", in);
+        for(const std::string threads : {"1", "3", "8"}) {
+            for(const std::string compress : {"delayed", "compressed", "none"}) {
+                auto t = create_algo<textds_doubling_t>(
+                    "sa = doubling(threads = " + threads + "), compress = \"" + compress + "\"", in);
+                auto& sa = t.require_sa();
+                auto& sa_expected = expected.require_sa();
+                ASSERT_EQ(sa.size(), sa_expected.size());
+                for(size_t i = 0; i < sa.size(); ++i) {
+                    ASSERT_EQ(sa[i], sa_expected[i]) << "i=" << i << ", threads=" << threads;
+                }
+            }
+        }
+    }
+}
+
+using textds_sais_t = TextDS<SAInducedSorting>;
+
+TEST(ds, sais_SA)          { TEST_DS_STRINGCOLLECTION(textds_sais_t, test_sa); }
+TEST(ds, sais_Integration) { TEST_DS_STRINGCOLLECTION(textds_sais_t, test_all_ds); }
+
+TEST(ds, sais_compress) {
+    // texts with several levels of recursion
+    std::vector<std::string> texts;
+    texts.push_back(std::string(100000, 'a'));
+    const std::string text = test::number_text(200000, 997);
+    texts.push_back(text);
+    texts.push_back(text + text);
+
+    for(const auto& str : texts) {
+        test::TestInput input = test::compress_input(str);
+        InputView in = input.as_view();
+        auto expected = create_algo<TextDS<>>("", in);
+        for(const std::string compress : {"delayed", "compressed", "none"}) {
+            auto t = create_algo<textds_sais_t>("compress = \"" + compress + "\"", in);
+            auto& sa = t.require_sa();
+            auto& sa_expected = expected.require_sa();
+            ASSERT_EQ(sa.size(), sa_expected.size());
+            for(size_t i = 0; i < sa.size(); ++i) {
+                ASSERT_EQ(sa[i], sa_expected[i]) << "i=" << i << ", compress=" << compress;
+            }
+        }
+    }
+}
+
+using textds_semi_external_t = TextDS<SASemiExternal>;
+
+TEST(ds, semi_external_SA)          { TEST_DS_STRINGCOLLECTION(textds_semi_external_t, test_sa); }
+TEST(ds, semi_external_Integration) { TEST_DS_STRINGCOLLECTION(textds_semi_external_t, test_all_ds); }
+
+TEST(ds, semi_external_batches) {
+    std::vector<std::string> texts;
+    texts.push_back(std::string(100000, 'a'));
+    const std::string text = test::number_text(200000, 997);
+    texts.push_back(text);
+    texts.push_back(text + text);
+
+    for(const auto& str : texts) {
+        test::TestInput input = test::compress_input(str);
+        InputView in = input.as_view();
+        auto expected = create_algo<TextDS<>>("", in);
+        auto& sa_expected = expected.require_sa();
+
+        // budgets for a single batch, and for batches of parts of buckets
+        for(const std::string budget : {"1073741824", "65536"}) {
+            for(const std::string period : {"4", "256"}) {
+                for(const std::string threads : {"1", "4"}) {
+                    const std::string options = "sa = semi_external(budget = " + budget +
+                        ", period = " + period + ", threads = " + threads + ")";
+                    auto t = create_algo<textds_semi_external_t>(options, in);
+                    auto& sa = t.require_sa();
+                    ASSERT_EQ(sa.size(), sa_expected.size());
+                    for(size_t i = 0; i < sa.size(); ++i) {
+                        ASSERT_EQ(sa[i], sa_expected[i]) << "i=" << i << ", " << options;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(ds, semi_external_budget) {
+    // DNA has few buckets, each larger than the buffer
+    const std::string str = test::random_text(50000, "ACGT");
+
+    test::TestInput input = test::compress_input(str);
+    InputView in = input.as_view();
+    auto expected = create_algo<TextDS<>>("", in);
+    auto& sa_expected = expected.require_sa();
+
+    const size_t buffer = 1000;
+    for(size_t threads : {1, 3}) {
+        semi_external::Sorter<uint32_t> sorter(in, 16, threads);
+        std::vector<uint32_t> sa;
+        size_t batches = 0;
+        sorter.sort(buffer, [&](size_t offset, const std::vector<uint32_t>& batch) {
+            ASSERT_EQ(offset, sa.size());
+            ASSERT_LE(batch.size(), buffer);
+            sa.insert(sa.end(), batch.begin(), batch.end());
+            ++batches;
+        });
+
+        ASSERT_GE(batches, in.size() / buffer);
+        ASSERT_EQ(sa.size(), sa_expected.size());
+        for(size_t i = 0; i < sa.size(); ++i) {
+            ASSERT_EQ(sa[i], sa_expected[i]) << "i=" << i << ", threads=" << threads;
+        }
+    }
+}
+
+TEST(ds, threads_Integration) {
+    // large enough for blocked writes and several PLCP chunks
+    const std::string str = test::random_number_text(300000, 1000);
+    test::TestInput input = test::compress_input(str);
+    InputView in = input.as_view();
+
+    for(const std::string threads : {"1", "3", "8"}) {
+        for(const std::string compress : {"delayed", "compressed", "none"}) {
+            auto t = create_algo<TextDS<>>(
+                "phi = from_sa(threads = " + threads + "), "
+                "plcp = from_phi(threads = " + threads + "), "
+                "isa = from_sa(threads = " + threads + "), "
+                "compress = \"" + compress + "\"", in);
+            test_lcp(str, t);
+            test_isa(str, t);
+        }
+    }
+}
+
+TEST(ds, cache) {
+    const std::string str = test::random_number_text(50000, 100, 7);
+    test::TestInput input = test::compress_input(str);
+    InputView in = input.as_view();
+
+    test::create_test_directory();
+    const std::string cache = "cache = \"" + test::TEST_FILE_PATH + "\"";
+
+    // the first round may or may not find the data structures in the cache,
+    // the second round finds all of them
+    for(size_t round = 0; round < 2; ++round) {
+        for(const std::string compress : {"delayed", "compressed", "none"}) {
+            const std::string options = cache + ", compress = \"" + compress + "\"";
+            auto t = create_algo<TextDS<>>(options, in);
+            t.require(TextDS<>::SA | TextDS<>::LCP | TextDS<>::ISA);
+            test_all_ds(str, t);
+            ASSERT_EQ(t.require_lcp().max_lcp(), t.require_plcp().max_lcp());
+
+            auto t_comp_lcp = create_algo<textds_comp_lcp_t>(options, in);
+            test_all_ds(str, t_comp_lcp);
+        }
+    }
+}
+
+TEST(ds, external) {
+    test::create_test_directory();
+
+    {
+        auto storage = MappedStorage::external(test::TEST_FILE_PATH);
+        DynamicIntVector outer;
+        {
+            MappedStorage::Scope scope(storage);
+            DynamicIntVector iv(100000, 0, 33);
+            for(size_t i = 0; i < iv.size(); ++i) iv[i] = i * 12345;
+            ASSERT_GE(storage->size(), iv.bit_size() / 8);
+
+            // copies keep their storage, the scope only affects construction
+            outer = DynamicIntVector(10, 0, 7);
+            DynamicIntVector copy = iv;
+            for(size_t i = 0; i < iv.size(); ++i) ASSERT_EQ(uint64_t(copy[i]), i * 12345 % (1ULL << 33));
+        }
+        ASSERT_NE(MappedStorage::current(), storage);
+        ASSERT_GT(storage->size(), 0U); // held by outer
+        outer = DynamicIntVector();
+        ASSERT_EQ(storage->size(), 0U);
+    }
+
+    const std::string str = test::random_number_text(50000, 100, 5);
+    test::TestInput input = test::compress_input(str);
+    InputView in = input.as_view();
+
+    const std::string dir = "external_dir = \"" + test::TEST_FILE_PATH + "\"";
+    for(const std::string external : {"sa,lcp", "all"}) {
+        for(const std::string compress : {"delayed", "compressed", "none"}) {
+            const std::string options = dir + ", external = \"" + external +
+                "\", compress = \"" + compress + "\"";
+            auto t = create_algo<TextDS<>>(options, in);
+            t.require(TextDS<>::SA | TextDS<>::LCP | TextDS<>::ISA);
+            test_all_ds(str, t);
+
+            auto t_comp_lcp = create_algo<textds_comp_lcp_t>(options, in);
+            test_all_ds(str, t_comp_lcp);
+        }
+    }
+}
+
+TEST(ds, huge_pages) {
+    {
+        auto storage = MappedStorage::huge_pages();
+        MappedStorage::Scope scope(storage);
+
+        // small vectors stay on the heap
+        DynamicIntVector small(100, 0, 33);
+        ASSERT_EQ(storage->size(), 0U);
+
+        DynamicIntVector iv(1 << 20, 0, 33);
+        for(size_t i = 0; i < iv.size(); ++i) iv[i] = i * 12345;
+        ASSERT_GE(storage->size(), iv.bit_size() / 8);
+        ASSERT_EQ(storage->size() % io::MMap::huge_pagesize(), 0U);
+        ASSERT_LE(storage->huge_page_bytes(), storage->size());
+
+        DynamicIntVector copy = iv;
+        for(size_t i = 0; i < iv.size(); ++i) ASSERT_EQ(uint64_t(copy[i]), i * 12345 % (1ULL << 33));
+    }
+
+    const std::string str = test::random_number_text(50000, 100, 7);
+    test::TestInput input = test::compress_input(str);
+    InputView in = input.as_view();
+
+    for(const std::string huge_pages : {"sa,isa", "all"}) {
+        for(const std::string compress : {"delayed", "none"}) {
+            const std::string options = "huge_pages = \"" + huge_pages +
+                "\", compress = \"" + compress + "\"";
+            auto t = create_algo<TextDS<>>(options, in);
+            t.require(TextDS<>::SA | TextDS<>::LCP | TextDS<>::ISA);
+            test_all_ds(str, t);
+        }
+    }
+}
+
+template<typename textds_t>
+void test_mem_budget(const std::string& str) {
+    using sa_t = typename textds_t::sa_type;
+
+    test::TestInput input = test::compress_input(str);
+    InputView in = input.as_view();
+
+    const size_t n = str.size() + 1;
+    const ds::dsflags_t flags = ds::SA | ds::ISA | ds::LCP;
+
+    ASSERT_EQ(ds::plan_compress_mode<sa_t>(n, flags, SIZE_MAX), CompressMode::plain);
+    ASSERT_EQ(ds::plan_compress_mode<sa_t>(n, flags, 1), CompressMode::compressed);
+
+    for(auto cm : { CompressMode::plain, CompressMode::coherent_delayed,
+                    CompressMode::delayed, CompressMode::compressed }) {
+        const size_t budget = ds::estimate_peak<sa_t>(n, flags, cm);
+        const CompressMode planned = ds::plan_compress_mode<sa_t>(n, flags, budget);
+        ASSERT_LE(ds::estimate_peak<sa_t>(n, flags, planned), budget);
+
+        auto t = create_algo<textds_t>(
+            "mem_budget = " + std::to_string(budget), in);
+        t.require(flags);
+        test_sa(str, t);
+        test_lcp(str, t);
+        test_isa(str, t);
+    }
+
+    // an explicit compress mode is kept
+    auto t = create_algo<textds_t>("compress = \"plain\", mem_budget = 1", in);
+    t.require(ds::SA);
+    ASSERT_GT(t.require_sa().width(), bits_for(n));
+}
+
+TEST(ds, mem_budget) {
+    const std::string str = test::random_number_text(100000, 1000, 3);
+    test_mem_budget<textds_default_t>(str);
+    test_mem_budget<textds_sais_t>(str);
+    test_mem_budget<textds_doubling_t>(str);
+
+    // the semi-external construction is not planned
+    test::TestInput input = test::compress_input(str);
+    InputView in = input.as_view();
+    auto t = create_algo<textds_semi_external_t>("mem_budget = 1", in);
+    t.require(ds::SA | ds::ISA | ds::LCP);
+    test_sa(str, t);
+    test_lcp(str, t);
+    test_isa(str, t);
+}
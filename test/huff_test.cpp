@@ -4,7 +4,10 @@
 #include <cstring>
 #include <bitset>
 #include <algorithm>
+#include <random>
 #include <tudocomp/coders/HuffmanCoder.hpp>
+#include <tudocomp/compressors/LiteralEncoder.hpp>
+#include <tudocomp/compressors/LZSSLCPCompressor.hpp>
 
 using namespace tdc;
 
@@ -38,10 +41,10 @@ void test_huffmantable_storing(const std::string& text) {
 	delete [] ordered_codelengths2;
 }
 
-void test_huffmantable_coding(const std::string& text) {
+void test_huffmantable_coding(const std::string& text, const uint8_t max_length = 0) {
 	using namespace tdc::huff;
 	if(text.length() <=  1) return;
-	extended_huffmantable table = gen_huffmantable(text);
+	extended_huffmantable table = gen_huffmantable(text, max_length);
 	//encode
 	std::stringstream input(text);
 	std::stringstream output;
@@ -138,6 +141,146 @@ TEST(huffman, stringgenerators) {
 //
 // }
 
+/// text in which the i-th character occurs fib(i) times, yielding a Huffman code with codewords of length 1 to n-1
+std::string fibonacci_frequencies(const size_t n) {
+	std::string text;
+	size_t a = 1, b = 1;
+	for(size_t i = 0; i < n; ++i) {
+		text.append(a, char('A' + i));
+		const size_t c = a + b;
+		a = b;
+		b = c;
+	}
+	std::mt19937 rng(n);
+	std::shuffle(text.begin(), text.end(), rng);
+	return text;
+}
+
+TEST(huff, long_codewords) {
+	using namespace tdc::huff;
+	// codewords of up to 24 bits are decoded via two levels of secondary tables
+	for(const size_t n : {12, 20, 25}) {
+		const std::string text = fibonacci_frequencies(n);
+		{
+			extended_huffmantable table = gen_huffmantable(text);
+			ASSERT_EQ(table.longest, n - 1);
+		}
+		test_huff(text);
+	}
+}
+
+TEST(huff, limit_codelengths) {
+	using namespace tdc::huff;
+	std::mt19937 rng(42);
+	for(size_t n = 2; n <= 7; ++n) {
+		for(size_t round = 0; round < 20; ++round) {
+			std::vector<size_t> weights(n);
+			for(auto& w : weights) w = 1 + (rng() % 2 ? rng() % 1000 : rng() % 4);
+
+			for(uint8_t max_length = bits_for(n - 1); max_length <= 5; ++max_length) {
+				std::vector<uint8_t> lengths(n);
+				limit_codelengths(weights.data(), n, max_length, lengths.data());
+
+				size_t cost = 0;
+				uint64_t kraft = 0;
+				for(size_t i = 0; i < n; ++i) {
+					ASSERT_GE(lengths[i], 1);
+					ASSERT_LE(lengths[i], max_length);
+					cost += weights[i] * lengths[i];
+					kraft += 1ULL << (max_length - lengths[i]);
+				}
+				ASSERT_EQ(kraft, 1ULL << max_length);
+
+				// the cost is minimal among all codes respecting max_length
+				size_t best = SIZE_MAX;
+				std::vector<uint8_t> l(n, 1);
+				while(true) {
+					uint64_t k = 0;
+					size_t c = 0;
+					for(size_t i = 0; i < n; ++i) {
+						k += 1ULL << (max_length - l[i]);
+						c += weights[i] * l[i];
+					}
+					if(k <= (1ULL << max_length)) best = std::min(best, c);
+
+					size_t i = 0;
+					while(i < n && l[i] == max_length) l[i++] = 1;
+					if(i == n) break;
+					++l[i];
+				}
+				ASSERT_EQ(cost, best) << "n = " << n << ", max_length = " << size_t(max_length);
+			}
+		}
+	}
+}
+
+TEST(huff, max_length) {
+	using namespace tdc::huff;
+	const std::string text = fibonacci_frequencies(25);
+	for(const uint8_t max_length : {5, 8, 11, 16}) {
+		{
+			extended_huffmantable table = gen_huffmantable(text, max_length);
+			ASSERT_EQ(table.longest, max_length);
+		}
+		test_huffmantable_coding(text, max_length);
+	}
+	// too small limits are raised to the least possible length
+	{
+		extended_huffmantable table = gen_huffmantable(text, 2);
+		ASSERT_EQ(table.longest, 5);
+	}
+	test_huffmantable_coding(text, 2);
+}
+
+void test_huffman_streams(const std::string& text, const size_t streams) {
+	using namespace tdc::huff;
+	const std::vector<uliteral_t> literals(text.begin(), text.end());
+	std::stringstream ss;
+	{
+		extended_huffmantable table = gen_huffmantable(text);
+		tdc::io::Output out(ss);
+		tdc::io::BitOStream bit_os(out);
+		huffmantable_encode(bit_os, table);
+		huffman_encode_streams(literals, bit_os, table, streams);
+	}
+	tdc::io::Input in(ss);
+	tdc::io::BitIStream bit_in(in);
+	const huffmantable table = huffmantable_decode(bit_in);
+	const uint8_t*const ordered_codelengths = gen_ordered_codelength(table.alphabet_size, table.numl, table.longest);
+	const DecodeTable decode_table(table.ordered_map_from_effective, ordered_codelengths, table.alphabet_size, table.numl, table.longest);
+	delete [] ordered_codelengths;
+
+	ASSERT_EQ(huffman_decode_streams(bit_in, decode_table, streams), literals) << "streams = " << streams;
+	ASSERT_TRUE(bit_in.eof());
+}
+
+TEST(huff, streams) {
+	for(const std::string& text : { fibonacci_frequencies(25), std::string("abcabacba"), std::string("ab") }) {
+		for(size_t streams = 1; streams <= 5; ++streams) {
+			test_huffman_streams(text, streams);
+		}
+	}
+}
+
+// streams of a few bytes, whose readers refill from the padding after the last stream (meant to run with ASan)
+TEST(huff, short_streams) {
+	const std::string alphabet = "abacabadabacabaeabacabadabacabaf";
+	for(size_t n = 2; n <= alphabet.size(); ++n) {
+		for(size_t streams = 1; streams <= 9; ++streams) {
+			test_huffman_streams(alphabet.substr(0, n), streams);
+		}
+	}
+}
+
+TEST(huff, coder_streams) {
+	const std::string text = fibonacci_frequencies(20);
+	for(const std::string streams : {"2", "4", "7"}) {
+		test::compress<LiteralEncoder<HuffmanStreamsCoder>>(text, "coder = huff_streams(streams = " + streams + ")").assert_decompress();
+		test::compress<LZSSLCPCompressor<HuffmanStreamsCoder>>(text, "coder = huff_streams(streams = " + streams + ")").assert_decompress();
+		test::compress<LiteralEncoder<HuffmanStreamsCoder>>("aaaa", "coder = huff_streams(streams = " + streams + ")").assert_decompress();
+	}
+}
+
 TEST(huff, nullbyte) {
     test_huff("hel\0lo"_v);
     test_huff("hello\0"_v);
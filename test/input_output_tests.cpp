@@ -2,11 +2,13 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 
 #include <gtest/gtest.h>
 #include <glog/logging.h>
 
+#include <tudocomp/io/BoundedPipe.hpp>
 #include <tudocomp/io/Input.hpp>
 #include <tudocomp/io/Output.hpp>
 
@@ -708,3 +710,85 @@ TEST(OnputMatrix, FileTrgt_OutDriverSplit) {
 TEST(OnputMatrix, StreamTrgt_OutDriverSplit) {
     o_matrix_test<StreamTrgt, OutDriverSplit>();
 }
+
+TEST(Input, single_pass_stream) {
+    {
+        // streaming reads the stream directly
+        std::stringstream ss("abcdef");
+        auto i = Input::single_pass(ss);
+        {
+            auto is = i.as_stream();
+            std::stringstream out;
+            out << is.rdbuf();
+            ASSERT_EQ(out.str(), "abcdef");
+        }
+        ASSERT_THROW(i.as_view(), std::runtime_error);
+    }
+    {
+        // restrictions are applied on the fly
+        std::stringstream ss;
+        ss << STREAMBUF_ORIGINAL;
+        auto i = Input(Input::single_pass(ss),
+            InputRestrictions({0, 0xff}, true));
+        auto is = i.as_stream();
+        std::stringstream out;
+        out << is.rdbuf();
+        auto sss = out.str();
+        check(View(sss), STREAMBUF_ESCAPED_NTE);
+    }
+    {
+        // random access buffers the stream first
+        std::stringstream ss("abcdef");
+        auto i = Input::single_pass(ss);
+        ASSERT_EQ(i.size(), 6u);
+        input_equal(i, "abcdef");
+        input_equal(i, "abcdef");
+    }
+}
+
+TEST(BoundedPipe, transfer) {
+    for(size_t capacity : { 1, 7, 4096 }) {
+        std::string text;
+        for(size_t i = 0; i < 100000; ++i) {
+            text.push_back(char(i * 31 + i / 1000));
+        }
+
+        BoundedPipe pipe(capacity);
+        std::thread writer([&] {
+            PipeOStreamBuf buf(pipe, 13);
+            std::ostream os(&buf);
+            os.write(text.data(), text.size() / 2);
+            ASSERT_EQ(size_t(os.tellp()), text.size() / 2);
+            for(size_t i = text.size() / 2; i < text.size(); ++i) {
+                os.put(text[i]);
+            }
+        });
+        std::thread closer([&] {
+            writer.join();
+            pipe.close_write();
+        });
+
+        PipeIStreamBuf buf(pipe, 5);
+        std::istream is(&buf);
+        std::stringstream out;
+        out << is.rdbuf();
+        closer.join();
+
+        ASSERT_EQ(out.str(), text);
+    }
+}
+
+TEST(BoundedPipe, close_read) {
+    // the writer must not block once the reader has given up
+    BoundedPipe pipe(4);
+    std::thread writer([&] {
+        std::vector<uint8_t> data(1000, 'x');
+        pipe.write(data.data(), data.size());
+        pipe.close_write();
+    });
+
+    uint8_t c;
+    ASSERT_EQ(pipe.read(&c, 1), 1u);
+    pipe.close_read();
+    writer.join();
+}
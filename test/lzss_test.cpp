@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <sstream>
+
 #include <tudocomp/Compressor.hpp>
 #include <tudocomp/Generator.hpp>
 #include <tudocomp/CreateAlgorithm.hpp>
@@ -7,11 +9,23 @@
 #include <tudocomp/compressors/lzss/LZSSCoding.hpp>
 #include <tudocomp/compressors/lzss/LZSSFactors.hpp>
 #include <tudocomp/compressors/lzss/LZSSLiterals.hpp>
+#include <tudocomp/compressors/lzss/LZSSLPF.hpp>
+#include <tudocomp/compressors/lzss/LZSSMatchFinder.hpp>
+#include <tudocomp/compressors/lzss/LZSSWindowBuffer.hpp>
+#include <tudocomp/compressors/LCPCompressor.hpp>
+#include <tudocomp/compressors/LZSSLCPCompressor.hpp>
+#include <tudocomp/compressors/LZSSSlidingWindowCompressor.hpp>
+#include <tudocomp/coders/ASCIICoder.hpp>
+#include <tudocomp/coders/BitCoder.hpp>
+#include <tudocomp/coders/EliasGammaCoder.hpp>
+#include <tudocomp/coders/HuffmanCoder.hpp>
 
 #include <tudocomp/compressors/lcpcomp/decompress/CompactDec.hpp>
 #include <tudocomp/compressors/lcpcomp/decompress/DecodeQueueListBuffer.hpp>
 #include <tudocomp/compressors/lcpcomp/decompress/MultiMapBuffer.hpp>
 
+#include "test/util.hpp"
+
 using namespace tdc;
 
 TEST(lzss, factor_buffer_empty) {
@@ -58,6 +72,59 @@ TEST(lzss, factor_buffer_sort) {
     }
 }
 
+static void factor_buffer_sort_check(bool compact, size_t threads) {
+    // pseudo-random positions with many duplicates, to check stability
+    const size_t n = 50000;
+    lzss::FactorBuffer buf(3 * n, compact);
+    std::vector<lzss::Factor> ref;
+
+    uint32_t seed = 3;
+    for(size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245U + 12345U;
+        const len_t pos = (seed >> 8) % (3 * n);
+        buf.emplace_back(pos, i, 1 + i % 100);
+        ref.emplace_back(pos, i, 1 + i % 100);
+    }
+    buf.shrink_to_fit();
+    ASSERT_EQ(compact, buf.is_compact());
+    ASSERT_EQ(1, buf.shortest_factor());
+    ASSERT_EQ(100, buf.longest_factor());
+
+    buf.sort(threads);
+    ASSERT_TRUE(buf.is_sorted());
+
+    std::stable_sort(ref.begin(), ref.end(),
+        [](const lzss::Factor& a, const lzss::Factor& b) { return a.pos < b.pos; });
+
+    ASSERT_EQ(n, buf.size());
+    size_t i = 0;
+    for(auto f : buf) {
+        ASSERT_EQ(len_t(ref[i].pos), len_t(f.pos));
+        ASSERT_EQ(len_t(ref[i].src), len_t(f.src));
+        ASSERT_EQ(len_t(ref[i].len), len_t(f.len));
+        ++i;
+    }
+}
+
+TEST(lzss, factor_buffer_radix_sort) {
+    factor_buffer_sort_check(false, 1);
+    factor_buffer_sort_check(false, 4);
+}
+
+TEST(lzss, factor_buffer_compact) {
+    factor_buffer_sort_check(true, 1);
+    factor_buffer_sort_check(true, 4);
+}
+
+TEST(lzss, factor_buffer_width) {
+    // the fields are narrowed to the width required by the text length
+    ASSERT_EQ(3U * 32, lzss::FactorBuffer(1000, false).factor_bits());
+    ASSERT_EQ(3U * std::min<size_t>(INDEX_BITS, 40),
+        lzss::FactorBuffer(size_t(1) << 35, false).factor_bits());
+    ASSERT_EQ(3U * INDEX_BITS, lzss::FactorBuffer().factor_bits());
+    ASSERT_EQ(0U, lzss::FactorBuffer(1000, true).factor_bits());
+}
+
 TEST(lzss, text_literals_empty) {
     lzss::FactorBuffer empty;
     std::string tmp = "";
@@ -208,3 +275,258 @@ TEST(lzss, decode_forward_ql_buffer_chain) {
 TEST(lzss, decode_forward_ql_buffer_multiref) {
     test_forward_decode_buffer_multiref<lcpcomp::DecodeForwardQueueListBuffer>();
 }
+
+static std::vector<std::string> lpf_test_texts() {
+    std::vector<std::string> texts;
+    test::roundtrip_batch([&](const View& s) {
+        texts.push_back(std::string(s));
+    });
+
+    // highly repetitive inputs, where scanning degenerates
+    texts.push_back(std::string(300, 'a'));
+    std::string fib_a = "a", fib_b = "ab";
+    while(fib_b.size() < 500) {
+        std::string next = fib_b + fib_a;
+        fib_a = fib_b;
+        fib_b = next;
+    }
+    texts.push_back(fib_b);
+    return texts;
+}
+
+TEST(lzss, lpf) {
+    for(auto text : lpf_test_texts()) {
+        text.push_back(0);
+        const len_t n = text.size();
+
+        auto lce = [&](len_t i, len_t j) {
+            len_t l = 0;
+            while(i + l < n && j + l < n && text[i + l] == text[j + l]) ++l;
+            return l;
+        };
+
+        // naive SA and LCP
+        std::vector<len_t> sa(n);
+        for(len_t i = 0; i < n; ++i) sa[i] = i;
+        std::sort(sa.begin(), sa.end(), [&](len_t a, len_t b) {
+            return text.compare(a, std::string::npos, text, b, std::string::npos) < 0;
+        });
+        std::vector<len_t> lcp(n, 0);
+        for(len_t r = 1; r < n; ++r) lcp[r] = lce(sa[r - 1], sa[r]);
+
+        lzss::LPF lpf(sa, lcp, n);
+        ASSERT_EQ(n, lpf.size());
+
+        for(len_t i = 0; i < n; ++i) {
+            len_t expected = 0;
+            for(len_t j = 0; j < i; ++j) expected = std::max(expected, lce(i, j));
+
+            ASSERT_EQ(expected, lpf.len(i)) << "at position " << i;
+            if(expected > 0) {
+                ASSERT_LT(lpf.src(i), i);
+                ASSERT_EQ(expected, lce(i, lpf.src(i)));
+            }
+        }
+    }
+}
+
+template<typename coder_t>
+static void lcp_parse_roundtrip() {
+    using compressor_t = LZSSLCPCompressor<coder_t>;
+    for(auto& text : lpf_test_texts()) {
+        for(auto parse : { "greedy", "lazy", "optimal" }) {
+            test::compress<compressor_t>(text,
+                std::string("parse = \"") + parse + "\""
+            ).assert_decompress();
+        }
+    }
+}
+
+TEST(lzss, lcp_parse_ascii) {
+    lcp_parse_roundtrip<ASCIICoder>();
+}
+
+TEST(lzss, lcp_parse_bit) {
+    lcp_parse_roundtrip<BitCoder>();
+}
+
+TEST(lzss, lcp_parse_gamma) {
+    lcp_parse_roundtrip<EliasGammaCoder>();
+}
+
+TEST(lzss, lcp_parse_huff) {
+    lcp_parse_roundtrip<HuffmanCoder>();
+}
+
+TEST(lzss, lcp_parse_optimal_size) {
+    // many short repetitions with single mismatches, where greedy parsing
+    // leaves isolated literals
+    std::string text;
+    uint32_t seed = 7;
+    while(text.size() < 20000) {
+        seed = seed * 1103515245U + 12345U;
+        if(seed % 3 != 0 && text.size() > 100) {
+            text += text.substr(text.size() - 1 - seed % 100, 3 + seed % 7);
+        } else {
+            text.push_back('a' + (seed >> 16) % 4);
+        }
+    }
+
+    auto greedy = test::compress<LZSSLCPCompressor<BitCoder>>(text, "parse = \"greedy\"");
+    auto optimal = test::compress<LZSSLCPCompressor<BitCoder>>(text, "parse = \"optimal\"");
+    ASSERT_LE(optimal.str.size(), greedy.str.size());
+    optimal.assert_decompress();
+
+    auto greedy_gamma = test::compress<LZSSLCPCompressor<EliasGammaCoder>>(text, "parse = \"greedy\"");
+    auto optimal_gamma = test::compress<LZSSLCPCompressor<EliasGammaCoder>>(text, "parse = \"optimal\"");
+    ASSERT_LE(optimal_gamma.str.size(), greedy_gamma.str.size());
+    optimal_gamma.assert_decompress();
+}
+
+TEST(lzss, lcpcomp_compact_factors) {
+    using compressor_t = LCPCompressor<ASCIICoder, lcpcomp::ArraysComp, lcpcomp::ScanDec>;
+    for(auto& text : lpf_test_texts()) {
+        // the storage of factors does not affect the output
+        auto plain = test::compress<compressor_t>(text, "");
+        auto compact = test::compress<compressor_t>(text,
+            "compact_factors = 1, sort_threads = 2");
+        ASSERT_EQ(plain.str, compact.str);
+        compact.assert_decompress();
+    }
+}
+
+TEST(lzss, factor_buffer_flatten_depth) {
+    // text "abababba": the second factor refers to the first, the third one
+    // overlaps both
+    for(bool compact : { false, true }) {
+        lzss::FactorBuffer buf(8, compact);
+        buf.emplace_back(2, 0, 2);
+        buf.emplace_back(4, 2, 2);
+        buf.emplace_back(6, 3, 2);
+        ASSERT_EQ(3, buf.depth());
+
+        buf.flatten(2);
+        ASSERT_EQ(0, len_t(buf[0].src));
+        ASSERT_EQ(0, len_t(buf[1].src));
+        ASSERT_EQ(3, len_t(buf[2].src));
+        ASSERT_EQ(2, buf.depth(3));
+
+        // both positions of the third factor exceed depth one
+        ASSERT_EQ(2, buf.bound_depth(1, 1));
+        ASSERT_EQ(2, buf.size());
+        ASSERT_EQ(1, buf.depth());
+        ASSERT_EQ(0, buf.bound_depth(1, 1));
+    }
+}
+
+static void lcpcomp_max_depth_check(const std::string& text) {
+    using compressor_t = LCPCompressor<ASCIICoder, lcpcomp::ArraysComp, lcpcomp::ScanDec>;
+
+    // flattening is independent of the amount of threads
+    auto flat = test::compress<compressor_t>(text, "");
+    auto flat_parallel = test::compress<compressor_t>(text, "flatten_threads = 3");
+    ASSERT_EQ(flat.str, flat_parallel.str);
+    flat_parallel.assert_decompress();
+
+    for(auto max_depth : { "1", "2", "5" }) {
+        test::compress<compressor_t>(text,
+            std::string("max_depth = ") + max_depth
+        ).assert_decompress();
+        test::compress<compressor_t>(text,
+            std::string("flatten = 0, max_depth = ") + max_depth
+        ).assert_decompress();
+    }
+}
+
+TEST(lzss, lcpcomp_max_depth) {
+    for(auto& text : lpf_test_texts()) {
+        lcpcomp_max_depth_check(text);
+    }
+}
+
+TEST(lzss, lcp_factorize_lpf) {
+    using compressor_t = LZSSLCPCompressor<ASCIICoder>;
+    for(auto& text : lpf_test_texts()) {
+        // both strategies pick the same factors
+        auto scan = test::compress<compressor_t>(text, "factorize = \"scan\"");
+        auto lpf = test::compress<compressor_t>(text, "factorize = \"lpf\"");
+        ASSERT_EQ(scan.str, lpf.str);
+        lpf.assert_decompress();
+    }
+}
+
+template<typename finder_t>
+static void window_finder_exact(const std::string& text, size_t window,
+                                size_t lookahead, size_t min_len) {
+    std::istringstream in(text);
+    lzss::WindowBuffer buf(in, window, lookahead);
+    buf.fill(0);
+    ASSERT_EQ(text.size(), buf.end());
+
+    lzss::NaiveMatchFinder naive(buf, window, 0, min_len);
+    finder_t finder(buf, window, window + 1, min_len);
+
+    for(size_t p = 0; p < text.size(); ++p) {
+        const size_t max_len = std::min(lookahead, text.size() - p);
+        auto expected = naive.find(p, max_len);
+        auto m = finder.find(p, max_len);
+
+        if(expected.len >= min_len) {
+            ASSERT_EQ(expected.len, m.len) << "at position " << p;
+        } else {
+            ASSERT_LE(m.len, expected.len) << "at position " << p;
+        }
+        if(m.len > 0) {
+            ASSERT_LT(m.src, p);
+            ASSERT_LE(p - m.src, window);
+            ASSERT_EQ(0, text.compare(m.src, m.len, text, p, m.len));
+        }
+    }
+}
+
+TEST(lzss, window_finder_hash) {
+    for(auto& text : lpf_test_texts()) {
+        window_finder_exact<lzss::HashChainMatchFinder>(text, 32, 32, 3);
+        window_finder_exact<lzss::HashChainMatchFinder>(text, 1000, 10, 1);
+    }
+}
+
+TEST(lzss, window_finder_bt) {
+    for(auto& text : lpf_test_texts()) {
+        window_finder_exact<lzss::BinaryTreeMatchFinder>(text, 32, 32, 3);
+        window_finder_exact<lzss::BinaryTreeMatchFinder>(text, 1000, 10, 1);
+    }
+}
+
+TEST(lzss, sliding_window_finders) {
+    using compressor_t = LZSSSlidingWindowCompressor<ASCIICoder>;
+
+    auto texts = lpf_test_texts();
+
+    // exceeds the circular buffer of small windows
+    std::string large;
+    uint32_t seed = 1;
+    while(large.size() < 300000) {
+        seed = seed * 1103515245U + 12345U;
+        if(seed % 4 == 0 && large.size() > 1000) {
+            large += large.substr(large.size() - 1 - seed % 1000, 20 + seed % 50);
+        } else {
+            large.push_back('a' + (seed >> 16) % 8);
+        }
+    }
+    texts.push_back(large);
+
+    for(auto& text : texts) {
+        for(auto finder : { "naive", "hash", "bt" }) {
+            for(auto window : { "16", "4096" }) {
+                if(std::string(finder) == "naive" && text.size() > 1000) continue;
+                test::compress<compressor_t>(text,
+                    std::string("finder = \"") + finder + "\", window = " + window
+                ).assert_decompress();
+            }
+        }
+        test::compress<compressor_t>(text,
+            "window = 65536, lookahead = 258, finder = \"bt\""
+        ).assert_decompress();
+    }
+}
@@ -17,6 +17,7 @@ using namespace tdc_algorithms;
 
 const std::vector<std::string> EXCLUDED_TESTS {
     "chain",
+    "blocks",
 };
 const std::vector<std::string> ADDITIONAL_TESTS {
     // "chain(chain(chain(chain(easyrle(\"1\"),bwt()),mtf()),easyrle()),encode(huff))",
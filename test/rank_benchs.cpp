@@ -0,0 +1,150 @@
+#include <vector>
+
+#include <benchpress/benchpress.hpp>
+#include <sdsl/bit_vectors.hpp>
+#include <sdsl/rank_support_v5.hpp>
+
+#include <tudocomp/ds/IntVector.hpp>
+#include <tudocomp/ds/rank_64bit.hpp>
+#include <tudocomp/ds/Rank.hpp>
+
+using namespace tdc;
+using namespace benchpress;
+
+// large enough for the rank data structures to exceed the caches
+const size_t N_BITS = size_t(1) << 30;
+const size_t N_QUERIES = 1000000;
+
+static uint64_t next_random(uint64_t& seed) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return seed >> 11;
+}
+
+// every bit is set with probability 1/2
+static const BitVector& bits() {
+    static BitVector bv = [] {
+        BitVector bv(N_BITS);
+        uint64_t seed = 1;
+        const size_t num_words = idiv_ceil(N_BITS, 64);
+        for(size_t i = 0; i < num_words; ++i) {
+            bv.data()[i] = next_random(seed) ^ (next_random(seed) << 32);
+        }
+        return bv;
+    }();
+    return bv;
+}
+
+static const std::vector<size_t>& queries() {
+    static std::vector<size_t> q = [] {
+        std::vector<size_t> q(N_QUERIES);
+        uint64_t seed = 2;
+        for(auto& x : q) x = next_random(seed) % N_BITS;
+        return q;
+    }();
+    return q;
+}
+
+/// The block / superblock layout \ref Rank used before, with separate arrays
+/// for the counters and word-wise popcounts via \c rank_64bit.hpp.
+class BlockRank {
+    static constexpr size_t block_size = 64;
+    static constexpr size_t supblock_size = block_size * block_size;
+
+    const BitVector* m_bv;
+    DynamicIntVector m_blocks;
+    DynamicIntVector m_supblocks;
+
+public:
+    inline BlockRank(const BitVector& bv) : m_bv(&bv) {
+        const size_t n = bv.size();
+        const size_t num_blocks = idiv_ceil(n, block_size);
+        m_supblocks = DynamicIntVector(idiv_ceil(n, supblock_size), 0, bits_for(n));
+        m_blocks = DynamicIntVector(num_blocks, 0, bits_for(supblock_size));
+
+        size_t rank_bv = 0, rank_sb = 0;
+        for(size_t j = 0; j < num_blocks; j++) {
+            if(j > 0 && j % (supblock_size / block_size) == 0) {
+                m_supblocks[j / (supblock_size / block_size) - 1] = rank_bv;
+                rank_sb = 0;
+            }
+            auto rank_b = tdc::rank1(bv.data()[j]);
+            rank_sb += rank_b;
+            rank_bv += rank_b;
+            m_blocks[j] = rank_sb;
+        }
+    }
+
+    inline size_t rank1(size_t x) const {
+        size_t r = 0;
+        size_t i = x / supblock_size;
+        if(i > 0) r += m_supblocks[i-1];
+        size_t j = x / block_size;
+        if(j - i * (supblock_size / block_size) > 0) r += m_blocks[j-1];
+        return r + tdc::rank1(m_bv->data()[j], x % block_size);
+    }
+};
+
+// each iteration answers N_QUERIES queries at random positions
+template<class rank_t>
+inline void rank_bench(benchpress::context* ctx) {
+    const rank_t rank(bits());
+    const auto& q = queries();
+    size_t sum = 0;
+
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        for(size_t x : q) sum += rank.rank1(x);
+        escape(&sum);
+    }
+}
+
+inline void sdsl_rank_bench(benchpress::context* ctx) {
+    sdsl::bit_vector bv(N_BITS);
+    std::copy(bits().data(), bits().data() + idiv_ceil(N_BITS, 64), bv.data());
+    const sdsl::rank_support_v5<> rank(&bv);
+    const auto& q = queries();
+    size_t sum = 0;
+
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        // sdsl counts the 1-bits before the position
+        for(size_t x : q) sum += rank(x + 1);
+        escape(&sum);
+    }
+}
+
+inline void sdsl_rank_chain_bench(benchpress::context* ctx) {
+    sdsl::bit_vector bv(N_BITS);
+    std::copy(bits().data(), bits().data() + idiv_ceil(N_BITS, 64), bv.data());
+    const sdsl::rank_support_v5<> rank(&bv);
+    const auto& q = queries();
+    size_t r = 0;
+
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        for(size_t x : q) r = rank((x + r) % N_BITS + 1);
+        escape(&r);
+    }
+}
+
+// each iteration answers N_QUERIES queries, where each query position
+// depends on the previous result, so that the latencies add up
+template<class rank_t>
+inline void rank_chain_bench(benchpress::context* ctx) {
+    const rank_t rank(bits());
+    const auto& q = queries();
+    size_t r = 0;
+
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        for(size_t x : q) r = rank.rank1((x + r) % N_BITS);
+        escape(&r);
+    }
+}
+
+BENCHMARK("rank::interleaved", rank_bench<Rank>)
+BENCHMARK("rank::blocks", rank_bench<BlockRank>)
+BENCHMARK("rank::sdsl_v5", sdsl_rank_bench)
+BENCHMARK("rank_chain::interleaved", rank_chain_bench<Rank>)
+BENCHMARK("rank_chain::blocks", rank_chain_bench<BlockRank>)
+BENCHMARK("rank_chain::sdsl_v5", sdsl_rank_chain_bench)
@@ -158,6 +158,19 @@ TEST(select, ranged) {
     }
 }
 
+TEST(select, word) {
+    // compare against the generic bitwise approach
+    uint64_t seed = 1;
+    for(size_t i = 0; i < 10000; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint64_t v = seed & (seed >> (i % 64)); // vary the density
+        for(uint8_t k = 1; k <= 65; k++) {
+            ASSERT_EQ(select1<uint64_t>(v, k), select1(v, k)) << "v=" << v << ", k=" << int(k);
+            ASSERT_EQ(select0<uint64_t>(v, k), select0(v, k)) << "v=" << v << ", k=" << int(k);
+        }
+    }
+}
+
 TEST(rank_select, inverse_property_64bit) {
     uint64_t v64 = 0x0101010101010101ULL;
 
@@ -205,6 +218,30 @@ TEST(rank, bv) {
     });
 }
 
+TEST(rank, lines) {
+    // sizes around the bits stored in a cache line
+    for(size_t n : {1, 63, 64, 447, 448, 449, 895, 896, 10000}) {
+        BitVector bv(n);
+        uint64_t seed = n;
+        for(size_t i = 0; i < n; i++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            bv[i] = (seed >> 62) & 1;
+        }
+
+        Rank rank(bv);
+        Rank copy(rank);
+        Rank moved(std::move(copy));
+
+        size_t r = 0;
+        for(size_t i = 0; i < n; i++) {
+            r += bv[i];
+            ASSERT_EQ(r, rank.rank1(i)) << "n=" << n << ", i=" << i;
+            ASSERT_EQ(r, moved.rank1(i));
+            ASSERT_EQ(i + 1 - r, rank.rank0(i));
+        }
+    }
+}
+
 TEST(select, bv) {
     NK_test([](size_t N, size_t K){
         // select1
@@ -238,6 +275,56 @@ TEST(select, bv) {
     });
 }
 
+TEST(select, sampled) {
+    // dense and sparse vectors, the latter with long runs of unflagged lines
+    for(size_t shift : {1, 4, 12}) {
+        for(size_t n : {1, 447, 449, 100000}) {
+            BitVector bv(n);
+            uint64_t seed = n + shift;
+            for(size_t i = 0; i < n; i++) {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                bv[i] = (seed >> (64 - shift)) == 0;
+            }
+
+            Select1 select1(bv);
+            Select0 select0(bv);
+            size_t ones = 0, zeros = 0;
+            for(size_t i = 0; i < n; i++) {
+                if(bv[i]) {
+                    ASSERT_EQ(i, select1(++ones)) << "n=" << n << ", i=" << i;
+                } else {
+                    ASSERT_EQ(i, select0(++zeros)) << "n=" << n << ", i=" << i;
+                }
+            }
+            ASSERT_EQ(n, select1(ones + 1));
+            ASSERT_EQ(n, select0(zeros + 1));
+        }
+    }
+}
+
+TEST(select, long_blocks) {
+    // a dense half followed by a sparse half, where samples lie far apart
+    const size_t n = 1 << 21;
+    for(bool flip : {false, true}) {
+        BitVector bv(n, flip);
+        for(size_t i = 0; i < n / 2; i += 3) bv[i] = !flip;
+        for(size_t i = n / 2; i < n; i += 700) bv[i] = !flip;
+
+        Select1 select1(bv);
+        Select0 select0(bv);
+        size_t ones = 0, zeros = 0;
+        for(size_t i = 0; i < n; i++) {
+            if(bv[i]) {
+                ASSERT_EQ(i, select1(++ones)) << "flip=" << flip << ", i=" << i;
+            } else {
+                ASSERT_EQ(i, select0(++zeros)) << "flip=" << flip << ", i=" << i;
+            }
+        }
+        ASSERT_EQ(n, select1(ones + 1));
+        ASSERT_EQ(n, select0(zeros + 1));
+    }
+}
+
 TEST(rank_select, inverse_property_bv) {
     NK_test([](size_t N, size_t K){
         //1
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <random>
+
+#include "test/util.hpp"
+#include <tudocomp/Literal.hpp>
+#include <tudocomp/CreateAlgorithm.hpp>
+#include <tudocomp/coders/BitCoder.hpp>
+#include <tudocomp/coders/HuffmanCoder.hpp>
+#include <tudocomp/coders/RANSCoder.hpp>
+#include <tudocomp/compressors/LiteralEncoder.hpp>
+#include <tudocomp/compressors/LZSSLCPCompressor.hpp>
+
+using namespace tdc;
+
+/// values of the form (range, value), encoded in order
+using values_t = std::vector<std::pair<Range, uint64_t>>;
+
+std::string test_rans(const values_t& values, const std::string& options = "") {
+    //encode
+    std::stringstream output;
+    {
+        tdc::io::Output out(output);
+        RANSCoder::Encoder encoder(create_env(RANSCoder::meta(), options), out, NoLiterals());
+        for(const auto& v : values) {
+            encoder.encode(v.second, v.first);
+        }
+    }
+
+    //decode
+    const std::string encoded = output.str();
+    {
+        tdc::io::Input in(encoded);
+        RANSCoder::Decoder decoder(create_env(RANSCoder::meta(), options), in);
+        for(size_t i = 0; i < values.size(); ++i) {
+            EXPECT_FALSE(decoder.eof());
+            EXPECT_EQ(values[i].second, decoder.template decode<uint64_t>(values[i].first)) << "i=" << i;
+        }
+        EXPECT_TRUE(decoder.eof());
+    }
+    return encoded;
+}
+
+/// geometrically distributed values in a range
+values_t geometric_values(const Range& r, const size_t n, const double p, const size_t seed) {
+    std::mt19937 rng(seed);
+    std::geometric_distribution<uint64_t> dist(p);
+    values_t values;
+    for(size_t i = 0; i < n; ++i) {
+        values.emplace_back(r, std::min<uint64_t>(r.min() + dist(rng), r.max()));
+    }
+    return values;
+}
+
+TEST(rans, single) {
+    test_rans({});
+    test_rans({{literal_r, 'a'}});
+    test_rans({{Range(0, 0), 0}});
+    test_rans({{size_r, 0}});
+    test_rans({{size_r, 1ULL << 40}});
+}
+
+TEST(rans, literals) {
+    values_t values;
+    for(const char c : "abracadabra\0\xFF"_v) values.emplace_back(literal_r, uliteral_t(c));
+    test_rans(values);
+
+    for(size_t i = 0; i < 10000; ++i) values.emplace_back(literal_r, (i * i) % 256);
+    test_rans(values);
+}
+
+TEST(rans, large_values) {
+    const Range len(1ULL << 32);
+    values_t values;
+    std::mt19937_64 rng(1);
+    for(size_t i = 0; i < 1000; ++i) {
+        values.emplace_back(size_r, rng());
+        values.emplace_back(len, rng() >> (i % 64) & len.max());
+        values.emplace_back(MinDistributedRange(100, 1ULL << 50), 100 + (rng() >> 14));
+    }
+    values.emplace_back(size_r, ~uint64_t(0));
+    values.emplace_back(size_r, 0);
+    test_rans(values);
+}
+
+TEST(rans, states) {
+    // interleaved ranges
+    values_t values;
+    const values_t a = geometric_values(Range(1000), 10000, 0.05, 1);
+    const values_t b = geometric_values(MinDistributedRange(3, 100000), 10000, 0.01, 2);
+    for(size_t i = 0; i < a.size(); ++i) {
+        values.push_back(a[i]);
+        if(i % 3 == 0) values.emplace_back(bit_r, i % 2);
+        values.push_back(b[i]);
+    }
+
+    for(const std::string states : {"1", "2", "3", "4", "16", "100"}) {
+        test_rans(values, "states = " + states);
+    }
+}
+
+TEST(rans, ratio) {
+    // skewed values are coded with far less bits than the binary code
+    const Range r(1ULL << 20);
+    const values_t values = geometric_values(r, 100000, 0.1, 3);
+    const size_t rans = test_rans(values).size();
+    ASSERT_LT(rans, values.size() * 20 / 8 / 3);
+}
+
+TEST(rans, compressors) {
+    std::mt19937 rng(4);
+    std::string text;
+    for(size_t i = 0; i < 2000; ++i) {
+        // repetitions of random length at random distance, interspersed
+        // with literals
+        const size_t len = 3 + rng() % 20;
+        if(text.size() > len && rng() % 4 != 0) {
+            text += text.substr(rng() % (text.size() - len), len);
+        } else {
+            for(size_t j = 0; j < len; ++j) text.push_back(char('a' + rng() % 20));
+        }
+    }
+
+    test::compress<LiteralEncoder<RANSCoder>>(text, "").assert_decompress();
+    test::compress<LiteralEncoder<RANSCoder>>("", "").assert_decompress();
+    test::compress<LiteralEncoder<RANSCoder>>("a", "").assert_decompress();
+
+    auto rans = test::compress<LZSSLCPCompressor<RANSCoder>>(text, "");
+    rans.assert_decompress();
+    auto bit = test::compress<LZSSLCPCompressor<BitCoder>>(text, "");
+    auto huff = test::compress<LZSSLCPCompressor<HuffmanCoder>>(text, "");
+    ASSERT_LT(rans.str.size(), bit.str.size());
+    ASSERT_LT(rans.str.size(), huff.str.size());
+}
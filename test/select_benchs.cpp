@@ -0,0 +1,96 @@
+#include <vector>
+
+#include <benchpress/benchpress.hpp>
+#include <sdsl/bit_vectors.hpp>
+#include <sdsl/select_support_mcl.hpp>
+
+#include <tudocomp/ds/IntVector.hpp>
+#include <tudocomp/ds/select_64bit.hpp>
+#include <tudocomp/ds/Select.hpp>
+
+using namespace tdc;
+using namespace benchpress;
+
+// large enough for the select data structures to exceed the caches
+const size_t N_BITS = size_t(1) << 30;
+const size_t N_QUERIES = 1000000;
+
+static uint64_t next_random(uint64_t& seed) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return seed >> 11;
+}
+
+// every bit is set with probability 1/2, like in the PLCP bit vector
+static BitVector& bits() {
+    static BitVector bv = [] {
+        BitVector bv(N_BITS);
+        uint64_t seed = 1;
+        const size_t num_words = idiv_ceil(N_BITS, 64);
+        for(size_t i = 0; i < num_words; ++i) {
+            bv.data()[i] = next_random(seed) ^ (next_random(seed) << 32);
+        }
+        return bv;
+    }();
+    return bv;
+}
+
+// orders of 1-bits, which exist if about half of the bits are set
+static const std::vector<size_t>& queries() {
+    static std::vector<size_t> q = [] {
+        std::vector<size_t> q(N_QUERIES);
+        uint64_t seed = 2;
+        for(auto& x : q) x = 1 + next_random(seed) % (N_BITS / 4);
+        return q;
+    }();
+    return q;
+}
+
+// each iteration answers N_QUERIES queries for random orders
+inline void select_bench(benchpress::context* ctx) {
+    const Select1 select(bits());
+    const auto& q = queries();
+    size_t sum = 0;
+
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        for(size_t x : q) sum += select(x);
+        escape(&sum);
+    }
+}
+
+inline void sdsl_select_bench(benchpress::context* ctx) {
+    sdsl::bit_vector bv(N_BITS);
+    std::copy(bits().data(), bits().data() + idiv_ceil(N_BITS, 64), bv.data());
+    const sdsl::select_support_mcl<1, 1> select(&bv);
+    const auto& q = queries();
+    size_t sum = 0;
+
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        for(size_t x : q) sum += select.select(x);
+        escape(&sum);
+    }
+}
+
+// each iteration selects within N_QUERIES words
+template<bool m_generic>
+inline void select_word_bench(benchpress::context* ctx) {
+    const auto& q = queries();
+    const uint64_t* data = bits().data();
+    size_t sum = 0;
+
+    ctx->reset_timer();
+    for (size_t i = 0; i < ctx->num_iterations(); ++i) {
+        for(size_t j = 0; j < q.size(); ++j) {
+            const uint64_t v = data[j] | 1;
+            const uint8_t k = 1 + q[j] % rank1(v);
+            sum += m_generic ? select1<uint64_t>(v, k) : select1(v, k);
+        }
+        escape(&sum);
+    }
+}
+
+BENCHMARK("select::sampled", select_bench)
+BENCHMARK("select::sdsl_mcl", sdsl_select_bench)
+BENCHMARK("select_word::uint64_t", select_word_bench<false>)
+BENCHMARK("select_word::generic", select_word_bench<true>)
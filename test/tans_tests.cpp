@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <random>
+
+#include "test/util.hpp"
+#include <tudocomp/Literal.hpp>
+#include <tudocomp/CreateAlgorithm.hpp>
+#include <tudocomp/coders/HuffmanCoder.hpp>
+#include <tudocomp/coders/TANSCoder.hpp>
+#include <tudocomp/compressors/LiteralEncoder.hpp>
+#include <tudocomp/compressors/LZSSLCPCompressor.hpp>
+
+using namespace tdc;
+
+std::string test_tans(const std::string& text, const std::string& options = "") {
+    //encode
+    std::stringstream output;
+    {
+        tdc::io::Output out(output);
+        TANSCoder::Encoder encoder(create_env(TANSCoder::meta(), options), out, ViewLiterals(text));
+        for(const char c : text) {
+            encoder.encode(uliteral_t(c), tdc::literal_r);
+        }
+    }
+
+    //decode
+    const std::string encoded = output.str();
+    std::string decoded;
+    {
+        tdc::io::Input in(encoded);
+        TANSCoder::Decoder decoder(create_env(TANSCoder::meta(), options), in);
+        while(!decoder.eof()) {
+            decoded.push_back(decoder.template decode<uliteral_t>(literal_r));
+        }
+    }
+    EXPECT_EQ(decoded, text);
+    return encoded;
+}
+
+/// text of n characters from an alphabet of sigma characters, with
+/// geometrically decreasing probabilities of ratio q
+std::string skewed_text(const size_t n, const size_t sigma, const double q, const size_t seed) {
+    std::vector<double> weights(sigma);
+    double w = 1;
+    for(auto& x : weights) { x = w; w *= q; }
+    std::mt19937 rng(seed);
+    std::discrete_distribution<size_t> dist(weights.begin(), weights.end());
+    std::string text(n, 0);
+    for(auto& c : text) c = char('a' + dist(rng));
+    return text;
+}
+
+TEST(tans, nullbyte) {
+    test_tans("hel\0lo"_v);
+    test_tans("hello\0"_v);
+    test_tans("hello\0\0\0"_v);
+}
+
+TEST(tans, stringgenerators) {
+    std::function<void(std::string&)> func([](std::string& s) { test_tans(s); });
+    test::on_string_generators(func,20);
+}
+
+// inputs of a few bytes, whose last refills read from the padding after
+// the bits (meant to run with ASan)
+TEST(tans, short_texts) {
+    const std::string text = "abacabadabacabaeabacabadabacabaf";
+    for(size_t n = 1; n <= text.size(); ++n) {
+        test_tans(text.substr(0, n));
+    }
+}
+
+TEST(tans, table_log) {
+    const std::string text = skewed_text(100000, 26, 0.7, 1);
+    for(const std::string table_log : {"1", "5", "8", "11", "16", "20"}) {
+        test_tans(text, "table_log = " + table_log);
+    }
+
+    // all byte values
+    std::string bytes;
+    for(size_t i = 0; i < 10000; ++i) bytes.push_back(char((i * i) % 256));
+    test_tans(bytes, "table_log = 5");
+    test_tans(bytes);
+}
+
+TEST(tans, ratio) {
+    // with probabilities far from powers of two, tANS gets close to the
+    // entropy, whereas Huffman codes need at least one bit per character
+    const std::string text = skewed_text(100000, 3, 0.1, 2);
+    const size_t tans = test_tans(text).size();
+    const size_t huff = test::compress<LiteralEncoder<HuffmanCoder>>(text, "").str.size();
+
+    // empirical entropy of about 0.57 bits per character
+    ASSERT_LT(tans, 0.6 * text.size() / 8);
+    ASSERT_LT(tans, 0.6 * huff);
+}
+
+TEST(tans, compressors) {
+    const std::string text = skewed_text(20000, 10, 0.5, 3) + "abcabcabc" + skewed_text(20000, 10, 0.5, 3);
+    test::compress<LiteralEncoder<TANSCoder>>(text, "").assert_decompress();
+    test::compress<LiteralEncoder<TANSCoder>>("a", "").assert_decompress();
+    test::compress<LZSSLCPCompressor<TANSCoder>>(text, "").assert_decompress();
+}
@@ -284,6 +284,41 @@ inline std::vector<uint8_t> pack_integers(std::vector<uint64_t> ints) {
     return bits;
 }
 
+/// Returns a text of at least \c n characters listing the numbers
+/// 0, 1, 2, ... modulo \c modulus, separated by spaces and every seventh
+/// number by a newline.
+inline std::string number_text(size_t n, size_t modulus) {
+    std::string text;
+    for(size_t i = 0; text.size() < n; ++i) {
+        text += std::to_string(i % modulus) + ((i % 7 == 0) ? "\n" : " ");
+    }
+    return text;
+}
+
+/// Returns a text of at least \c n characters of pseudo-random numbers
+/// below \c modulus, separated by spaces and about every eighth number by a
+/// newline. Equal seeds give equal texts.
+inline std::string random_number_text(size_t n, size_t modulus, uint32_t seed = 1) {
+    std::string text;
+    for(uint32_t x = seed; text.size() < n;) {
+        x = x * 1103515245 + 12345;
+        text += std::to_string((x >> 16) % modulus) + ((x & 0x700) ? " " : "\n");
+    }
+    return text;
+}
+
+/// Returns a text of \c n pseudo-random characters drawn from \c alphabet.
+/// Equal seeds give equal texts.
+inline std::string random_text(size_t n, const std::string& alphabet, uint32_t seed = 1) {
+    std::string text(n, 0);
+    uint32_t x = seed;
+    for(auto& c : text) {
+        x = x * 1103515245 + 12345;
+        c = alphabet[(x >> 16) % alphabet.size()];
+    }
+    return text;
+}
+
 std::string format_diff(const std::string& a, const std::string& b) {
     std::string diff;
     for(size_t i = 0; i < std::max(a.size(), b.size()); i++) {
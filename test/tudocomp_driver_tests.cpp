@@ -8,6 +8,7 @@
 
 #include <tudocomp/AlgorithmStringParser.hpp>
 #include <tudocomp/Env.hpp>
+#include <tudocomp_driver/BlockCompressor.hpp>
 #include <tudocomp_driver/Registry.hpp>
 
 #include "test/util.hpp"
@@ -48,6 +49,139 @@ TEST(TudocompDriver, algorithm_header) {
 
 }
 
+TEST(TudocompDriver, blocks) {
+    std::string text = "abcabcabcabcabcabcabcabcabc"
+                       "aaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                       "abcdefghijklmnopqrstuvwxyz";
+    bool abort = false;
+
+    driver_test::roundtrip("blocks(lz78(ascii), block_size = \"7\", threads = \"3\")",
+        "_blocks_test_0", text, false, abort).check();
+    driver_test::roundtrip("blocks(lzss_lcp(bit), block_size = \"16\", threads = \"2\")",
+        "_blocks_test_1", text, false, abort).check();
+    driver_test::roundtrip("blocks(bwt:rle:mtf, block_size = \"1000\")",
+        "_blocks_test_2", text, false, abort).check();
+    driver_test::roundtrip("blocks(noop, block_size = \"5\", threads = \"4\")",
+        "_blocks_test_3", "", false, abort).check();
+
+    ASSERT_FALSE(abort);
+}
+
+TEST(TudocompDriver, chain_pipeline) {
+    std::string text = "abcabcabcabcabcabcabcabcabc"
+                       "aaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                       "abcdefghijklmnopqrstuvwxyz";
+    bool abort = false;
+
+    driver_test::roundtrip("chain(bwt, rle, queue_size = \"1\")",
+        "_chain_test_0", text, false, abort).check();
+    driver_test::roundtrip("chain(bwt, rle, queue_size = \"0\")",
+        "_chain_test_1", text, false, abort).check();
+    driver_test::roundtrip("rle:mtf:lzss_lcp(bit)",
+        "_chain_test_2", text, false, abort).check();
+    driver_test::roundtrip("rle:mtf",
+        "_chain_test_3", "", false, abort).check();
+
+    ASSERT_FALSE(abort);
+}
+
+TEST(TudocompDriver, decompress_range) {
+    using namespace tdc_algorithms;
+    Registry<Compressor>& r = COMPRESSOR_REGISTRY;
+
+    std::string text;
+    for(size_t i = 0; i < 1000; ++i) {
+        text.push_back('a' + (i * i + i / 7) % 26);
+    }
+
+    auto check = [&](const std::string& algo) {
+        std::vector<uint8_t> compressed;
+        {
+            auto av = r.parse_algorithm_id(algo);
+            auto flags = av.textds_flags();
+            auto c = r.select_algorithm(av);
+            Input inp(text);
+            if(flags.has_restrictions()) {
+                inp = Input(inp, flags);
+            }
+            Output out(compressed);
+            c->compress(inp, out);
+        }
+
+        std::vector<std::pair<size_t, size_t>> ranges {
+            {0, 0}, {0, 1}, {0, 37}, {36, 37}, {37, 74}, {10, 500},
+            {999, 1000}, {0, 1000}, {950, 5000}, {1000, 1000}, {2000, 3000},
+        };
+        for(auto& range : ranges) {
+            auto c = r.select(algo);
+            std::vector<uint8_t> decompressed;
+            Input inp(compressed);
+            Output out(decompressed);
+            decompress_range(*c, inp, range.first, range.second, out);
+
+            const size_t from = std::min(range.first, text.size());
+            const size_t to = std::min(range.second, text.size());
+            ASSERT_EQ(View(decompressed), View(text).slice(from, to))
+                << algo << " [" << range.first << ", " << range.second << ")";
+        }
+    };
+
+    check("blocks(lz78(ascii), block_size = \"37\", threads = \"3\")");
+    check("blocks(lzss_lcp(bit), block_size = \"1000\")");
+    check("blocks(lzss_lcp(bit), block_size = \"2000\")");
+    check("lzss_lcp(bit)");
+}
+
+TEST(Registry, order_preserving_coders) {
+    using namespace tdc_algorithms;
+    Registry<Compressor>& r = COMPRESSOR_REGISTRY;
+
+    // coders that code the literals of the literal iterator in advance are
+    // not offered to compressors that encode literals in a different order
+    for(const std::string algo : {
+            "repair(huff_streams)",
+            "repair(tans)",
+            "lz78u(buffering(huff_streams), ascii)",
+            "lz78u(buffering(tans), ascii)"}) {
+        ASSERT_THROW(r.select(algo), std::runtime_error) << algo;
+    }
+
+    const std::string text = "abracadabra abracadabra cadabra abra, "
+        "abrakadabra abracadabra, abraka";
+    for(const std::string algo : {
+            "repair(huff)",
+            "lz78u(buffering(huff), ascii)",
+            "encode(huff_streams(streams = \"4\"))",
+            "lzss_lcp(huff_streams(streams = \"3\"))",
+            "lcpcomp(huff_streams)"}) {
+        auto av = r.parse_algorithm_id(algo);
+        auto flags = av.textds_flags();
+
+        std::vector<uint8_t> compressed;
+        {
+            auto c = r.select_algorithm(av);
+            Input inp(text);
+            if(flags.has_restrictions()) {
+                inp = Input(inp, flags);
+            }
+            Output out(compressed);
+            c->compress(inp, out);
+        }
+
+        std::vector<uint8_t> decompressed;
+        {
+            auto c = r.select_algorithm(av);
+            Input inp(compressed);
+            Output out(decompressed);
+            if(flags.has_restrictions()) {
+                out = Output(out, flags);
+            }
+            c->decompress(inp, out);
+        }
+        ASSERT_EQ(View(decompressed), View(text)) << algo;
+    }
+}
+
 TEST(Registry, smoketest) {
     using namespace tdc_algorithms;
     using ast::Value;
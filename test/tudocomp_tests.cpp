@@ -11,6 +11,7 @@
 #include <tudocomp/util.hpp>
 #include <tudocomp/util/View.hpp>
 #include <tudocomp/util/GenericView.hpp>
+#include <tudocomp/util/Parallel.hpp>
 #include <tudocomp/Compressor.hpp>
 #include <tudocomp/Algorithm.hpp>
 #include <tudocomp/CreateAlgorithm.hpp>
@@ -86,6 +87,15 @@ TEST(Util, bits_for) {
     ASSERT_EQ(bits_for(0b111111111), 9u);
 }
 
+TEST(Util, index_width) {
+    ASSERT_EQ(index_width(0), 32u);
+    ASSERT_EQ(index_width(0xFFFFFFFFULL), 32u);
+    ASSERT_EQ(index_width(0x100000000ULL), 40u);
+    ASSERT_EQ(index_width(0xFFFFFFFFFFULL), 40u);
+    ASSERT_EQ(index_width(0x10000000000ULL), 64u);
+    ASSERT_EQ(index_width(SIZE_MAX), 64u);
+}
+
 TEST(Util, bytes_for) {
     ASSERT_EQ(bytes_for(0x00), 1u);
 
@@ -142,6 +152,40 @@ TEST(Util, pack_integers) {
     }));
 }
 
+TEST(Util, parallel_for_ordered) {
+    const size_t n = 1000;
+    std::vector<size_t> results(n);
+    std::vector<size_t> emitted;
+
+    parallel_for_ordered(n, 4, 8,
+        [&](size_t i) { results[i] = i * i; },
+        [&](size_t i) { emitted.push_back(results[i]); });
+
+    ASSERT_EQ(emitted.size(), n);
+    for(size_t i = 0; i < n; i++) {
+        ASSERT_EQ(emitted[i], i * i);
+    }
+
+    ASSERT_THROW(parallel_for_ordered(n, 4, 8,
+        [&](size_t i) { if(i == 500) throw std::runtime_error("fail"); },
+        [&](size_t) {}), std::runtime_error);
+}
+
+TEST(Util, parallel_sort) {
+    for(size_t n : {0, 1, 1000, 100000, 300001}) {
+        std::vector<size_t> v(n);
+        for(size_t i = 0; i < n; i++) v[i] = (i * 7919) % 1009;
+        std::vector<size_t> expected = v;
+        std::sort(expected.begin(), expected.end());
+
+        for(size_t threads : {1, 2, 3, 8}) {
+            std::vector<size_t> sorted = v;
+            parallel_sort(sorted.begin(), sorted.end(), std::less<size_t>(), threads);
+            ASSERT_EQ(sorted, expected) << "n=" << n << ", threads=" << threads;
+        }
+    }
+}
+
 TEST(Input, vector) {
     std::vector<uint8_t> v { 97, 98, 99 };
 
@@ -726,6 +770,108 @@ TEST(IO, bits_eof) {
     }
 }
 
+TEST(IO, bits_word_level) {
+    // random sequence of operations, checked against a plain bit sequence
+    enum Op { BIT, INT, UNARY, GAMMA, DELTA, COMPRESSED };
+    struct Item { Op op; uint64_t value; size_t bits; };
+
+    std::vector<Item> items;
+    std::vector<bool> ref;
+    auto ref_int = [&](uint64_t v, size_t bits) {
+        for(size_t i = bits; i > 0; --i) ref.push_back((v >> (i - 1)) & 1);
+    };
+    auto ref_unary = [&](uint64_t v) {
+        for(uint64_t i = 0; i < v; ++i) ref.push_back(0);
+        ref.push_back(1);
+    };
+    auto ref_gamma = [&](uint64_t v) {
+        ref_unary(bits_for(v));
+        ref_int(v, bits_for(v));
+    };
+
+    uint64_t seed = 17;
+    auto random = [&]() {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed >> 11;
+    };
+
+    // enough values to span several blocks of the stream buffers
+    for(size_t i = 0; i < 20000; ++i) {
+        const Op op = Op(random() % 6);
+        const size_t bits = random() % 65;
+        uint64_t v = random() ^ (random() << 40);
+        if(bits < 64) v &= (uint64_t(1) << bits) - 1;
+
+        switch(op) {
+            case BIT: v &= 1; ref.push_back(v); break;
+            case INT: ref_int(v, bits); break;
+            case UNARY: v %= 150; ref_unary(v); break;
+            case GAMMA: ref_gamma(v); break;
+            case DELTA: ref_gamma(bits_for(v)); ref_int(v, bits_for(v)); break;
+            case COMPRESSED: {
+                v &= 0xFFFFFF;
+                uint64_t u = v;
+                do {
+                    const uint64_t current = u & 0x7F;
+                    u >>= 7;
+                    ref.push_back(u > 0);
+                    ref_int(current, 7);
+                } while(u > 0);
+                break;
+            }
+        }
+        items.push_back(Item { op, v, bits });
+    }
+
+    std::string result;
+    {
+        std::ostringstream ss_result;
+        {
+            Output output(ss_result);
+            BitOStream out(output);
+            for(auto& item : items) {
+                switch(item.op) {
+                    case BIT: out.write_bit(item.value); break;
+                    case INT: out.write_int(item.value, item.bits); break;
+                    case UNARY: out.write_unary(item.value); break;
+                    case GAMMA: out.write_elias_gamma(item.value); break;
+                    case DELTA: out.write_elias_delta(item.value); break;
+                    case COMPRESSED: out.write_compressed_int(item.value); break;
+                }
+            }
+            ASSERT_EQ(ref.size() / 8, size_t(out.tellp()));
+        }
+        result = ss_result.str();
+    }
+
+    // expected bytes: the bits, padded, and the amount of bits in the last
+    // byte in its lowest three bits or in an extra byte
+    std::string expected((ref.size() + 7) / 8, 0);
+    for(size_t i = 0; i < ref.size(); ++i) {
+        if(ref[i]) expected[i / 8] |= char(0x80 >> (i % 8));
+    }
+    const size_t set = ref.size() % 8;
+    if(set == 0) expected.push_back(0);
+    else if(set <= 5) expected.back() |= char(set);
+    else expected.push_back(char(set));
+    ASSERT_EQ(expected, result);
+
+    Input input(result);
+    BitIStream in(input);
+    for(auto& item : items) {
+        switch(item.op) {
+            case BIT: ASSERT_EQ(item.value, in.read_bit()); break;
+            case INT: ASSERT_EQ(item.value, in.read_int<uint64_t>(item.bits)); break;
+            case UNARY: ASSERT_EQ(item.value, in.read_unary<uint64_t>()); break;
+            case GAMMA: ASSERT_EQ(item.value, in.read_elias_gamma<uint64_t>()); break;
+            case DELTA: ASSERT_EQ(item.value, in.read_elias_delta<uint64_t>()); break;
+            case COMPRESSED: ASSERT_EQ(item.value, in.read_compressed_int<uint64_t>()); break;
+        }
+    }
+    ASSERT_TRUE(in.eof());
+    ASSERT_EQ(0, in.read_int<uint64_t>(64));
+}
+
 TEST(View, construction) {
     static const uint8_t DATA[3] = { 'f', 'o', 'o' };
 
@@ -950,6 +1096,34 @@ TEST(View, slice_vs_substr) {
     ASSERT_EQ(a.slice(3, 5), a.substr(3, 2));
 }
 
+TEST(View, lce) {
+    View a("abcabcabx");
+    ASSERT_EQ(lce(a, 0, 3), 5u);
+    ASSERT_EQ(lce(a, 0, 3, 2), 2u);
+    ASSERT_EQ(lce(a, 0, 6), 2u);
+    ASSERT_EQ(lce(a, 1, 2), 0u);
+    ASSERT_EQ(lce(a, 4, 4), 5u);
+    ASSERT_EQ(lce(a, 0, 9), 0u);
+
+    // compare against a naive scan at all offsets and lengths around the
+    // word boundaries
+    std::string text;
+    for(uint32_t x = 1; text.size() < 1000;) {
+        x = x * 1103515245 + 12345;
+        text += std::string((x >> 8) % 100, 'a') + char('b' + (x >> 24) % 2);
+    }
+    View t(text);
+    for(size_t i = 0; i < 300; ++i) {
+        for(size_t j = 0; j < 300; ++j) {
+            size_t expected = 0;
+            while(std::max(i, j) + expected < t.size() &&
+                  t[i + expected] == t[j + expected]) ++expected;
+            ASSERT_EQ(lce(t, i, j), expected) << "i=" << i << ", j=" << j;
+            ASSERT_EQ(lce(t, i, j, 37), std::min<size_t>(expected, 37));
+        }
+    }
+}
+
 TEST(View, string_predicates) {
     View a("abc");
     View aa("abcabc");